@@ -0,0 +1,201 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef LIVOX_BENCHMARK_MID360_FRAMES_H_
+#define LIVOX_BENCHMARK_MID360_FRAMES_H_
+
+// Mid-360 point and IMU frames sent from an emulated lidar, shared by the benchmark targets.
+
+#include "livox_lidar_def.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace livox {
+namespace lidar {
+namespace benchmark {
+
+// The default ports of a Mid-360 and of the host it sends to.
+static const uint16_t kMid360PointPort = 56300;
+static const uint16_t kMid360ImuPort = 56400;
+static const uint16_t kHostPointPort = 56301;
+static const uint16_t kHostImuPort = 56401;
+
+static const size_t kFrameHeaderSize = offsetof(LivoxLidarEthernetPacket, data);
+static const uint16_t kPointsPerFrame = 96;
+static const size_t kPointFrameSize = kFrameHeaderSize + kPointsPerFrame * sizeof(LivoxLidarCartesianHighRawPoint);
+static const size_t kImuFrameSize = kFrameHeaderSize + sizeof(LivoxLidarImuRawPoint);
+// 200 Hz of IMU next to about 2000 point frames a second.
+static const uint32_t kPointFramesPerImuFrame = 10;
+
+/** Fills a frame header, timestamp is in ns. */
+inline void FillFrameHeader(LivoxLidarEthernetPacket* frame, uint8_t data_type, uint16_t length, uint16_t dot_num,
+                            uint16_t udp_cnt, uint64_t timestamp) {
+  memset(frame, 0, kFrameHeaderSize);
+  frame->version = 0;
+  frame->length = length;
+  frame->time_interval = (data_type == kLivoxLidarImuData) ? 0 : 5;
+  frame->dot_num = dot_num;
+  frame->udp_cnt = udp_cnt;
+  frame->data_type = data_type;
+  for (int i = 0; i < 8; ++i) {
+    frame->timestamp[i] = static_cast<uint8_t>(timestamp >> (8 * i));
+  }
+}
+
+/** A frame of kPointsPerFrame high cartesian points, buf holds kPointFrameSize bytes. */
+inline void BuildPointFrame(uint8_t* buf, uint16_t udp_cnt, uint64_t timestamp) {
+  LivoxLidarEthernetPacket* frame = reinterpret_cast<LivoxLidarEthernetPacket*>(buf);
+  FillFrameHeader(frame, kLivoxLidarCartesianCoordinateHighData, static_cast<uint16_t>(kPointFrameSize),
+                  kPointsPerFrame, udp_cnt, timestamp);
+  LivoxLidarCartesianHighRawPoint* points = reinterpret_cast<LivoxLidarCartesianHighRawPoint*>(frame->data);
+  for (uint16_t i = 0; i < kPointsPerFrame; ++i) {
+    points[i].x = 1000 + i;
+    points[i].y = -500 + i;
+    points[i].z = 200;
+    points[i].reflectivity = static_cast<uint8_t>(i);
+    points[i].tag = 0;
+  }
+}
+
+/** An IMU frame, buf holds kImuFrameSize bytes. */
+inline void BuildImuFrame(uint8_t* buf, uint16_t udp_cnt, uint64_t timestamp) {
+  LivoxLidarEthernetPacket* frame = reinterpret_cast<LivoxLidarEthernetPacket*>(buf);
+  FillFrameHeader(frame, kLivoxLidarImuData, static_cast<uint16_t>(kImuFrameSize), 1, udp_cnt, timestamp);
+  LivoxLidarImuRawPoint* imu = reinterpret_cast<LivoxLidarImuRawPoint*>(frame->data);
+  imu->gyro_x = 0.01f;
+  imu->gyro_y = -0.02f;
+  imu->gyro_z = 0.0f;
+  imu->acc_x = 0.0f;
+  imu->acc_y = 0.0f;
+  imu->acc_z = 1.0f;
+}
+
+inline uint64_t NowNs() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+#ifdef __linux__
+/** A udp socket bound to ip:port, port 0 picks one. -1 on failure. */
+inline int CreateBoundSocket(const char* ip, uint16_t port, bool nonblock) {
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock < 0) {
+    return -1;
+  }
+  int on = 1;
+  setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = inet_addr(ip);
+  addr.sin_port = htons(port);
+  if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+    close(sock);
+    return -1;
+  }
+  if (nonblock) {
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+  }
+  return sock;
+}
+
+/** The emulated lidar: a point and an IMU socket bound to the lidar ip and the Mid-360 ports. */
+class Mid360Sender {
+ public:
+  Mid360Sender() : point_sock_(-1), imu_sock_(-1), point_dst_(), imu_dst_(), point_cnt_(0), imu_cnt_(0) {}
+  ~Mid360Sender() {
+    if (point_sock_ >= 0) {
+      close(point_sock_);
+    }
+    if (imu_sock_ >= 0) {
+      close(imu_sock_);
+    }
+  }
+
+  bool Init(const char* lidar_ip, const char* host_ip, uint16_t host_point_port = kHostPointPort,
+            uint16_t host_imu_port = kHostImuPort) {
+    point_sock_ = CreateBoundSocket(lidar_ip, kMid360PointPort, false);
+    imu_sock_ = CreateBoundSocket(lidar_ip, kMid360ImuPort, false);
+    if (point_sock_ < 0 || imu_sock_ < 0) {
+      return false;
+    }
+    point_dst_.sin_family = AF_INET;
+    point_dst_.sin_addr.s_addr = inet_addr(host_ip);
+    point_dst_.sin_port = htons(host_point_port);
+    imu_dst_ = point_dst_;
+    imu_dst_.sin_port = htons(host_imu_port);
+    return true;
+  }
+
+  /** Sends the next point frame, and an IMU frame every kPointFramesPerImuFrame, false on a send error. */
+  bool Send() {
+    uint64_t timestamp = NowNs();
+    if (point_cnt_ % kPointFramesPerImuFrame == 0) {
+      BuildImuFrame(imu_buf_, static_cast<uint16_t>(imu_cnt_), timestamp);
+      if (sendto(imu_sock_, imu_buf_, kImuFrameSize, 0, (const struct sockaddr*)&imu_dst_, sizeof(imu_dst_)) < 0) {
+        return false;
+      }
+      ++imu_cnt_;
+    }
+    BuildPointFrame(point_buf_, static_cast<uint16_t>(point_cnt_), timestamp);
+    if (sendto(point_sock_, point_buf_, kPointFrameSize, 0, (const struct sockaddr*)&point_dst_,
+               sizeof(point_dst_)) < 0) {
+      return false;
+    }
+    ++point_cnt_;
+    return true;
+  }
+
+  uint64_t GetPointCount() const { return point_cnt_; }
+  uint64_t GetImuCount() const { return imu_cnt_; }
+
+ private:
+  int point_sock_;
+  int imu_sock_;
+  struct sockaddr_in point_dst_;
+  struct sockaddr_in imu_dst_;
+  uint64_t point_cnt_;
+  uint64_t imu_cnt_;
+  uint8_t point_buf_[kPointFrameSize];
+  uint8_t imu_buf_[kImuFrameSize];
+};
+#endif  // __linux__
+
+} // namespace benchmark
+} // namespace lidar
+}  // namespace livox
+
+#endif  // LIVOX_BENCHMARK_MID360_FRAMES_H_
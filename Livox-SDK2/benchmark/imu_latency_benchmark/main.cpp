@@ -0,0 +1,159 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// IMU delivery latency per lidar, as reported by GetLivoxLidarImuLatencyStats, with the IMU on
+// the data io thread ("rx_timestamp_enable") and on its own thread ("imu_io_thread"). Two
+// emulated Mid-360 on 127.0.0.2 and 127.0.0.3 send about 2000 point frames and 200 IMU frames a
+// second each, and a point cloud observer spends busy_us on every point frame, like a heavy
+// consumer on the data io thread. Each mode runs the sdk in a fresh process.
+// Usage: imu_latency_benchmark [seconds] [busy_us]
+
+#include "mid360_frames.h"
+#include "livox_lidar_api.h"
+#include "livox_lidar_def.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+
+#ifdef __linux__
+#include <sys/wait.h>
+#endif
+
+using namespace livox::lidar::benchmark;
+
+static const int kLidarNum = 2;
+static const char* kLidarIps[kLidarNum] = {"127.0.0.2", "127.0.0.3"};
+static const long kPointFrameRate = 2000;
+
+#ifdef __linux__
+static long busy_us = 0;
+
+static void BusyPointFrame(uint32_t handle, const uint8_t dev_type, LivoxLidarEthernetPacket* data, void* client_data) {
+  auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(busy_us);
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+
+static bool WriteConfig(const char* path, bool imu_io_thread) {
+  FILE* file = fopen(path, "w");
+  if (file == nullptr) {
+    return false;
+  }
+  fprintf(file,
+      "{\n"
+      "  \"data_io_thread_num\": 1,\n"
+      "  %s,\n"
+      "  \"MID360\": {\n"
+      "    \"lidar_net_info\": {\"cmd_data_port\": 56100, \"push_msg_port\": 56200, \"point_data_port\": %u,\n"
+      "                       \"imu_data_port\": %u, \"log_data_port\": 56500},\n"
+      "    \"host_net_info\": [{\"host_ip\": \"127.0.0.1\", \"lidar_ip\": [\"%s\", \"%s\"], \"cmd_data_port\": 56101,\n"
+      "                        \"push_msg_port\": 56201, \"point_data_port\": %u, \"imu_data_port\": %u,\n"
+      "                        \"log_data_port\": 56501}]\n"
+      "  }\n"
+      "}\n", imu_io_thread ? "\"imu_io_thread\": {}" : "\"rx_timestamp_enable\": true",
+      kMid360PointPort, kMid360ImuPort, kLidarIps[0], kLidarIps[1], kHostPointPort, kHostImuPort);
+  fclose(file);
+  return true;
+}
+
+static bool RunMode(bool imu_io_thread, long seconds) {
+  const char* name = imu_io_thread ? "imu_io_thread" : "data io thread";
+  const char* cfg_path = "/tmp/imu_latency_benchmark.json";
+  DisableLivoxSdkConsoleLogger();
+  if (!WriteConfig(cfg_path, imu_io_thread) || !LivoxLidarSdkInit(cfg_path)) {
+    printf("  %-14s  init the sdk failed.\n", name);
+    return false;
+  }
+  LivoxLidarAddPointCloudTypeObserver(kLivoxLidarCartesianCoordinateHighData, BusyPointFrame, nullptr);
+
+  Mid360Sender senders[kLidarNum];
+  for (int i = 0; i < kLidarNum; ++i) {
+    if (!senders[i].Init(kLidarIps[i], "127.0.0.1")) {
+      printf("  %-14s  create the lidar sockets on %s failed.\n", name, kLidarIps[i]);
+      LivoxLidarSdkUninit();
+      return false;
+    }
+  }
+  auto start = std::chrono::steady_clock::now();
+  long point_frames = seconds * kPointFrameRate;
+  for (long i = 0; i < point_frames; ++i) {
+    for (int j = 0; j < kLidarNum; ++j) {
+      senders[j].Send();
+    }
+    std::this_thread::sleep_until(start + std::chrono::microseconds((i + 1) * 1000000 / kPointFrameRate));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  bool ok = true;
+  for (int i = 0; i < kLidarNum; ++i) {
+    LivoxLidarImuLatencyStats stats;
+    if (GetLivoxLidarImuLatencyStats(inet_addr(kLidarIps[i]), &stats) != kLivoxLidarStatusSuccess) {
+      printf("  %-14s  %s  no imu latency recorded.\n", name, kLidarIps[i]);
+      ok = false;
+      continue;
+    }
+    printf("  %-14s  %s  %6lu imu packets  avg %8.1f us  max %8.1f us  (%lu sent)\n", name, kLidarIps[i],
+        (unsigned long)stats.packet_count, stats.avg_latency_ns / 1e3, stats.max_latency_ns / 1e3,
+        (unsigned long)senders[i].GetImuCount());
+  }
+  LivoxLidarSdkUninit();
+  return ok;
+}
+
+// The sdk is a process wide singleton, each mode gets a fresh process.
+static bool RunModeInChild(bool imu_io_thread, long seconds) {
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    bool ok = RunMode(imu_io_thread, seconds);
+    fflush(stdout);
+    _exit(ok ? 0 : 1);
+  }
+  int status = 0;
+  return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+#endif  // __linux__
+
+int main(int argc, const char *argv[]) {
+  long seconds = (argc > 1) ? atol(argv[1]) : 3;
+  long busy = (argc > 2) ? atol(argv[2]) : 100;
+  if (seconds <= 0 || busy < 0) {
+    printf("Usage: %s [seconds] [busy_us]\n", argv[0]);
+    return -1;
+  }
+#ifdef __linux__
+  busy_us = busy;
+  printf("IMU latency from the kernel receive time to the callback, %ld us per point frame in an observer:\n",
+      busy_us);
+  bool ok = RunModeInChild(false, seconds);
+  ok = RunModeInChild(true, seconds) && ok;
+  return ok ? 0 : 1;
+#else
+  printf("Skipped, the benchmark needs Linux.\n");
+  return 0;
+#endif
+}
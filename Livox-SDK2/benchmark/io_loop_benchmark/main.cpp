@@ -0,0 +1,295 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Per event cost of the epoll dispatch and per task cost of the IOLoop task queue, each next to
+// the implementation it replaced. Usage: io_loop_benchmark [fd_num] [producer_num]
+
+#include "livox_lidar_cfg.h"
+#include "base/task_queue.h"
+#include "base/multiple_io/multiple_io_epoll.h"
+#include "base/wake_up/wake_up_pipe.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef HAVE_EPOLL
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+using namespace livox::lidar;
+
+static const int kPollRounds = 20000;
+static const uint32_t kTasksPerProducer = 200000;
+
+static double ElapsedNs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+#ifdef HAVE_EPOLL
+// The dispatch MultipleIOEpoll::Poll did before the handler records: a map lookup by fd and a
+// copy of the PollFd with its std::function members for every ready event.
+class MapEpollDispatch {
+ public:
+  MapEpollDispatch() : epoll_fd_(epoll_create(1)) {}
+  ~MapEpollDispatch() { close(epoll_fd_); }
+
+  void Add(const PollFd& poll_fd) {
+    struct epoll_event ee = {0};
+    ee.events = EPOLLIN;
+    ee.data.fd = poll_fd.fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, poll_fd.fd, &ee);
+    descriptors_[poll_fd.fd] = poll_fd;
+    pollset_.resize(descriptors_.size());
+  }
+
+  void Poll() {
+    int ret = epoll_wait(epoll_fd_, pollset_.data(), (int)pollset_.size(), 0);
+    for (int i = 0; i < ret; i++) {
+      int fd = pollset_[i].data.fd;
+      if (descriptors_.find(fd) != descriptors_.end()) {
+        PollFd pollfd = descriptors_[fd];
+        pollfd.event_callback(READBLE_EVENT);
+      }
+    }
+  }
+
+ private:
+  int epoll_fd_;
+  std::map<int, PollFd> descriptors_;
+  std::vector<struct epoll_event> pollset_;
+};
+
+// Callbacks shaped like the ones IOLoop registers, too big for the small object buffer of
+// std::function, so copying a PollFd allocates.
+static PollFd MakePollFd(int fd, uint64_t* events, void* owner) {
+  PollFd poll_fd = {};
+  poll_fd.fd = fd;
+  poll_fd.event = READBLE_EVENT;
+  poll_fd.event_callback = [owner, fd, events](FdEvent) { ++*events; (void)owner; (void)fd; };
+  poll_fd.wake_callback = [owner, fd, events]() { (void)owner; (void)fd; (void)events; };
+  return poll_fd;
+}
+
+static void BenchmarkEpollDispatch(int fd_num) {
+  // An eventfd with a non zero count stays readable, every level triggered poll reports all.
+  std::vector<int> fds;
+  for (int i = 0; i < fd_num; ++i) {
+    int fd = eventfd(1, EFD_NONBLOCK);
+    if (fd < 0) {
+      printf("eventfd failed, %d descriptors created.\n", i);
+      break;
+    }
+    fds.push_back(fd);
+  }
+
+  uint64_t map_events = 0;
+  double map_ns = 0;
+  {
+    MapEpollDispatch dispatch;
+    for (int fd : fds) {
+      dispatch.Add(MakePollFd(fd, &map_events, &dispatch));
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kPollRounds; ++i) {
+      dispatch.Poll();
+    }
+    map_ns = ElapsedNs(start);
+  }
+
+  uint64_t record_events = 0;
+  double record_ns = 0;
+  {
+    MultipleIOEpoll dispatch;
+    dispatch.PollCreate(fd_num);
+    for (int fd : fds) {
+      dispatch.PollSetAdd(MakePollFd(fd, &record_events, &dispatch));
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kPollRounds; ++i) {
+      dispatch.Poll(0);
+    }
+    record_ns = ElapsedNs(start);
+    for (int fd : fds) {
+      PollFd poll_fd = {};
+      poll_fd.fd = fd;
+      dispatch.PollSetRemove(poll_fd);
+    }
+    dispatch.PollDestroy();
+  }
+
+  for (int fd : fds) {
+    close(fd);
+  }
+
+  printf("epoll dispatch, %zu ready descriptors, %d polls:\n", fds.size(), kPollRounds);
+  printf("  map lookup + PollFd copy   %8.1f ns/event (%lu events)\n",
+      map_events ? map_ns / map_events : 0.0, (unsigned long)map_events);
+  printf("  fd indexed handler record  %8.1f ns/event (%lu events)\n",
+      record_events ? record_ns / record_events : 0.0, (unsigned long)record_events);
+}
+#endif  // HAVE_EPOLL
+
+// The queue IOLoop::PostTask used before TaskQueue, the loop swapped the vector out under the lock.
+class MutexTaskQueue {
+ public:
+  void Push(const TaskQueue::Task& task) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(task);
+  }
+  void PopAll(std::vector<TaskQueue::Task>& tasks) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks.swap(tasks_);
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<TaskQueue::Task> tasks_;
+};
+
+// Runs producer_num threads posting tasks while the calling thread consumes them, returns the
+// time until the last task ran.
+template <typename PushFn, typename ConsumeFn>
+static double RunProducers(int producer_num, PushFn push, ConsumeFn consume) {
+  uint64_t total = static_cast<uint64_t>(producer_num) * kTasksPerProducer;
+  uint64_t done = 0;
+  std::atomic<bool> start_flag(false);
+  std::vector<std::thread> producers;
+  for (int i = 0; i < producer_num; ++i) {
+    producers.emplace_back([&start_flag, &push, &done]() {
+      while (!start_flag.load()) {
+        std::this_thread::yield();
+      }
+      for (uint32_t n = 0; n < kTasksPerProducer; ++n) {
+        push([&done]() { ++done; });
+      }
+    });
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  start_flag.store(true);
+  while (done < total) {
+    if (!consume()) {
+      std::this_thread::yield();
+    }
+  }
+  double ns = ElapsedNs(start);
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  return ns;
+}
+
+// Queue alone when wake is false. Otherwise the whole PostTask: the mutex queue woke the loop for
+// every task, TaskQueue only when wake_pending goes from false to true, as IOLoop does.
+static double BenchmarkMutexQueue(int producer_num, bool wake) {
+  MutexTaskQueue mutex_queue;
+  WakeUpPipe wake_up_pipe;
+  wake_up_pipe.PipeCreate();
+  std::vector<TaskQueue::Task> tasks;
+  double ns = RunProducers(producer_num,
+      [&mutex_queue, &wake_up_pipe, wake](const TaskQueue::Task& task) {
+        mutex_queue.Push(task);
+        if (wake) {
+          wake_up_pipe.WakeUp();
+        }
+      },
+      [&mutex_queue, &wake_up_pipe, &tasks, wake]() {
+        if (wake) {
+          wake_up_pipe.Drain();
+        }
+        tasks.clear();
+        mutex_queue.PopAll(tasks);
+        for (auto& task : tasks) {
+          task();
+        }
+        return !tasks.empty();
+      });
+  wake_up_pipe.PipeDestroy();
+  return ns;
+}
+
+static double BenchmarkLockFreeQueue(int producer_num, bool wake) {
+  TaskQueue task_queue;
+  WakeUpPipe wake_up_pipe;
+  wake_up_pipe.PipeCreate();
+  std::atomic<bool> wake_pending(false);
+  TaskQueue::Task task;
+  double ns = RunProducers(producer_num,
+      [&task_queue, &wake_up_pipe, &wake_pending, wake](const TaskQueue::Task& task) {
+        task_queue.Push(task);
+        if (wake && !wake_pending.exchange(true, std::memory_order_acq_rel)) {
+          wake_up_pipe.WakeUp();
+        }
+      },
+      [&task_queue, &wake_up_pipe, &wake_pending, &task, wake]() {
+        if (wake) {
+          wake_up_pipe.Drain();
+          wake_pending.store(false, std::memory_order_release);
+        }
+        bool popped = false;
+        while (task_queue.Pop(task)) {
+          task();
+          popped = true;
+        }
+        return popped;
+      });
+  wake_up_pipe.PipeDestroy();
+  return ns;
+}
+
+static void BenchmarkTaskQueue(int producer_num) {
+  uint64_t total = static_cast<uint64_t>(producer_num) * kTasksPerProducer;
+  printf("task queue, %d producers, %lu tasks:\n", producer_num, (unsigned long)total);
+  printf("  queue only, mutex + vector %8.1f ns/task\n", BenchmarkMutexQueue(producer_num, false) / total);
+  printf("  queue only, TaskQueue      %8.1f ns/task\n", BenchmarkLockFreeQueue(producer_num, false) / total);
+  printf("  PostTask, wake per task    %8.1f ns/task\n", BenchmarkMutexQueue(producer_num, true) / total);
+  printf("  PostTask, coalesced wake   %8.1f ns/task\n", BenchmarkLockFreeQueue(producer_num, true) / total);
+}
+
+int main(int argc, const char *argv[]) {
+  int fd_num = (argc > 1) ? atoi(argv[1]) : 64;
+  int producer_num = (argc > 2) ? atoi(argv[2]) : 4;
+  if (fd_num <= 0 || producer_num <= 0) {
+    printf("Usage: %s [fd_num] [producer_num]\n", argv[0]);
+    return -1;
+  }
+
+#ifdef HAVE_EPOLL
+  BenchmarkEpollDispatch(fd_num);
+#else
+  printf("epoll dispatch skipped, the platform has no epoll.\n");
+#endif
+  BenchmarkTaskQueue(producer_num);
+  return 0;
+}
@@ -0,0 +1,289 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Per packet cost as the number of emulated lidars grows, up to kMaxLidarCount.
+// - routing: the RouteTable lookup of OnPacket next to the per datagram inet_ntoa and
+//   custom_lidars_cfg_map_ lookups it replaced.
+// - receive: one MultipleIOEpoll polling a socket per lidar, each datagram received with
+//   RecvMultiFrom and routed, the descriptor set grows from its initial size on the way.
+// Usage: lidar_scaling_benchmark [max_lidar_num]
+
+#include "livox_lidar_def.h"
+#include "livox_lidar_cfg.h"
+#include "route_table.h"
+#include "base/network/network_util.h"
+#include "base/multiple_io/multiple_io_epoll.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_EPOLL
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace livox::lidar;
+
+static const uint16_t kPointPort = 56300;
+static const uint16_t kImuPort = 56400;
+static const uint16_t kCmdPort = 56100;
+static const uint16_t kPushPort = 56200;
+static const uint16_t kLogPort = 56500;
+static const uint16_t kDetectPort = 56000;
+static const uint16_t kFaultPort = 56800;
+static const uint32_t kRoutePackets = 4000000;
+static const int kRecvRounds = 200;
+static const int kPacketsPerLidar = 8;
+static const size_t kPacketSize = 1380;
+
+static volatile uint64_t sink = 0;
+
+static double ElapsedNs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The ports of a lidar, as kept in custom_lidars_cfg_map_ before the route table.
+typedef struct {
+  uint8_t device_type;
+  uint16_t point_data_port;
+  uint16_t imu_data_port;
+  uint16_t cmd_data_port;
+  uint16_t push_msg_port;
+  uint16_t log_data_port;
+} LegacyLidarCfg;
+
+static uint8_t LegacyRoute(std::map<uint32_t, LegacyLidarCfg>& cfg_map, const std::string& host_ip,
+    uint32_t handle, uint16_t port) {
+  struct in_addr tmp_addr;
+  tmp_addr.s_addr = handle;
+  std::string lidar_ip = inet_ntoa(tmp_addr);
+  if (lidar_ip == host_ip) {
+    return kRouteNone;
+  }
+  if (cfg_map.find(handle) != cfg_map.end()) {
+    const LegacyLidarCfg& lidar_cfg = cfg_map[handle];
+    if (port == lidar_cfg.imu_data_port || port == lidar_cfg.point_data_port) {
+      return kRouteData;
+    }
+    if (port == kDetectPort || port == lidar_cfg.cmd_data_port || port == lidar_cfg.push_msg_port ||
+        port == lidar_cfg.log_data_port || port == kFaultPort) {
+      return kRouteCommand;
+    }
+  }
+  return kRouteNone;
+}
+
+static uint32_t LidarHandle(int index) {
+  return htonl((10u << 24) | (static_cast<uint32_t>(index / 250) << 8) | static_cast<uint32_t>(index % 250 + 1));
+}
+
+static void BenchmarkRouting(int lidar_num) {
+  std::map<uint32_t, LegacyLidarCfg> cfg_map;
+  RouteTable route_table(lidar_num * 7);
+  for (int i = 0; i < lidar_num; ++i) {
+    uint32_t handle = LidarHandle(i);
+    cfg_map[handle] = LegacyLidarCfg{kLivoxLidarTypeMid360, kPointPort, kImuPort, kCmdPort, kPushPort, kLogPort};
+    route_table.Insert(handle, kImuPort, kRouteData, kLivoxLidarTypeMid360);
+    route_table.Insert(handle, kPointPort, kRouteData, kLivoxLidarTypeMid360);
+    route_table.Insert(handle, kDetectPort, kRouteCommand, kLivoxLidarTypeMid360);
+    route_table.Insert(handle, kCmdPort, kRouteCommand, kLivoxLidarTypeMid360);
+    route_table.Insert(handle, kPushPort, kRouteCommand, kLivoxLidarTypeMid360);
+    route_table.Insert(handle, kLogPort, kRouteCommand, kLivoxLidarTypeMid360);
+    route_table.Insert(handle, kFaultPort, kRouteCommand, kLivoxLidarTypeMid360);
+  }
+
+  // The lidars take turns, every tenth packet of a lidar is an imu packet.
+  std::vector<std::pair<uint32_t, uint16_t>> packets;
+  packets.reserve(lidar_num * 10);
+  for (int n = 0; n < 10; ++n) {
+    for (int i = 0; i < lidar_num; ++i) {
+      packets.push_back(std::make_pair(LidarHandle(i), (n == 9) ? kImuPort : kPointPort));
+    }
+  }
+
+  std::string host_ip = "192.168.1.50";
+  uint64_t sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < kRoutePackets; ++i) {
+    const std::pair<uint32_t, uint16_t>& packet = packets[i % packets.size()];
+    sum += LegacyRoute(cfg_map, host_ip, packet.first, packet.second);
+  }
+  double legacy_ns = ElapsedNs(start);
+
+  start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < kRoutePackets; ++i) {
+    const std::pair<uint32_t, uint16_t>& packet = packets[i % packets.size()];
+    const RouteEntry* route = route_table.Find(packet.first, packet.second);
+    sum += (route != nullptr) ? route->dest : kRouteNone;
+  }
+  double table_ns = ElapsedNs(start);
+  sink += sum;
+
+  printf("  %4d lidars  routing  legacy %7.1f ns/packet  route table %5.1f ns/packet\n",
+      lidar_num, legacy_ns / kRoutePackets, table_ns / kRoutePackets);
+}
+
+#ifdef HAVE_EPOLL
+// Non blocking like the sdk sockets, RecvMultiFrom would otherwise wait for a full batch.
+static int CreateUdpSocket() {
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock < 0) {
+    return -1;
+  }
+  fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+    close(sock);
+    return -1;
+  }
+  return sock;
+}
+
+static uint16_t GetPort(int sock) {
+  struct sockaddr_in addr;
+  socklen_t addrlen = sizeof(addr);
+  getsockname(sock, (struct sockaddr*)&addr, &addrlen);
+  return ntohs(addr.sin_port);
+}
+
+static void BenchmarkReceive(int lidar_num) {
+  // A sender socket plays each lidar, its source port is the point data port of the route.
+  std::vector<int> lidar_socks;
+  std::vector<int> host_socks;
+  std::vector<struct sockaddr_in> host_addrs;
+  RouteTable route_table(lidar_num * 7);
+  uint32_t handle = htonl(INADDR_LOOPBACK);
+  for (int i = 0; i < lidar_num; ++i) {
+    int lidar_sock = CreateUdpSocket();
+    int host_sock = CreateUdpSocket();
+    if (lidar_sock < 0 || host_sock < 0) {
+      printf("  %4d lidars  receive  socket creation failed\n", lidar_num);
+      return;
+    }
+    lidar_socks.push_back(lidar_sock);
+    host_socks.push_back(host_sock);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(GetPort(host_sock));
+    host_addrs.push_back(addr);
+    route_table.Insert(handle, GetPort(lidar_sock), kRouteData, kLivoxLidarTypeMid360);
+  }
+
+  uint64_t received = 0;
+  uint64_t routed = 0;
+  std::vector<uint8_t> buf(util::kMaxRecvMsgNum * kPacketSize);
+  util::RecvMsg msgs[util::kMaxRecvMsgNum];
+  MultipleIOEpoll multiple_io;
+  // Starts at the size IOLoop used to be fixed at, PollSetAdd grows it.
+  multiple_io.PollCreate(48);
+  for (int i = 0; i < lidar_num; ++i) {
+    PollFd poll_fd = {};
+    poll_fd.fd = host_socks[i];
+    poll_fd.event = READBLE_EVENT;
+    poll_fd.event_callback = [&, i](FdEvent) {
+      for (int n = 0; n < util::kMaxRecvMsgNum; ++n) {
+        msgs[n].buff = buf.data() + n * kPacketSize;
+        msgs[n].buf_size = kPacketSize;
+      }
+      int num = util::RecvMultiFrom(host_socks[i], msgs, util::kMaxRecvMsgNum);
+      for (int n = 0; n < num; ++n) {
+        const struct sockaddr_in* addr = (const struct sockaddr_in*)&msgs[n].addr;
+        const RouteEntry* route = route_table.Find(addr->sin_addr.s_addr, ntohs(addr->sin_port));
+        routed += (route != nullptr && route->dest == kRouteData) ? 1 : 0;
+      }
+      received += (num > 0) ? num : 0;
+    };
+    if (!multiple_io.PollSetAdd(poll_fd)) {
+      printf("  %4d lidars  receive  PollSetAdd failed at lidar %d\n", lidar_num, i);
+      return;
+    }
+  }
+
+  std::vector<uint8_t> packet(kPacketSize, 0);
+  uint64_t expected = 0;
+  double ns = 0;
+  for (int round = 0; round < kRecvRounds; ++round) {
+    for (int n = 0; n < kPacketsPerLidar; ++n) {
+      for (int i = 0; i < lidar_num; ++i) {
+        sendto(lidar_socks[i], packet.data(), packet.size(), 0, (struct sockaddr*)&host_addrs[i], sizeof(host_addrs[i]));
+      }
+    }
+    expected += static_cast<uint64_t>(lidar_num) * kPacketsPerLidar;
+    // Only the receive side is timed.
+    auto start = std::chrono::steady_clock::now();
+    while (received < expected) {
+      multiple_io.Poll(100);
+    }
+    ns += ElapsedNs(start);
+  }
+
+  for (int i = 0; i < lidar_num; ++i) {
+    PollFd poll_fd = {};
+    poll_fd.fd = host_socks[i];
+    multiple_io.PollSetRemove(poll_fd);
+    close(host_socks[i]);
+    close(lidar_socks[i]);
+  }
+  multiple_io.PollDestroy();
+
+  printf("  %4d lidars  receive  %7.1f ns/packet  (%lu packets, %lu routed)\n",
+      lidar_num, ns / received, (unsigned long)received, (unsigned long)routed);
+}
+#endif  // HAVE_EPOLL
+
+int main(int argc, const char *argv[]) {
+  int max_lidar_num = (argc > 1) ? atoi(argv[1]) : kMaxLidarCount;
+  if (max_lidar_num <= 0 || max_lidar_num > kMaxLidarCount) {
+    printf("Usage: %s [max_lidar_num], at most %d lidars.\n", argv[0], kMaxLidarCount);
+    return -1;
+  }
+
+  printf("Per packet cost by lidar count:\n");
+  for (int lidar_num = 1; lidar_num <= max_lidar_num; lidar_num *= 2) {
+    BenchmarkRouting(lidar_num);
+  }
+#ifdef HAVE_EPOLL
+  for (int lidar_num = 1; lidar_num <= max_lidar_num; lidar_num *= 2) {
+    BenchmarkReceive(lidar_num);
+  }
+#else
+  printf("receive skipped, the platform has no epoll.\n");
+#endif
+  return 0;
+}
@@ -0,0 +1,78 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Emulates a Mid-360 for the receive paths: sends point frames of 96 high cartesian points from
+// lidar_ip:56300 to host_ip:56301, and an IMU frame from lidar_ip:56400 to host_ip:56401 every
+// 10 point frames. lidar_ip must be a local address, e.g. 127.0.0.2 on the loopback or an alias
+// of the interface under test. rate is in point frames per second, a Mid-360 sends about 2000,
+// 0 sends as fast as possible.
+// Usage: packet_generator [host_ip] [lidar_ip] [point_frames] [rate]
+
+#include "mid360_frames.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+
+using namespace livox::lidar::benchmark;
+
+int main(int argc, const char *argv[]) {
+  const char* host_ip = (argc > 1) ? argv[1] : "127.0.0.1";
+  const char* lidar_ip = (argc > 2) ? argv[2] : "127.0.0.2";
+  long point_frames = (argc > 3) ? atol(argv[3]) : 20000;
+  long rate = (argc > 4) ? atol(argv[4]) : 2000;
+  if (point_frames <= 0 || rate < 0) {
+    printf("Usage: %s [host_ip] [lidar_ip] [point_frames] [rate]\n", argv[0]);
+    return -1;
+  }
+#ifdef __linux__
+  Mid360Sender sender;
+  if (!sender.Init(lidar_ip, host_ip)) {
+    printf("Bind %s:%u and %s:%u failed, the lidar ip must be a local address.\n", lidar_ip, kMid360PointPort,
+        lidar_ip, kMid360ImuPort);
+    return -1;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < point_frames; ++i) {
+    if (!sender.Send()) {
+      printf("Send failed after %lu point frames.\n", (unsigned long)sender.GetPointCount());
+      return -1;
+    }
+    // Paced in steps of 1 ms worth of frames.
+    if (rate > 0 && (i + 1) % (rate / 1000 + 1) == 0) {
+      std::this_thread::sleep_until(start + std::chrono::microseconds((i + 1) * 1000000 / rate));
+    }
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("Sent %lu point frames and %lu imu frames to %s in %.2f s, %.0f point frames/s.\n",
+      (unsigned long)sender.GetPointCount(), (unsigned long)sender.GetImuCount(), host_ip, seconds,
+      sender.GetPointCount() / seconds);
+#else
+  printf("Skipped, the generator needs Linux.\n");
+#endif
+  return 0;
+}
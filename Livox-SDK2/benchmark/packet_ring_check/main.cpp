@@ -0,0 +1,163 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Checks that the packet ring delivers every frame: the sdk captures the data ports of an
+// emulated Mid-360 on 127.0.0.2 with "packet_ring" on the loopback, the frames of
+// mid360_frames.h are sent to it, and an observer, called from DataHandler::Handle, marks each
+// point and IMU frame by its udp_cnt. Every frame must arrive exactly once. Needs CAP_NET_RAW.
+// Usage: packet_ring_check [point_frames] [rate] [data_io_thread_num]
+
+#include "mid360_frames.h"
+#include "livox_lidar_api.h"
+#include "livox_lidar_def.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace livox::lidar::benchmark;
+
+static const char* kLidarIp = "127.0.0.2";
+static const long kMaxPointFrames = 65536;
+
+static std::atomic<uint32_t> point_seen[kMaxPointFrames];
+static std::atomic<uint32_t> imu_seen[kMaxPointFrames / kPointFramesPerImuFrame + 1];
+static std::atomic<uint64_t> point_frames_handled(0);
+static std::atomic<uint64_t> imu_frames_handled(0);
+
+#ifdef __linux__
+static void MarkFrame(uint32_t handle, const uint8_t dev_type, LivoxLidarEthernetPacket* data, void* client_data) {
+  if (handle != inet_addr(kLidarIp)) {
+    return;
+  }
+  if (data->data_type == kLivoxLidarImuData) {
+    imu_seen[data->udp_cnt % (kMaxPointFrames / kPointFramesPerImuFrame + 1)]++;
+    imu_frames_handled++;
+  } else {
+    point_seen[data->udp_cnt]++;
+    point_frames_handled++;
+  }
+}
+
+static bool WriteConfig(const char* path, long data_io_thread_num) {
+  FILE* file = fopen(path, "w");
+  if (file == nullptr) {
+    return false;
+  }
+  fprintf(file,
+      "{\n"
+      "  \"data_io_thread_num\": %ld,\n"
+      "  \"packet_ring\": {\"netif\": \"lo\", \"block_size_KB\": 1024, \"block_num\": 16, \"block_timeout_ms\": 2},\n"
+      "  \"MID360\": {\n"
+      "    \"lidar_net_info\": {\"cmd_data_port\": 56100, \"push_msg_port\": 56200, \"point_data_port\": %u,\n"
+      "                       \"imu_data_port\": %u, \"log_data_port\": 56500},\n"
+      "    \"host_net_info\": [{\"host_ip\": \"127.0.0.1\", \"lidar_ip\": [\"%s\"], \"cmd_data_port\": 56101,\n"
+      "                        \"push_msg_port\": 56201, \"point_data_port\": %u, \"imu_data_port\": %u,\n"
+      "                        \"log_data_port\": 56501}]\n"
+      "  }\n"
+      "}\n", data_io_thread_num, kMid360PointPort, kMid360ImuPort, kLidarIp, kHostPointPort, kHostImuPort);
+  fclose(file);
+  return true;
+}
+
+static uint64_t CountMissing(std::atomic<uint32_t>* seen, uint64_t num, uint64_t* duplicated) {
+  uint64_t missing = 0;
+  for (uint64_t i = 0; i < num; ++i) {
+    uint32_t count = seen[i].load();
+    if (count == 0) {
+      ++missing;
+    } else if (count > 1) {
+      ++*duplicated;
+    }
+  }
+  return missing;
+}
+#endif  // __linux__
+
+int main(int argc, const char *argv[]) {
+  long point_frames = (argc > 1) ? atol(argv[1]) : 20000;
+  long rate = (argc > 2) ? atol(argv[2]) : 20000;
+  long data_io_thread_num = (argc > 3) ? atol(argv[3]) : 2;
+  if (point_frames <= 0 || point_frames > kMaxPointFrames || rate < 0 || data_io_thread_num <= 0) {
+    printf("Usage: %s [point_frames] [rate] [data_io_thread_num], at most %ld point frames.\n", argv[0],
+        kMaxPointFrames);
+    return -1;
+  }
+#ifdef __linux__
+  const char* cfg_path = "/tmp/packet_ring_check.json";
+  DisableLivoxSdkConsoleLogger();
+  if (!WriteConfig(cfg_path, data_io_thread_num) || !LivoxLidarSdkInit(cfg_path)) {
+    printf("Init the sdk failed.\n");
+    return -1;
+  }
+  uint16_t observer_id = LivoxLidarAddPointCloudObserver(MarkFrame, nullptr);
+
+  Mid360Sender sender;
+  if (!sender.Init(kLidarIp, "127.0.0.1")) {
+    printf("Create the lidar sockets on %s failed.\n", kLidarIp);
+    LivoxLidarSdkUninit();
+    return -1;
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < point_frames; ++i) {
+    if (!sender.Send()) {
+      break;
+    }
+    if (rate > 0 && (i + 1) % (rate / 1000 + 1) == 0) {
+      std::this_thread::sleep_until(start + std::chrono::microseconds((i + 1) * 1000000 / rate));
+    }
+  }
+
+  // Partly filled ring blocks are handed over after block_timeout_ms.
+  uint64_t expected = sender.GetPointCount() + sender.GetImuCount();
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+  while (point_frames_handled + imu_frames_handled < expected && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  // Late duplicates would show up here.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  LivoxLidarRemovePointCloudObserver(observer_id);
+  LivoxLidarSdkUninit();
+
+  uint64_t duplicated = 0;
+  uint64_t point_missing = CountMissing(point_seen, sender.GetPointCount(), &duplicated);
+  uint64_t imu_missing = CountMissing(imu_seen, sender.GetImuCount(), &duplicated);
+  printf("Sent %lu point and %lu imu frames, handled %lu and %lu, %lu point and %lu imu frames missing, "
+      "%lu duplicated.\n", (unsigned long)sender.GetPointCount(), (unsigned long)sender.GetImuCount(),
+      (unsigned long)point_frames_handled.load(), (unsigned long)imu_frames_handled.load(),
+      (unsigned long)point_missing, (unsigned long)imu_missing, (unsigned long)duplicated);
+  if (sender.GetPointCount() != static_cast<uint64_t>(point_frames) || point_missing != 0 || imu_missing != 0 ||
+      duplicated != 0) {
+    printf("FAILED: the packet ring did not deliver every frame once.\n");
+    return 1;
+  }
+  printf("OK: every frame reached DataHandler::Handle once.\n");
+#else
+  printf("Skipped, the packet ring needs Linux.\n");
+#endif
+  return 0;
+}
@@ -0,0 +1,262 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Heap allocations of the receive path. Mid-360 point and IMU packets from an emulated lidar on
+// 127.0.0.2 are received with DeviceManager::RecvBatch into a RecvBufferPool and routed to
+// DataHandler::Handle, where an observer keeps every 4th point packet for a while with
+// LivoxLidarAcquirePacket. After a warm up round, both the allocations the pool counts and the
+// operator new calls of this thread must stay flat. Usage: recv_batch_benchmark [rounds]
+
+#include "livox_lidar_api.h"
+#include "livox_lidar_def.h"
+#include "device_manager.h"
+#include "base/recv_buffer_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <new>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace livox::lidar;
+
+static const char* kLidarIp = "127.0.0.2";
+static const uint16_t kLidarPointPort = 56300;
+static const uint16_t kLidarImuPort = 56400;
+static const size_t kBatchSize = 16;
+static const size_t kSpareNum = 64;
+static const size_t kHeldNum = 16;
+static const size_t kPointPacketSize = 1380;  // 96 high cartesian points.
+static const size_t kImuPacketSize = 60;
+static const int kDefaultRounds = 20000;
+
+// operator new calls of the current thread, the sdk threads allocate on their own.
+static thread_local uint64_t thread_new_count = 0;
+
+void* operator new(size_t size) {
+  ++thread_new_count;
+  void* p = malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+#ifdef __linux__
+static double ElapsedNs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static LivoxLidarPacketHandle held[kHeldNum];
+static size_t held_index = 0;
+static uint64_t observed = 0;
+
+// Keeps every 4th point packet until kHeldNum later ones were kept, well below the spares.
+static void KeepPackets(uint32_t handle, const uint8_t dev_type, LivoxLidarEthernetPacket* data, void* client_data) {
+  uint64_t index = observed++;
+  if (data->data_type == kLivoxLidarImuData || index % 4 != 0) {
+    return;
+  }
+  if (held[held_index] != nullptr) {
+    LivoxLidarReleasePacket(held[held_index]);
+  }
+  held[held_index] = LivoxLidarAcquirePacket(&data);
+  held_index = (held_index + 1) % kHeldNum;
+}
+
+static bool WriteConfig(const char* path) {
+  FILE* file = fopen(path, "w");
+  if (file == nullptr) {
+    return false;
+  }
+  fprintf(file,
+      "{\n"
+      "  \"MID360\": {\n"
+      "    \"lidar_net_info\": {\"cmd_data_port\": 56100, \"push_msg_port\": 56200, \"point_data_port\": %u,\n"
+      "                       \"imu_data_port\": %u, \"log_data_port\": 56500},\n"
+      "    \"host_net_info\": [{\"host_ip\": \"127.0.0.1\", \"lidar_ip\": [\"%s\"], \"cmd_data_port\": 56101,\n"
+      "                        \"push_msg_port\": 56201, \"point_data_port\": 56301, \"imu_data_port\": 56401,\n"
+      "                        \"log_data_port\": 56501}]\n"
+      "  }\n"
+      "}\n", kLidarPointPort, kLidarImuPort, kLidarIp);
+  fclose(file);
+  return true;
+}
+
+static int CreateUdpSocket(const char* ip, uint16_t port) {
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock < 0) {
+    return -1;
+  }
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = inet_addr(ip);
+  addr.sin_port = htons(port);
+  if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+    close(sock);
+    return -1;
+  }
+  fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+  return sock;
+}
+
+static uint16_t GetPort(int sock) {
+  struct sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+  getsockname(sock, (struct sockaddr*)&addr, &len);
+  return ntohs(addr.sin_port);
+}
+
+// Sends one batch and receives it through RecvBatch, false if it did not arrive.
+static bool RunRound(int host_sock, int point_sock, int imu_sock, const struct sockaddr_in& dst,
+                     RecvBufferPool* recv_buffer_pool, uint32_t round) {
+  uint8_t point_buf[kPointPacketSize];
+  uint8_t imu_buf[kImuPacketSize];
+  memset(point_buf, 0, sizeof(point_buf));
+  memset(imu_buf, 0, sizeof(imu_buf));
+  LivoxLidarEthernetPacket* point_packet = (LivoxLidarEthernetPacket*)point_buf;
+  point_packet->version = 0;
+  point_packet->length = static_cast<uint16_t>(kPointPacketSize);
+  point_packet->dot_num = 96;
+  point_packet->data_type = kLivoxLidarCartesianCoordinateHighData;
+  LivoxLidarEthernetPacket* imu_packet = (LivoxLidarEthernetPacket*)imu_buf;
+  imu_packet->length = static_cast<uint16_t>(kImuPacketSize);
+  imu_packet->dot_num = 1;
+  imu_packet->data_type = kLivoxLidarImuData;
+
+  // One IMU packet for every 10 point packets, as the Mid-360 sends them.
+  uint64_t expected = recv_buffer_pool->GetPacketCount();
+  for (size_t i = 0; i < kBatchSize; ++i) {
+    uint32_t index = round * kBatchSize + static_cast<uint32_t>(i);
+    bool imu = index % 10 == 0;
+    LivoxLidarEthernetPacket* packet = imu ? imu_packet : point_packet;
+    packet->udp_cnt = static_cast<uint16_t>(index);
+    if (sendto(imu ? imu_sock : point_sock, (const char*)packet, imu ? sizeof(imu_buf) : sizeof(point_buf), 0,
+               (const struct sockaddr*)&dst, sizeof(dst)) > 0) {
+      ++expected;
+    }
+  }
+  for (int spin = 0; recv_buffer_pool->GetPacketCount() < expected; ++spin) {
+    if (spin > 100000) {
+      return false;
+    }
+    DeviceManager::GetInstance().OnData(host_sock, recv_buffer_pool);
+  }
+  return true;
+}
+#endif  // __linux__
+
+int main(int argc, const char *argv[]) {
+  int rounds = (argc > 1) ? atoi(argv[1]) : kDefaultRounds;
+  if (rounds <= 0) {
+    printf("Usage: %s [rounds]\n", argv[0]);
+    return -1;
+  }
+#ifdef __linux__
+  // The sdk routes the packets of the configured lidar, RecvBatch is then driven on this thread.
+  const char* cfg_path = "/tmp/recv_batch_benchmark.json";
+  DisableLivoxSdkConsoleLogger();
+  if (!WriteConfig(cfg_path) || !LivoxLidarSdkInit(cfg_path)) {
+    printf("Init the sdk failed.\n");
+    return -1;
+  }
+  uint16_t observer_id = LivoxLidarAddPointCloudObserver(KeepPackets, nullptr);
+
+  int host_sock = CreateUdpSocket("127.0.0.1", 0);
+  int point_sock = CreateUdpSocket(kLidarIp, kLidarPointPort);
+  int imu_sock = CreateUdpSocket(kLidarIp, kLidarImuPort);
+  RecvBufferPool recv_buffer_pool(kMaxBufferSize, kBatchSize, kSpareNum);
+  if (host_sock < 0 || point_sock < 0 || imu_sock < 0 || !recv_buffer_pool.Init()) {
+    printf("Create the sockets or the receive pool failed.\n");
+    return -1;
+  }
+  struct sockaddr_in dst;
+  memset(&dst, 0, sizeof(dst));
+  dst.sin_family = AF_INET;
+  dst.sin_addr.s_addr = inet_addr("127.0.0.1");
+  dst.sin_port = htons(GetPort(host_sock));
+
+  // The warm up round sizes the thread local batch of the DataHandler and fills the held ring.
+  bool ok = true;
+  for (uint32_t round = 0; round < kHeldNum && ok; ++round) {
+    ok = RunRound(host_sock, point_sock, imu_sock, dst, &recv_buffer_pool, round);
+  }
+  uint64_t pool_allocs = recv_buffer_pool.GetHeapAllocCount();
+  uint64_t new_count = thread_new_count;
+  uint64_t packets = recv_buffer_pool.GetPacketCount();
+  uint64_t handled = observed;
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t round = kHeldNum; round < kHeldNum + static_cast<uint32_t>(rounds) && ok; ++round) {
+    ok = RunRound(host_sock, point_sock, imu_sock, dst, &recv_buffer_pool, round);
+  }
+  double ns = ElapsedNs(start);
+  packets = recv_buffer_pool.GetPacketCount() - packets;
+  pool_allocs = recv_buffer_pool.GetHeapAllocCount() - pool_allocs;
+  new_count = thread_new_count - new_count;
+  handled = observed - handled;
+
+  for (size_t i = 0; i < kHeldNum; ++i) {
+    if (held[i] != nullptr) {
+      LivoxLidarReleasePacket(held[i]);
+      held[i] = nullptr;
+    }
+  }
+  LivoxLidarRemovePointCloudObserver(observer_id);
+  close(host_sock);
+  close(point_sock);
+  close(imu_sock);
+  LivoxLidarSdkUninit();
+
+  if (!ok) {
+    printf("The packets did not arrive.\n");
+    return -1;
+  }
+  printf("RecvBatch: %lu packets, %lu handled, %.1f ns/packet including the send, %lu pool heap allocations, "
+      "%lu operator new calls.\n", (unsigned long)packets, (unsigned long)handled, ns / packets,
+      (unsigned long)pool_allocs, (unsigned long)new_count);
+  if (pool_allocs != 0 || new_count != 0) {
+    printf("FAILED: the receive path allocates.\n");
+    return 1;
+  }
+  printf("OK: no allocation per packet.\n");
+#else
+  printf("Skipped, the benchmark needs Linux.\n");
+#endif
+  return 0;
+}
@@ -0,0 +1,243 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Receive rate and cpu cost per packet of the "xdp" path next to the default epoll sockets. A
+// veth pair carries the frames of mid360_frames.h from an emulated Mid-360 in its own network
+// namespace to the sdk, which runs once per mode in a child process with the xdp program
+// attached to the host end in generic (SKB) mode. The sender blasts the frames unpaced.
+// - packets/s: the frames handled by an observer, over the time from the first to the last one.
+// - receiver cpu: user and system time of the sdk process per handled frame.
+// - sender cpu: the same for the sender process, which also runs the veth receive softirq and
+//   so the generic xdp program.
+// Needs root for the veth pair, the namespace and the xdp program.
+// Usage: xdp_vs_epoll [point_frames]
+
+#include "mid360_frames.h"
+#include "livox_lidar_api.h"
+#include "livox_lidar_def.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#endif
+
+using namespace livox::lidar::benchmark;
+
+static const char* kHostNetif = "lvxbench0";
+static const char* kLidarNetif = "lvxbench1";
+static const char* kLidarNetns = "lvxbench";
+static const char* kHostIp = "10.77.0.1";
+static const char* kLidarIp = "10.77.0.2";
+
+#ifdef __linux__
+typedef std::chrono::steady_clock::time_point TimePoint;
+
+static std::atomic<uint64_t> frames_handled(0);
+static std::atomic<int64_t> first_frame_ns(0);
+static std::atomic<int64_t> last_frame_ns(0);
+
+static int64_t SteadyNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double CpuNs(const struct rusage& usage) {
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e9 +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e3;
+}
+
+static void CountFrame(uint32_t handle, const uint8_t dev_type, LivoxLidarEthernetPacket* data, void* client_data) {
+  int64_t now = SteadyNs();
+  int64_t zero = 0;
+  first_frame_ns.compare_exchange_strong(zero, now);
+  last_frame_ns.store(now);
+  frames_handled++;
+}
+
+static bool Run(const std::string& command) {
+  return system((command + " > /dev/null 2>&1").c_str()) == 0;
+}
+
+static void TeardownVeth() {
+  Run(std::string("ip link del ") + kHostNetif);
+  Run(std::string("ip netns del ") + kLidarNetns);
+}
+
+// The host end keeps the host ip, the lidar end moves into its own namespace so the frames
+// cross the pair instead of the loopback.
+static bool SetupVeth() {
+  TeardownVeth();
+  return Run(std::string("ip netns add ") + kLidarNetns) &&
+         Run(std::string("ip link add ") + kHostNetif + " type veth peer name " + kLidarNetif) &&
+         Run(std::string("ip link set ") + kLidarNetif + " netns " + kLidarNetns) &&
+         Run(std::string("ip addr add ") + kHostIp + "/24 dev " + kHostNetif) &&
+         Run(std::string("ip link set ") + kHostNetif + " up") &&
+         Run(std::string("ip netns exec ") + kLidarNetns + " ip addr add " + kLidarIp + "/24 dev " + kLidarNetif) &&
+         Run(std::string("ip netns exec ") + kLidarNetns + " ip link set " + kLidarNetif + " up") &&
+         Run(std::string("ip netns exec ") + kLidarNetns + " ip link set lo up");
+}
+
+static bool WriteConfig(const char* path, bool xdp) {
+  FILE* file = fopen(path, "w");
+  if (file == nullptr) {
+    return false;
+  }
+  fprintf(file, "{\n");
+  if (xdp) {
+    fprintf(file, "  \"xdp\": {\"netif\": \"%s\", \"queues\": [0], \"frame_num\": 4096},\n", kHostNetif);
+  }
+  fprintf(file,
+      "  \"MID360\": {\n"
+      "    \"lidar_net_info\": {\"cmd_data_port\": 56100, \"push_msg_port\": 56200, \"point_data_port\": %u,\n"
+      "                       \"imu_data_port\": %u, \"log_data_port\": 56500},\n"
+      "    \"host_net_info\": [{\"host_ip\": \"%s\", \"lidar_ip\": [\"%s\"], \"cmd_data_port\": 56101,\n"
+      "                        \"push_msg_port\": 56201, \"point_data_port\": %u, \"imu_data_port\": %u,\n"
+      "                        \"log_data_port\": 56501}]\n"
+      "  }\n"
+      "}\n", kMid360PointPort, kMid360ImuPort, kHostIp, kLidarIp, kHostPointPort, kHostImuPort);
+  fclose(file);
+  return true;
+}
+
+// Forked from the sdk process, so it does not allocate. Enters the lidar namespace and exits
+// with 0 once all frames were sent.
+static void SendFrames(int netns_fd, long point_frames) {
+  if (setns(netns_fd, CLONE_NEWNET) != 0) {
+    _exit(1);
+  }
+  close(netns_fd);
+  Mid360Sender sender;
+  if (!sender.Init(kLidarIp, kHostIp)) {
+    _exit(1);
+  }
+  for (long i = 0; i < point_frames; ++i) {
+    if (!sender.Send()) {
+      _exit(1);
+    }
+  }
+  _exit(0);
+}
+
+// Runs the sdk in this process, returns false if the mode could not run.
+static bool RunMode(bool xdp, long point_frames) {
+  const char* cfg_path = "/tmp/xdp_vs_epoll.json";
+  DisableLivoxSdkConsoleLogger();
+  if (!WriteConfig(cfg_path, xdp) || !LivoxLidarSdkInit(cfg_path)) {
+    printf("  %-5s  init the sdk failed.\n", xdp ? "xdp" : "epoll");
+    return false;
+  }
+  LivoxLidarAddPointCloudObserver(CountFrame, nullptr);
+  // Let the data io threads and the xdp program settle before the burst.
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  std::string netns_path = std::string("/var/run/netns/") + kLidarNetns;
+  int netns_fd = open(netns_path.c_str(), O_RDONLY);
+  struct rusage receiver_start;
+  getrusage(RUSAGE_SELF, &receiver_start);
+  pid_t sender = (netns_fd >= 0) ? fork() : -1;
+  if (sender == 0) {
+    SendFrames(netns_fd, point_frames);
+  }
+  if (netns_fd >= 0) {
+    close(netns_fd);
+  }
+  int status = 0;
+  struct rusage sender_usage;
+  memset(&sender_usage, 0, sizeof(sender_usage));
+  bool sent = sender > 0 && wait4(sender, &status, 0, &sender_usage) == sender && WIFEXITED(status) &&
+              WEXITSTATUS(status) == 0;
+
+  // Done once no frame arrived for 200 ms.
+  uint64_t handled = frames_handled.load();
+  do {
+    handled = frames_handled.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  } while (frames_handled.load() != handled);
+  struct rusage receiver_end;
+  getrusage(RUSAGE_SELF, &receiver_end);
+  LivoxLidarSdkUninit();
+
+  uint64_t sent_frames = static_cast<uint64_t>(point_frames) + (point_frames + kPointFramesPerImuFrame - 1) /
+                         kPointFramesPerImuFrame;
+  if (!sent || handled == 0) {
+    printf("  %-5s  %s, %lu frames handled.\n", xdp ? "xdp" : "epoll", sent ? "no frame arrived" : "send failed",
+        (unsigned long)handled);
+    return false;
+  }
+  double seconds = (last_frame_ns.load() - first_frame_ns.load()) / 1e9;
+  printf("  %-5s  %9.0f packets/s  receiver cpu %7.1f ns/packet  sender cpu %7.1f ns/packet  (%lu of %lu frames)\n",
+      xdp ? "xdp" : "epoll", seconds > 0 ? handled / seconds : 0.0,
+      (CpuNs(receiver_end) - CpuNs(receiver_start)) / handled, CpuNs(sender_usage) / handled,
+      (unsigned long)handled, (unsigned long)sent_frames);
+  return true;
+}
+
+// The sdk is a process wide singleton, each mode gets a fresh process.
+static bool RunModeInChild(bool xdp, long point_frames) {
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    bool ok = RunMode(xdp, point_frames);
+    fflush(stdout);
+    _exit(ok ? 0 : 1);
+  }
+  int status = 0;
+  return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+#endif  // __linux__
+
+int main(int argc, const char *argv[]) {
+  long point_frames = (argc > 1) ? atol(argv[1]) : 200000;
+  if (point_frames <= 0) {
+    printf("Usage: %s [point_frames]\n", argv[0]);
+    return -1;
+  }
+#ifdef __linux__
+  if (!SetupVeth()) {
+    printf("Create the veth pair %s/%s failed, root is required.\n", kHostNetif, kLidarNetif);
+    TeardownVeth();
+    return -1;
+  }
+  printf("Mid-360 frames over a veth pair, %ld point frames per mode:\n", point_frames);
+  bool ok = RunModeInChild(false, point_frames);
+  ok = RunModeInChild(true, point_frames) && ok;
+  TeardownVeth();
+  return ok ? 0 : 1;
+#else
+  printf("Skipped, the benchmark needs Linux.\n");
+  return 0;
+#endif
+}
@@ -82,12 +82,41 @@ void LivoxLidarRemoveCmdObserver();
  */
 uint16_t LivoxLidarAddPointCloudObserver(LivoxLidarPointCloudObserver cb, void *client_data);
 
+/**
+ * Add a point cloud observer for the packets of one data type. The SDK sorts the observers by
+ * type, so the callback is only called for the packets of data_type.
+ * @param data_type              a LivoxLidarPointDataType.
+ * @param cb                     callback to receive the packets.
+ * @param client_data            user data associated with the observer.
+ * @return the observer id, removed with LivoxLidarRemovePointCloudObserver, 0 on failure.
+ */
+uint16_t LivoxLidarAddPointCloudTypeObserver(uint8_t data_type, LivoxLidarPointCloudObserver cb, void* client_data);
+
 /**
  * remove point cloud observer.
  * @param id                     the observer id.
  */
 void LivoxLidarRemovePointCloudObserver(uint16_t id);
 
+/**
+ * Add a point cloud batch observer, which gets every packet an observer gets, but in one call
+ * for all the packets a data io thread received in one receive batch, see "recv_batch_size",
+ * so the packets can be processed together. The packets of a batch keep the order they were
+ * received in, and are valid until the callback returns. The packets of the packet ring are
+ * passed per ring block, those of io_uring per loop wakeup. With the default "recv_batch_size"
+ * of 1 the socket backends receive, and so pass, one packet at a time.
+ * @param cb                     callback to receive the batches.
+ * @param client_data            user data associated with the observer.
+ * @return the observer id, 0 on failure.
+ */
+uint16_t LivoxLidarAddPointCloudBatchObserver(LivoxLidarPointCloudBatchObserver cb, void* client_data);
+
+/**
+ * Remove a point cloud batch observer.
+ * @param id                     the observer id.
+ */
+void LivoxLidarRemovePointCloudBatchObserver(uint16_t id);
+
 /**
  * Set the callback to receive IMU data.
  * @param cb                     callback to receive Status Info.
@@ -474,7 +503,117 @@ bool SetLivoxLidarUpgradeFirmwarePath(const char* firmware_path);
 
 void SetLivoxLidarUpgradeProgressCallback(OnLivoxLidarUpgradeProgressCallback cb, void* client_data);
 
-void UpgradeLivoxLidars(const uint32_t* handle, const uint8_t lidar_num);
+void UpgradeLivoxLidars(const uint32_t* handle, const uint16_t lidar_num);
+
+/**
+ * Run a task on a data io thread, between two rounds of packet handling, so it runs in order
+ * with the point cloud and IMU callbacks of that thread. Thread safe and lock free, may be
+ * called from the data callbacks as well.
+ * @param data_io_thread_index   index of the data io thread, see "data_io_thread_num".
+ * @param cb                     task to run.
+ * @param client_data            user data passed to the task.
+ * @return kLivoxLidarStatusSuccess on successful return, see \ref LivoxLidarStatus for other error code.
+ */
+livox_status LivoxLidarPostDataTask(uint32_t data_io_thread_index, LivoxLidarDataTaskCallback cb, void* client_data);
+
+/**
+ * Kernel receive time of the packet passed to the running point cloud or IMU callback, so the
+ * queueing delay up to the callback can be measured. Only meaningful when called from a data
+ * callback, on the thread that runs it.
+ * @return the receive time in ns since the epoch (CLOCK_REALTIME), 0 if "rx_timestamp_enable" is
+ *         off or the packet came through AF_XDP. The packet ring always provides it.
+ */
+uint64_t LivoxLidarGetRxTimestamp();
+
+/**
+ * Get the IMU delivery latency of a lidar, measured from the kernel receive timestamp to the
+ * IMU callback. The IMU packets are stamped when "imu_io_thread" or "rx_timestamp_enable" is
+ * set, otherwise no latency is recorded.
+ * @param handle                 lidar handle.
+ * @param stats                  filled with the statistics since the sdk was initialized.
+ * @return kLivoxLidarStatusSuccess on successful return, see \ref LivoxLidarStatus for other error code.
+ */
+livox_status GetLivoxLidarImuLatencyStats(uint32_t handle, LivoxLidarImuLatencyStats* stats);
+
+/**
+ * Get the receive buffer size requested for the sockets of a role and the size the kernel
+ * actually granted, see "socket_rcvbuf_KB" and "sdk_profile".
+ * @param role                   socket role.
+ * @param info                   filled with the buffer sizes of the role.
+ * @return kLivoxLidarStatusSuccess on successful return, see \ref LivoxLidarStatus for other error code.
+ */
+livox_status GetLivoxLidarSocketBufferInfo(LivoxLidarSocketRole role, LivoxLidarSocketBufferInfo* info);
+
+/**
+ * Keep the packet passed to the running point cloud callback, IMU callback or point cloud
+ * observer valid after the callback returns, so it can be handed to another thread without a
+ * copy. The receive buffer holding the packet is lent out and goes back to the sdk when the
+ * last reference is released. Only valid when called from a data callback, on the thread that
+ * runs it, with the packet of that callback.
+ * The packets of the packet ring, xdp and io_uring, and the packets arriving when the
+ * "packet_handle_num" spare buffers of the io thread are all lent out, are copied instead, and
+ * *packet then points to the copy.
+ * @param packet                 the packet of the callback, may be replaced with its copy.
+ * @return the handle holding one reference, nullptr on failure.
+ */
+LivoxLidarPacketHandle LivoxLidarAcquirePacket(LivoxLidarEthernetPacket** packet);
+
+/**
+ * Add a reference to an acquired packet. Thread safe.
+ * @param packet_handle          the handle returned by LivoxLidarAcquirePacket.
+ */
+void LivoxLidarRetainPacket(LivoxLidarPacketHandle packet_handle);
+
+/**
+ * Drop a reference to an acquired packet, the packet must not be used once its last reference
+ * is dropped. Thread safe, and may also be called after LivoxLidarSdkUninit.
+ * @param packet_handle          the handle returned by LivoxLidarAcquirePacket.
+ */
+void LivoxLidarReleasePacket(LivoxLidarPacketHandle packet_handle);
+
+/**
+ * Add a point cloud consumer. Unlike an observer, the consumer callback runs on a thread of its
+ * own: the data io threads acquire each point cloud and IMU packet, see LivoxLidarAcquirePacket,
+ * and push it into a lock free ring of the consumer, so a slow consumer can not stall the
+ * lidars. Each data io thread has its own ring, the packets of a lidar keep their order.
+ * Set "packet_handle_num" to cover the rings, otherwise the queued packets are copied.
+ * @param cb                     callback run on the consumer thread, the packet is valid until it returns.
+ * @param client_data            user data passed to the callback.
+ * @param capacity               packets a ring holds, in [1, 65536].
+ * @param policy                 what to do with a packet when the ring is full.
+ * @return the consumer id, 0 on failure.
+ */
+uint16_t LivoxLidarAddPointCloudConsumer(LivoxLidarPointCloudObserver cb, void* client_data, uint32_t capacity,
+                                         LivoxLidarOverflowPolicy policy);
+
+/**
+ * Remove a point cloud consumer, its thread is stopped and its queued packets are dropped.
+ * @param id                     the consumer id.
+ */
+void LivoxLidarRemovePointCloudConsumer(uint16_t id);
+
+/**
+ * Get the delivery and drop counters of a point cloud consumer.
+ * @param id                     the consumer id.
+ * @param stats                  filled with the counters since the consumer was added.
+ * @return kLivoxLidarStatusSuccess on successful return, see \ref LivoxLidarStatus for other error code.
+ */
+livox_status GetLivoxLidarConsumerStats(uint16_t id, LivoxLidarConsumerStats* stats);
+
+/**
+ * Receive the point cloud and IMU data on the calling thread, which requires "data_poll_enable".
+ * The data sockets are then left out of the data io threads, each call reads the pending
+ * datagrams straight into the caller buffers and passes them on like a data io thread does,
+ * so the callbacks, observers and consumers still get them, on the calling thread. Call it
+ * from one thread at a time, LivoxLidarSdkUninit waits for a running call to return.
+ * The sdk may swap the entries of buffers while it skips datagrams which are no lidar data,
+ * read each returned packet through its own buf.
+ * @param buffers                receive slots, the first return value entries are filled.
+ * @param max_packets            number of slots.
+ * @param timeout_us             time to wait when no packet is pending, 0 returns at once.
+ * @return the number of packets received, 0 on timeout, -1 if polling is not enabled.
+ */
+int32_t LivoxLidarPollData(LivoxLidarPollBuffer* buffers, uint32_t max_packets, uint32_t timeout_us);
 
 #ifdef __cplusplus
 }
@@ -30,6 +30,14 @@
     #include <sys/time.h>
     #include <unistd.h>
     #define HAVE_EPOLL 1
+    #define HAVE_PACKET_RING 1
+    #define HAVE_TIMERFD 1
+    #define HAVE_EVENTFD 1
+    #if defined(__has_include)
+        #if __has_include(<linux/if_xdp.h>) && __has_include(<linux/bpf.h>)
+            #define HAVE_XDP 1
+        #endif
+    #endif
 #elif defined(_WIN32)
     #include <winsock2.h>
     #define HAVE_SELECT 1
@@ -27,7 +27,7 @@
 
 #include <stdint.h>
 
-#define kMaxLidarCount 32
+#define kMaxLidarCount 256
 
 #pragma pack(1)
 
@@ -577,4 +577,91 @@ typedef void (*OnLivoxLidarUpgradeProgressCallback)(uint32_t handle, LivoxLidarU
  */
 typedef void (*LivoxLidarRmcSyncTimeCallBack)(livox_status status, uint32_t handle, LivoxLidarRmcSyncTimeResponse* data, void* client_data);
 
+/**
+ * Task run on a data io thread.
+ * @param client_data            user data associated with the task.
+ */
+typedef void (*LivoxLidarDataTaskCallback)(void* client_data);
+
+/**
+ * Delay from the kernel receiving an IMU packet of a lidar to the IMU callback being called.
+ */
+typedef struct {
+  uint64_t packet_count;      /**< IMU packets with a receive timestamp. */
+  uint64_t avg_latency_ns;
+  uint64_t max_latency_ns;
+  uint64_t last_latency_ns;
+} LivoxLidarImuLatencyStats;
+
+/**
+ * Traffic a host socket carries, the receive buffer of a socket is sized by its role.
+ */
+typedef enum {
+  kLivoxLidarSocketPoint = 0,    /**< point cloud data. */
+  kLivoxLidarSocketImu = 1,      /**< imu data. */
+  kLivoxLidarSocketCmd = 2,      /**< commands and lidar detection. */
+  kLivoxLidarSocketPush = 3,     /**< pushed lidar status and faults. */
+  kLivoxLidarSocketLog = 4,      /**< lidar log files. */
+  kLivoxLidarSocketDebug = 5,    /**< debug point cloud. */
+  kLivoxLidarSocketRoleNum = 6
+} LivoxLidarSocketRole;
+
+typedef struct {
+  uint32_t socket_num;           /**< open sockets of the role. */
+  uint32_t requested_size;       /**< SO_RCVBUF requested in bytes, 0 keeps the kernel default. */
+  uint32_t effective_size;       /**< SO_RCVBUF granted by the kernel in bytes, comparable to requested_size: the
+                                      kernel clamps the request to net.core.rmem_max, and the doubled value Linux
+                                      reports for its bookkeeping is halved. */
+} LivoxLidarSocketBufferInfo;
+
+/**
+ * Reference on a point cloud or IMU packet kept past its callback, see LivoxLidarAcquirePacket.
+ */
+typedef void* LivoxLidarPacketHandle;
+
+/**
+ * A packet of a batch passed to a LivoxLidarPointCloudBatchObserver.
+ */
+typedef struct {
+  uint32_t handle;                     /**< lidar handle. */
+  uint8_t dev_type;                    /**< device type of the lidar. */
+  LivoxLidarEthernetPacket* data;      /**< point cloud or IMU packet. */
+} LivoxLidarBatchPacket;
+
+/**
+ * Callback function for a point cloud batch observer.
+ * @param packets                the packets received by one receive batch of a data io thread.
+ * @param packet_num             number of packets.
+ * @param client_data            user data associated with the observer.
+ */
+typedef void (*LivoxLidarPointCloudBatchObserver)(const LivoxLidarBatchPacket* packets, uint32_t packet_num, void* client_data);
+
+/**
+ * What a data io thread does with a packet when the ring of a consumer is full.
+ */
+typedef enum {
+  kLivoxLidarOverflowDropOldest = 0,   /**< drop the oldest queued packet, the consumer sees the latest data. */
+  kLivoxLidarOverflowDropNewest = 1,   /**< drop the arriving packet, the consumer sees a gap-free prefix. */
+  kLivoxLidarOverflowBlock = 2         /**< wait for room, a slow consumer then stalls the lidars of that io thread. */
+} LivoxLidarOverflowPolicy;
+
+typedef struct {
+  uint32_t capacity;                   /**< packets a ring holds, one ring per data io thread. */
+  uint32_t queued_num;                 /**< packets waiting in the rings. */
+  uint64_t delivered_count;            /**< packets passed to the consumer callback. */
+  uint64_t dropped_count;              /**< packets dropped by the overflow policy. */
+} LivoxLidarConsumerStats;
+
+/**
+ * A receive slot of LivoxLidarPollData, the caller sets buf and buf_size, the sdk fills in the rest.
+ */
+typedef struct {
+  uint8_t* buf;                        /**< receives a LivoxLidarEthernetPacket, at least 1500 bytes. */
+  uint32_t buf_size;                   /**< size of buf. */
+  uint32_t size;                       /**< bytes of the packet in buf. */
+  uint32_t handle;                     /**< lidar handle. */
+  uint8_t dev_type;                    /**< device type of the lidar. */
+  uint64_t timestamp;                  /**< kernel receive time in ns since the epoch, 0 without "rx_timestamp_enable". */
+} LivoxLidarPollBuffer;
+
 #endif  // LIVOX_LIDAR_DEF_H_
@@ -0,0 +1,100 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef LIVOX_LIDAR_PACKET_HPP_
+#define LIVOX_LIDAR_PACKET_HPP_
+
+#include <utility>
+
+#include "livox_lidar_api.h"
+#include "livox_lidar_def.h"
+
+namespace livox {
+namespace lidar {
+
+/**
+ * Owns one reference on an acquired packet, a C++ wrapper of LivoxLidarAcquirePacket and
+ * LivoxLidarReleasePacket. Copying adds a reference, the packet goes back to the sdk when the
+ * last copy is destroyed.
+ *
+ *   void PointCloudCallback(uint32_t handle, const uint8_t dev_type, LivoxLidarEthernetPacket* data, void* client_data) {
+ *     livox::lidar::PacketPtr packet = livox::lidar::PacketPtr::Acquire(data);
+ *     if (packet) {
+ *       queue.push(std::move(packet));
+ *     }
+ *   }
+ */
+class PacketPtr {
+ public:
+  PacketPtr() : handle_(nullptr), packet_(nullptr) {}
+  ~PacketPtr() { Reset(); }
+
+  PacketPtr(const PacketPtr& other) : handle_(other.handle_), packet_(other.packet_) {
+    if (handle_ != nullptr) {
+      LivoxLidarRetainPacket(handle_);
+    }
+  }
+  PacketPtr(PacketPtr&& other) : handle_(other.handle_), packet_(other.packet_) {
+    other.handle_ = nullptr;
+    other.packet_ = nullptr;
+  }
+  PacketPtr& operator=(PacketPtr other) {
+    std::swap(handle_, other.handle_);
+    std::swap(packet_, other.packet_);
+    return *this;
+  }
+
+  /** Only valid in a data callback with the packet of that callback, empty on failure. */
+  static PacketPtr Acquire(LivoxLidarEthernetPacket* packet) {
+    PacketPtr packet_ptr;
+    packet_ptr.handle_ = LivoxLidarAcquirePacket(&packet);
+    if (packet_ptr.handle_ != nullptr) {
+      packet_ptr.packet_ = packet;
+    }
+    return packet_ptr;
+  }
+
+  void Reset() {
+    if (handle_ != nullptr) {
+      LivoxLidarReleasePacket(handle_);
+    }
+    handle_ = nullptr;
+    packet_ = nullptr;
+  }
+
+  LivoxLidarEthernetPacket* Get() const { return packet_; }
+  LivoxLidarEthernetPacket* operator->() const { return packet_; }
+  LivoxLidarEthernetPacket& operator*() const { return *packet_; }
+  explicit operator bool() const { return packet_ != nullptr; }
+
+ private:
+  LivoxLidarPacketHandle handle_;
+  LivoxLidarEthernetPacket* packet_;
+};
+
+} // namespace lidar
+}  // namespace livox
+
+#endif  // LIVOX_LIDAR_PACKET_HPP_
@@ -0,0 +1,189 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef LIVOX_LIDAR_SUBSCRIBE_HPP_
+#define LIVOX_LIDAR_SUBSCRIBE_HPP_
+
+#include <stdint.h>
+#include <type_traits>
+#include <utility>
+
+#include "livox_lidar_api.h"
+#include "livox_lidar_def.h"
+
+namespace livox {
+namespace lidar {
+
+/** The data_type of the packets carrying points of type T. */
+template <typename T>
+struct PointDataType;
+
+template <>
+struct PointDataType<LivoxLidarCartesianHighRawPoint> {
+  static const uint8_t value = kLivoxLidarCartesianCoordinateHighData;
+};
+
+template <>
+struct PointDataType<LivoxLidarCartesianLowRawPoint> {
+  static const uint8_t value = kLivoxLidarCartesianCoordinateLowData;
+};
+
+template <>
+struct PointDataType<LivoxLidarSpherPoint> {
+  static const uint8_t value = kLivoxLidarSphericalCoordinateData;
+};
+
+template <>
+struct PointDataType<LivoxLidarImuRawPoint> {
+  static const uint8_t value = kLivoxLidarImuData;
+};
+
+/** The points of one packet, valid until the handler returns. */
+template <typename T>
+class PointSpan {
+ public:
+  PointSpan(const T* data, uint32_t size) : data_(data), size_(size) {}
+
+  const T* data() const { return data_; }
+  uint32_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const T* begin() const { return data_; }
+  const T* end() const { return data_ + size_; }
+  const T& operator[](uint32_t index) const { return data_[index]; }
+
+ private:
+  const T* data_;
+  uint32_t size_;
+};
+
+/** The little endian timestamp of a packet, in ns. */
+inline uint64_t GetPacketTimestamp(const LivoxLidarEthernetPacket* packet) {
+  uint64_t timestamp = 0;
+  for (int i = 7; i >= 0; --i) {
+    timestamp = (timestamp << 8) | packet->timestamp[i];
+  }
+  return timestamp;
+}
+
+/**
+ * Owns a point cloud observer added by Subscribe, the observer is removed when the
+ * subscription is reset or destroyed. Do not reset it inside a data callback, the handler
+ * may still run on another data io thread then.
+ */
+class Subscription {
+ public:
+  Subscription() : id_(0), handler_(nullptr), deleter_(nullptr) {}
+  ~Subscription() { Reset(); }
+
+  Subscription(const Subscription&) = delete;
+  Subscription& operator=(const Subscription&) = delete;
+  Subscription(Subscription&& other) : id_(other.id_), handler_(other.handler_), deleter_(other.deleter_) {
+    other.id_ = 0;
+    other.handler_ = nullptr;
+    other.deleter_ = nullptr;
+  }
+  Subscription& operator=(Subscription&& other) {
+    if (this != &other) {
+      Reset();
+      std::swap(id_, other.id_);
+      std::swap(handler_, other.handler_);
+      std::swap(deleter_, other.deleter_);
+    }
+    return *this;
+  }
+
+  void Reset() {
+    if (id_ != 0) {
+      // Returns once no data io thread runs the handler any more.
+      LivoxLidarRemovePointCloudObserver(id_);
+    }
+    if (handler_ != nullptr) {
+      deleter_(handler_);
+    }
+    id_ = 0;
+    handler_ = nullptr;
+    deleter_ = nullptr;
+  }
+
+  uint16_t GetId() const { return id_; }
+  explicit operator bool() const { return id_ != 0; }
+
+ private:
+  template <typename T, typename Handler>
+  friend Subscription Subscribe(Handler&& handler);
+
+  // Registered for the packets of type T only, the SDK does not call it for the others.
+  template <typename T, typename Handler>
+  static void Dispatch(uint32_t handle, const uint8_t dev_type, LivoxLidarEthernetPacket* data, void* client_data) {
+    (*static_cast<Handler*>(client_data))(handle, PointSpan<T>(reinterpret_cast<const T*>(data->data), data->dot_num),
+                                          GetPacketTimestamp(data));
+  }
+
+  template <typename Handler>
+  static void Delete(void* handler) {
+    delete static_cast<Handler*>(handler);
+  }
+
+  uint16_t id_;
+  void* handler_;
+  void (*deleter_)(void*);
+};
+
+/**
+ * Subscribe to the packets of one point type, T is LivoxLidarCartesianHighRawPoint,
+ * LivoxLidarCartesianLowRawPoint, LivoxLidarSpherPoint or LivoxLidarImuRawPoint. The handler
+ * is called on the data io threads as handler(handle, points, timestamp) for every packet of
+ * that type, points is a PointSpan<T> and timestamp the decoded packet timestamp in ns. The
+ * handler type is kept and the SDK only calls it for packets of type T through a plain function
+ * pointer, so there is no std::function and no type check per packet.
+ *
+ *   livox::lidar::Subscription subscription = livox::lidar::Subscribe<LivoxLidarCartesianHighRawPoint>(
+ *       [](uint32_t handle, const livox::lidar::PointSpan<LivoxLidarCartesianHighRawPoint>& points, uint64_t timestamp) {
+ *         for (const LivoxLidarCartesianHighRawPoint& point : points) {
+ *           ...
+ *         }
+ *       });
+ *
+ * @return the subscription, empty on failure.
+ */
+template <typename T, typename Handler>
+Subscription Subscribe(Handler&& handler) {
+  typedef typename std::decay<Handler>::type HandlerType;
+  Subscription subscription;
+  HandlerType* handler_ptr = new HandlerType(std::forward<Handler>(handler));
+  subscription.id_ = LivoxLidarAddPointCloudTypeObserver(PointDataType<T>::value, &Subscription::Dispatch<T, HandlerType>,
+                                                         handler_ptr);
+  if (subscription.id_ == 0) {
+    delete handler_ptr;
+    return subscription;
+  }
+  subscription.handler_ = handler_ptr;
+  subscription.deleter_ = &Subscription::Delete<HandlerType>;
+  return subscription;
+}
+
+} // namespace lidar
+}  // namespace livox
+
+#endif  // LIVOX_LIDAR_SUBSCRIBE_HPP_
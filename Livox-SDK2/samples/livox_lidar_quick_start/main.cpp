@@ -24,6 +24,7 @@
 
 #include "livox_lidar_def.h"
 #include "livox_lidar_api.h"
+#include "livox_lidar_subscribe.hpp"
 
 #ifdef _WIN32
 #include <winsock2.h>
@@ -32,6 +33,7 @@
 #include <arpa/inet.h>
 #endif
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -42,6 +44,9 @@
 #include <ctime>
 #include <sstream>
 #include <iomanip>
+
+using livox::lidar::PointSpan;
+
 bool isFileEmpty(const std::string& filename) {
     std::ifstream file(filename, std::ios::ate); // 開啟檔案並移動到檔案末尾
     return file.tellg() == 0; // 如果檔案大小為 0，則檔案為空
@@ -92,7 +97,7 @@ std::ofstream openCsvFile(int isPointCloud) {
     return csv_file;
 }
 
-void PointCloudSaveAsCsv(LivoxLidarCartesianHighRawPoint *p_point_data, int dot_num, double timestamp_64){
+void PointCloudSaveAsCsv(const LivoxLidarCartesianHighRawPoint *p_point_data, int dot_num, double timestamp_64){
   int isPointCloud = 1;
   std::ofstream csv_file = openCsvFile(isPointCloud);
 
@@ -119,7 +124,7 @@ void PointCloudSaveAsCsv(LivoxLidarCartesianHighRawPoint *p_point_data, int dot_
   }
   csv_file.close();  
 }
-void ImuCloudSaveAsCsv(LivoxLidarImuRawPoint *imu_point_data, int dot_num, double timestamp_64){
+void ImuCloudSaveAsCsv(const LivoxLidarImuRawPoint *imu_point_data, int dot_num, double timestamp_64){
   int isPointCloud = 0;
   std::ofstream csv_file = openCsvFile(isPointCloud);
   printf("data_num: %d\n", dot_num);
@@ -137,55 +142,32 @@ void ImuCloudSaveAsCsv(LivoxLidarImuRawPoint *imu_point_data, int dot_num, doubl
   
   csv_file.close();  
 }
-void PointCloudCallback(uint32_t handle, const uint8_t dev_type, LivoxLidarEthernetPacket* data, void* client_data) {
-  if (data == nullptr) {
-    return;
-  }
+void CartesianHighPointHandler(uint32_t handle, const PointSpan<LivoxLidarCartesianHighRawPoint>& points, uint64_t timestamp) {
+  double timestamp_ms = static_cast<double>(timestamp) / 1e6;
+  PointCloudSaveAsCsv(points.data(), points.size(), timestamp_ms);
+}
 
-  if (data->data_type == kLivoxLidarCartesianCoordinateHighData) {  
-    LivoxLidarCartesianHighRawPoint *p_point_data = (LivoxLidarCartesianHighRawPoint *)data->data;
-    u_int64 timestamp_64 = 0;
-    for(int i = 0; i < 8; i++){
-      timestamp_64 |= static_cast<uint64_t>(data->timestamp[i]) << ((i) * 8); //先轉成 uint64_t 再左移會比較準確及安全
-    }
-    double timestamp_ms = static_cast<double>(timestamp_64) / 1e6;
-    PointCloudSaveAsCsv(p_point_data, data->dot_num, timestamp_ms);
-  }
-  else if (data->data_type == kLivoxLidarCartesianCoordinateLowData) {
-    LivoxLidarCartesianLowRawPoint *p_point_data = (LivoxLidarCartesianLowRawPoint *)data->data;
-    for (uint32_t i = 0; i < data->dot_num; i++) {
-      printf("Point %d: x: %u, y: %u, z: %u\n", i, p_point_data[i].x, p_point_data[i].y, p_point_data[i].z);
-    }
-  } else if (data->data_type == kLivoxLidarSphericalCoordinateData) {
-    LivoxLidarSpherPoint* p_point_data = (LivoxLidarSpherPoint *)data->data;
-    for (uint32_t i = 0; i < data->dot_num; i++) {
-      printf("Point %d: depth: %u, theta: %u, phi: %u\n", i, p_point_data[i].depth, p_point_data[i].theta, p_point_data[i].phi);
-    }
+void CartesianLowPointHandler(uint32_t handle, const PointSpan<LivoxLidarCartesianLowRawPoint>& points, uint64_t timestamp) {
+  for (uint32_t i = 0; i < points.size(); i++) {
+    printf("Point %d: x: %d, y: %d, z: %d\n", i, points[i].x, points[i].y, points[i].z);
   }
 }
 
+void SpherPointHandler(uint32_t handle, const PointSpan<LivoxLidarSpherPoint>& points, uint64_t timestamp) {
+  for (uint32_t i = 0; i < points.size(); i++) {
+    printf("Point %d: depth: %u, theta: %u, phi: %u\n", i, points[i].depth, points[i].theta, points[i].phi);
+  }
+}
 
-void ImuDataCallback(uint32_t handle, const uint8_t dev_type,  LivoxLidarEthernetPacket* data, void* client_data) {
-    if (data == nullptr) {
-      return;
-    } 
-    if (data->data_type == kLivoxLidarImuData) {    //確認是否為imu數據
-      LivoxLidarImuRawPoint *imu_point_data = (LivoxLidarImuRawPoint *)data->data;
-      u_int64 timestamp_64 = 0;
-      for(int i = 0; i < 8; i++){
-        timestamp_64 |= static_cast<uint64_t>(data->timestamp[i]) << (i * 8);
-      
-      printf("IMU_timestamp: %llu\n", timestamp_64);
-      // printf("IMU_time_interval: %d * 0.1 us\n", data->time_interval);
-      double timestamp_float = static_cast<double>(timestamp_64) / 1000.0;
-      for (uint32_t i = 0; i < data->dot_num; i++) {
-        printf("Imu Point %d: gyro_x: %f, gyro_y: %f, gyro_z: %f, acc_x: %f, acc_y: %f, acc_z: %f\n", i, 
-          imu_point_data[i].gyro_x, imu_point_data[i].gyro_y, imu_point_data[i].gyro_z, 
-          imu_point_data[i].acc_x, imu_point_data[i].acc_y, imu_point_data[i].acc_z);
-      }
-      ImuCloudSaveAsCsv(imu_point_data, data->dot_num, timestamp_float);
-    }
+void ImuPointHandler(uint32_t handle, const PointSpan<LivoxLidarImuRawPoint>& points, uint64_t timestamp) {
+  printf("IMU_timestamp: %llu\n", static_cast<unsigned long long>(timestamp));
+  for (uint32_t i = 0; i < points.size(); i++) {
+    printf("Imu Point %d: gyro_x: %f, gyro_y: %f, gyro_z: %f, acc_x: %f, acc_y: %f, acc_z: %f\n", i,
+      points[i].gyro_x, points[i].gyro_y, points[i].gyro_z,
+      points[i].acc_x, points[i].acc_y, points[i].acc_z);
   }
+  double timestamp_ms = static_cast<double>(timestamp) / 1e6;
+  ImuCloudSaveAsCsv(points.data(), points.size(), timestamp_ms);
 }
 
 // void OnLidarSetIpCallback(livox_vehicle_status status, uint32_t handle, uint8_t ret_code, void*) {
@@ -315,9 +297,24 @@ int main(int argc, const char *argv[]) {
   }
 
 
-  SetLivoxLidarPointCloudCallBack(PointCloudCallback, nullptr);
-
-  // SetLivoxLidarImuDataCallback(ImuDataCallback, nullptr);
+  // Each subscription gets the packets of one point type, with the points typed and the timestamp decoded.
+  livox::lidar::Subscription high_point_subscription = livox::lidar::Subscribe<LivoxLidarCartesianHighRawPoint>(
+      [](uint32_t handle, const PointSpan<LivoxLidarCartesianHighRawPoint>& points, uint64_t timestamp) {
+        CartesianHighPointHandler(handle, points, timestamp);
+      });
+  livox::lidar::Subscription low_point_subscription = livox::lidar::Subscribe<LivoxLidarCartesianLowRawPoint>(
+      [](uint32_t handle, const PointSpan<LivoxLidarCartesianLowRawPoint>& points, uint64_t timestamp) {
+        CartesianLowPointHandler(handle, points, timestamp);
+      });
+  livox::lidar::Subscription spher_point_subscription = livox::lidar::Subscribe<LivoxLidarSpherPoint>(
+      [](uint32_t handle, const PointSpan<LivoxLidarSpherPoint>& points, uint64_t timestamp) {
+        SpherPointHandler(handle, points, timestamp);
+      });
+
+  // livox::lidar::Subscription imu_subscription = livox::lidar::Subscribe<LivoxLidarImuRawPoint>(
+  //     [](uint32_t handle, const PointSpan<LivoxLidarImuRawPoint>& points, uint64_t timestamp) {
+  //       ImuPointHandler(handle, points, timestamp);
+  //     });
 
   
   SetLivoxLidarInfoCallback(LivoxLidarPushMsgCallback, nullptr);
@@ -331,6 +328,9 @@ int main(int argc, const char *argv[]) {
 #else
   sleep(300);
 #endif
+  high_point_subscription.Reset();
+  low_point_subscription.Reset();
+  spher_point_subscription.Reset();
   LivoxLidarSdkUninit();
   printf("Livox Quick Start Demo End!\n");
   return 0;
@@ -0,0 +1,306 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "packet_ring.h"
+#include "base/logging.h"
+
+#include <string.h>
+
+#ifdef HAVE_PACKET_RING
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#endif
+
+namespace livox {
+namespace lidar {
+
+static const uint8_t kIpProtoUdp = 17;
+static const size_t kMaxCapturePortNum = 64;
+
+bool ParseUdpDatagram(const uint8_t* data, uint32_t len, uint32_t& handle, uint16_t& src_port,
+                      uint16_t& dst_port, const uint8_t*& payload, uint32_t& payload_len) {
+  if (len < 20 || (data[0] >> 4) != 4 || data[9] != kIpProtoUdp) {
+    return false;
+  }
+  uint32_t ip_header_len = (data[0] & 0x0f) * 4;
+  uint16_t total_len = (data[2] << 8) | data[3];
+  uint16_t frag = ((data[6] << 8) | data[7]) & 0x3fff;  // MF flag and fragment offset.
+  if (frag != 0 || ip_header_len < 20 || total_len > len || total_len < ip_header_len + 8) {
+    return false;
+  }
+
+  const uint8_t* udp = data + ip_header_len;
+  uint16_t udp_len = (udp[4] << 8) | udp[5];
+  if (udp_len < 8 || udp_len > total_len - ip_header_len) {
+    return false;
+  }
+  memcpy(&handle, data + 12, sizeof(handle));
+  src_port = (udp[0] << 8) | udp[1];
+  dst_port = (udp[2] << 8) | udp[3];
+  payload = udp + 8;
+  payload_len = udp_len - 8;
+  return true;
+}
+
+#ifdef HAVE_PACKET_RING
+
+PacketRing::PacketRing()
+    : fd_(-1),
+      ring_(nullptr),
+      ring_size_(0),
+      block_size_(0),
+      block_num_(0),
+      block_index_(0),
+      cb_(nullptr),
+      batch_cb_(nullptr),
+      packet_count_(0),
+      drop_count_(0) {}
+
+PacketRing::~PacketRing() {
+  Uninit();
+}
+
+bool PacketRing::Init(const PacketRingCfg& cfg, const std::vector<uint16_t>& dst_ports, bool join_fanout,
+                      const CapturePacketCallback& cb) {
+  if (dst_ports.empty() || dst_ports.size() > kMaxCapturePortNum || cfg.block_num == 0 || cfg.block_size == 0) {
+    LOG_ERROR("Init packet ring failed, the port num {} or the block cfg is invalid.", dst_ports.size());
+    return false;
+  }
+  cb_ = cb;
+  block_size_ = cfg.block_size;
+  block_num_ = cfg.block_num;
+
+  // SOCK_DGRAM strips the link layer header, both the filter and the frames start at the ip header.
+  fd_ = socket(AF_PACKET, SOCK_DGRAM, htons(ETH_P_IP));
+  if (fd_ < 0) {
+    LOG_ERROR("Create packet socket failed, errno: {}, CAP_NET_RAW is required.", errno);
+    return false;
+  }
+
+  // Install the filter before binding so no unfiltered traffic reaches the ring.
+  if (!AttachFilter(dst_ports)) {
+    Uninit();
+    return false;
+  }
+
+  int version = TPACKET_V3;
+  if (setsockopt(fd_, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0) {
+    LOG_ERROR("Set TPACKET_V3 failed, errno: {}", errno);
+    Uninit();
+    return false;
+  }
+
+  struct tpacket_req3 req;
+  memset(&req, 0, sizeof(req));
+  req.tp_block_size = block_size_;
+  req.tp_block_nr = block_num_;
+  req.tp_frame_size = TPACKET_ALIGNMENT << 7;
+  req.tp_frame_nr = (block_size_ / req.tp_frame_size) * block_num_;
+  req.tp_retire_blk_tov = cfg.block_timeout_ms;
+  if (setsockopt(fd_, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) != 0) {
+    LOG_ERROR("Set packet rx ring failed, block_size: {}, block_num: {}, errno: {}", block_size_, block_num_, errno);
+    Uninit();
+    return false;
+  }
+
+  ring_size_ = static_cast<size_t>(block_size_) * block_num_;
+  void* ring = mmap(nullptr, ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, fd_, 0);
+  if (ring == MAP_FAILED) {
+    ring = mmap(nullptr, ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  }
+  if (ring == MAP_FAILED) {
+    LOG_ERROR("Map packet rx ring failed, errno: {}", errno);
+    ring_size_ = 0;
+    Uninit();
+    return false;
+  }
+  ring_ = static_cast<uint8_t*>(ring);
+
+  struct sockaddr_ll addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sll_family = AF_PACKET;
+  addr.sll_protocol = htons(ETH_P_IP);
+  if (!cfg.netif.empty()) {
+    addr.sll_ifindex = if_nametoindex(cfg.netif.c_str());
+    if (addr.sll_ifindex == 0) {
+      LOG_ERROR("Can not find the capture interface {}", cfg.netif);
+      Uninit();
+      return false;
+    }
+  }
+  if (bind(fd_, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+    LOG_ERROR("Bind packet socket failed, errno: {}", errno);
+    Uninit();
+    return false;
+  }
+
+  if (join_fanout) {
+    uint16_t fanout_id = static_cast<uint16_t>(getpid() & 0xffff);
+    int fanout = fanout_id | (PACKET_FANOUT_HASH << 16);
+    if (setsockopt(fd_, SOL_PACKET, PACKET_FANOUT, &fanout, sizeof(fanout)) != 0) {
+      LOG_ERROR("Join packet fanout group {} failed, errno: {}", fanout_id, errno);
+      Uninit();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PacketRing::AttachFilter(const std::vector<uint16_t>& dst_ports) {
+  // Accept unfragmented udp datagrams received for one of dst_ports, frames sent by this host
+  // show up as PACKET_OUTGOING on the loopback and are rejected.
+  std::vector<struct sock_filter> code;
+  uint8_t port_num = static_cast<uint8_t>(dst_ports.size());
+  code.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_ABS, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_PKTTYPE)));
+  code.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, static_cast<uint8_t>(port_num + 6), 0));
+  code.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9));
+  code.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, kIpProtoUdp, 0, static_cast<uint8_t>(port_num + 4)));
+  code.push_back(BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6));
+  code.push_back(BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x3fff, static_cast<uint8_t>(port_num + 2), 0));
+  code.push_back(BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0));
+  code.push_back(BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2));
+  for (uint8_t i = 0; i < port_num; ++i) {
+    code.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, dst_ports[i], static_cast<uint8_t>(port_num - i), 0));
+  }
+  code.push_back(BPF_STMT(BPF_RET | BPF_K, 0));
+  code.push_back(BPF_STMT(BPF_RET | BPF_K, 0x40000));
+
+  struct sock_fprog prog;
+  prog.len = static_cast<unsigned short>(code.size());
+  prog.filter = code.data();
+  if (setsockopt(fd_, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) != 0) {
+    LOG_ERROR("Attach packet filter failed, errno: {}", errno);
+    return false;
+  }
+  return true;
+}
+
+void PacketRing::Uninit() {
+  if (ring_ != nullptr) {
+    munmap(ring_, ring_size_);
+    ring_ = nullptr;
+    ring_size_ = 0;
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+void PacketRing::OnData(socket_t sock, void *client_data) {
+  if (ring_ == nullptr) {
+    return;
+  }
+
+  while (true) {
+    struct tpacket_block_desc* block = (struct tpacket_block_desc*)(ring_ + static_cast<size_t>(block_index_) * block_size_);
+    if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0) {
+      break;
+    }
+
+    uint32_t num_pkts = block->hdr.bh1.num_pkts;
+    uint32_t packets = 0;
+    struct tpacket3_hdr* frame = (struct tpacket3_hdr*)((uint8_t*)block + block->hdr.bh1.offset_to_first_pkt);
+    for (uint32_t i = 0; i < num_pkts; ++i) {
+      uint32_t handle = 0;
+      uint16_t src_port = 0;
+      uint16_t dst_port = 0;
+      const uint8_t* payload = nullptr;
+      uint32_t payload_len = 0;
+      if (ParseUdpDatagram((uint8_t*)frame + frame->tp_net, frame->tp_snaplen, handle, src_port, dst_port,
+                           payload, payload_len)) {
+        ++packet_count_;
+        ++packets;
+        if (cb_) {
+          cb_(handle, src_port, const_cast<uint8_t*>(payload), payload_len,
+              static_cast<uint64_t>(frame->tp_sec) * 1000000000ULL + frame->tp_nsec);
+        }
+      }
+      frame = (struct tpacket3_hdr*)((uint8_t*)frame + frame->tp_next_offset);
+    }
+    if (batch_cb_) {
+      batch_cb_(packets);
+    }
+
+    __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+    block_index_ = (block_index_ + 1) % block_num_;
+  }
+}
+
+uint64_t PacketRing::GetDropCount() {
+  if (fd_ >= 0) {
+    struct tpacket_stats_v3 stats;
+    socklen_t len = sizeof(stats);
+    if (getsockopt(fd_, SOL_PACKET, PACKET_STATISTICS, &stats, &len) == 0) {
+      drop_count_ += stats.tp_drops;
+    }
+  }
+  return drop_count_;
+}
+
+#else
+
+PacketRing::PacketRing()
+    : fd_(-1),
+      ring_(nullptr),
+      ring_size_(0),
+      block_size_(0),
+      block_num_(0),
+      block_index_(0),
+      cb_(nullptr),
+      batch_cb_(nullptr),
+      packet_count_(0),
+      drop_count_(0) {}
+
+PacketRing::~PacketRing() {}
+
+bool PacketRing::Init(const PacketRingCfg& cfg, const std::vector<uint16_t>& dst_ports, bool join_fanout,
+                      const CapturePacketCallback& cb) {
+  LOG_ERROR("The packet ring is only supported on Linux.");
+  return false;
+}
+
+void PacketRing::Uninit() {}
+
+void PacketRing::OnData(socket_t sock, void *client_data) {}
+
+uint64_t PacketRing::GetDropCount() {
+  return 0;
+}
+
+bool PacketRing::AttachFilter(const std::vector<uint16_t>& dst_ports) {
+  return false;
+}
+
+#endif  // HAVE_PACKET_RING
+
+} // namespace lidar
+}  // namespace livox
@@ -0,0 +1,105 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef LIVOX_PACKET_RING_H_
+#define LIVOX_PACKET_RING_H_
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+#include "base/io_loop.h"
+#include "livox_lidar_cfg.h"
+
+namespace livox {
+namespace lidar {
+
+/**
+ * Udp payload captured below the socket layer, handle is the source ip, port the source port and
+ * timestamp the capture time in ns since the epoch, 0 if the backend has none.
+ */
+typedef std::function<void(uint32_t handle, uint16_t port, uint8_t* buf, uint32_t size, uint64_t timestamp)> CapturePacketCallback;
+
+/**
+ * Called after the payloads of a capture batch were passed to the CapturePacketCallback and
+ * before their memory is given back to the kernel, packets is the number passed.
+ */
+typedef std::function<void(uint32_t packets)> CaptureBatchCallback;
+
+/**
+ * Parse an IPv4 datagram and return its udp payload. Fragments and non udp datagrams are
+ * rejected.
+ */
+bool ParseUdpDatagram(const uint8_t* data, uint32_t len, uint32_t& handle, uint16_t& src_port,
+                      uint16_t& dst_port, const uint8_t*& payload, uint32_t& payload_len);
+
+typedef struct {
+  std::string netif;          /* interface to capture, empty for all interfaces. */
+  uint32_t block_size;        /* bytes of a ring block, a multiple of the page size. */
+  uint32_t block_num;
+  uint32_t block_timeout_ms;  /* a partly filled block is handed over after this time. */
+} PacketRingCfg;
+
+/**
+ * AF_PACKET TPACKET_V3 receive ring. The kernel copies every udp datagram sent to one of
+ * the given destination ports into a memory mapped ring, the ring fd is driven by an io loop
+ * and each readable event walks all blocks handed over by the kernel.
+ * The rings which join the fanout group of the process split the traffic by flow hash, so the
+ * datagrams of a lidar always land on the same ring.
+ */
+class PacketRing : public IOLoop::IOLoopDelegate {
+ public:
+  PacketRing();
+  ~PacketRing();
+  bool Init(const PacketRingCfg& cfg, const std::vector<uint16_t>& dst_ports, bool join_fanout,
+            const CapturePacketCallback& cb);
+  void Uninit();
+  socket_t GetFd() const { return fd_; }
+  void OnData(socket_t sock, void *client_data);
+  /** The batch callback is called once per ring block. */
+  void SetBatchCallback(const CaptureBatchCallback& batch_cb) { batch_cb_ = batch_cb; }
+
+  uint64_t GetPacketCount() const { return packet_count_; }
+  /** Packets dropped by the kernel because the ring was full. */
+  uint64_t GetDropCount();
+
+ private:
+  bool AttachFilter(const std::vector<uint16_t>& dst_ports);
+
+  socket_t fd_;
+  uint8_t* ring_;
+  size_t ring_size_;
+  uint32_t block_size_;
+  uint32_t block_num_;
+  uint32_t block_index_;
+  CapturePacketCallback cb_;
+  CaptureBatchCallback batch_cb_;
+  uint64_t packet_count_;
+  uint64_t drop_count_;
+};
+
+} // namespace lidar
+}  // namespace livox
+
+#endif  // LIVOX_PACKET_RING_H_
@@ -0,0 +1,464 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "xdp_socket.h"
+#include "base/logging.h"
+
+#include <string.h>
+
+#ifdef HAVE_XDP
+#include <arpa/inet.h>
+#include <errno.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/bpf.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#endif
+
+namespace livox {
+namespace lidar {
+
+#ifdef HAVE_XDP
+
+static const uint32_t kXdpFrameSize = 2048;
+static const size_t kEthHeaderSize = 14;
+static const size_t kMaxXdpPortNum = 64;
+
+static int Bpf(int cmd, union bpf_attr* attr) {
+  return static_cast<int>(syscall(__NR_bpf, cmd, attr, sizeof(*attr)));
+}
+
+static struct bpf_insn BpfInsn(uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm) {
+  struct bpf_insn insn;
+  insn.code = code;
+  insn.dst_reg = dst;
+  insn.src_reg = src;
+  insn.off = off;
+  insn.imm = imm;
+  return insn;
+}
+
+XdpProgram::XdpProgram() : ifindex_(0), map_fd_(-1), prog_fd_(-1), link_fd_(-1) {}
+
+XdpProgram::~XdpProgram() {
+  Uninit();
+}
+
+bool XdpProgram::Init(const std::string& netif, const std::vector<uint16_t>& dst_ports, uint32_t max_queue_num) {
+  if (dst_ports.empty() || dst_ports.size() > kMaxXdpPortNum || max_queue_num == 0) {
+    LOG_ERROR("Init xdp program failed, the port num {} or the queue num {} is invalid.", dst_ports.size(), max_queue_num);
+    return false;
+  }
+  ifindex_ = if_nametoindex(netif.c_str());
+  if (ifindex_ == 0) {
+    LOG_ERROR("Can not find the xdp interface {}", netif);
+    return false;
+  }
+
+  union bpf_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.map_type = BPF_MAP_TYPE_XSKMAP;
+  attr.key_size = sizeof(uint32_t);
+  attr.value_size = sizeof(uint32_t);
+  attr.max_entries = max_queue_num;
+  map_fd_ = Bpf(BPF_MAP_CREATE, &attr);
+  if (map_fd_ < 0) {
+    LOG_ERROR("Create xsk map failed, errno: {}", errno);
+    return false;
+  }
+
+  if (!LoadProgram(dst_ports)) {
+    Uninit();
+    return false;
+  }
+
+  memset(&attr, 0, sizeof(attr));
+  attr.link_create.prog_fd = prog_fd_;
+  attr.link_create.target_ifindex = ifindex_;
+  attr.link_create.attach_type = BPF_XDP;
+  attr.link_create.flags = XDP_FLAGS_SKB_MODE;
+  link_fd_ = Bpf(BPF_LINK_CREATE, &attr);
+  if (link_fd_ < 0) {
+    LOG_ERROR("Attach xdp program to {} failed, errno: {}", netif, errno);
+    Uninit();
+    return false;
+  }
+  return true;
+}
+
+bool XdpProgram::LoadProgram(const std::vector<uint16_t>& dst_ports) {
+  // Loads of packet data are in network byte order, so the constants are compared in network
+  // byte order as well. r6 keeps the context, r2/r3 the packet begin/end.
+  std::vector<struct bpf_insn> insns;
+  std::vector<size_t> pass_jumps;
+  std::vector<size_t> redirect_jumps;
+
+  insns.push_back(BpfInsn(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0));
+  insns.push_back(BpfInsn(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_1, 0, 0));  // xdp_md.data
+  insns.push_back(BpfInsn(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_3, BPF_REG_1, 4, 0));  // xdp_md.data_end
+  insns.push_back(BpfInsn(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0));
+  insns.push_back(BpfInsn(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, 42));        // eth + ip + udp
+  pass_jumps.push_back(insns.size());
+  insns.push_back(BpfInsn(BPF_JMP | BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, 0, 0));
+  insns.push_back(BpfInsn(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, 12, 0));  // ether type
+  pass_jumps.push_back(insns.size());
+  insns.push_back(BpfInsn(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, 0, htons(0x0800)));
+  insns.push_back(BpfInsn(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_2, 14, 0));  // version, ihl
+  pass_jumps.push_back(insns.size());
+  insns.push_back(BpfInsn(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, 0, 0x45));
+  insns.push_back(BpfInsn(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_2, 23, 0));  // protocol
+  pass_jumps.push_back(insns.size());
+  insns.push_back(BpfInsn(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, 0, 17));
+  insns.push_back(BpfInsn(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, 20, 0));  // flags, fragment offset
+  insns.push_back(BpfInsn(BPF_ALU64 | BPF_AND | BPF_K, BPF_REG_5, 0, 0, htons(0x3fff)));
+  pass_jumps.push_back(insns.size());
+  insns.push_back(BpfInsn(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, 0, 0));
+  insns.push_back(BpfInsn(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, 36, 0));  // udp dst port
+  for (uint16_t port : dst_ports) {
+    redirect_jumps.push_back(insns.size());
+    insns.push_back(BpfInsn(BPF_JMP | BPF_JEQ | BPF_K, BPF_REG_5, 0, 0, htons(port)));
+  }
+  pass_jumps.push_back(insns.size());
+  insns.push_back(BpfInsn(BPF_JMP | BPF_JA, 0, 0, 0, 0));
+
+  // bpf_redirect_map(&xsk_map, rx_queue_index, XDP_PASS)
+  size_t redirect = insns.size();
+  insns.push_back(BpfInsn(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_6, 16, 0));  // xdp_md.rx_queue_index
+  insns.push_back(BpfInsn(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, map_fd_));
+  insns.push_back(BpfInsn(0, 0, 0, 0, 0));
+  insns.push_back(BpfInsn(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS));
+  insns.push_back(BpfInsn(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map));
+  insns.push_back(BpfInsn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+
+  size_t pass = insns.size();
+  insns.push_back(BpfInsn(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, XDP_PASS));
+  insns.push_back(BpfInsn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+
+  for (size_t index : pass_jumps) {
+    insns[index].off = static_cast<int16_t>(pass - index - 1);
+  }
+  for (size_t index : redirect_jumps) {
+    insns[index].off = static_cast<int16_t>(redirect - index - 1);
+  }
+
+  static const char kLicense[] = "Dual MIT/GPL";
+  std::vector<char> log(64 * 1024, 0);
+  union bpf_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.prog_type = BPF_PROG_TYPE_XDP;
+  attr.insn_cnt = static_cast<uint32_t>(insns.size());
+  attr.insns = reinterpret_cast<uint64_t>(insns.data());
+  attr.license = reinterpret_cast<uint64_t>(kLicense);
+  attr.log_level = 1;
+  attr.log_size = static_cast<uint32_t>(log.size());
+  attr.log_buf = reinterpret_cast<uint64_t>(log.data());
+  prog_fd_ = Bpf(BPF_PROG_LOAD, &attr);
+  if (prog_fd_ < 0) {
+    LOG_ERROR("Load xdp program failed, errno: {}, verifier log: {}", errno, log.data());
+    return false;
+  }
+  return true;
+}
+
+bool XdpProgram::AddSocket(uint32_t queue_id, socket_t xsk_fd) {
+  union bpf_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  uint32_t value = static_cast<uint32_t>(xsk_fd);
+  attr.map_fd = map_fd_;
+  attr.key = reinterpret_cast<uint64_t>(&queue_id);
+  attr.value = reinterpret_cast<uint64_t>(&value);
+  attr.flags = BPF_ANY;
+  if (Bpf(BPF_MAP_UPDATE_ELEM, &attr) != 0) {
+    LOG_ERROR("Add xdp socket of queue {} failed, errno: {}", queue_id, errno);
+    return false;
+  }
+  return true;
+}
+
+void XdpProgram::Uninit() {
+  // Closing the link detaches the program from the interface.
+  if (link_fd_ >= 0) {
+    close(link_fd_);
+    link_fd_ = -1;
+  }
+  if (prog_fd_ >= 0) {
+    close(prog_fd_);
+    prog_fd_ = -1;
+  }
+  if (map_fd_ >= 0) {
+    close(map_fd_);
+    map_fd_ = -1;
+  }
+}
+
+XdpSocket::XdpSocket()
+    : fd_(-1),
+      umem_(nullptr),
+      umem_size_(0),
+      frame_num_(0),
+      fill_ring_(),
+      completion_ring_(),
+      rx_ring_(),
+      cb_(nullptr),
+      batch_cb_(nullptr),
+      packet_count_(0) {}
+
+XdpSocket::~XdpSocket() {
+  Uninit();
+}
+
+bool XdpSocket::Init(uint32_t ifindex, uint32_t queue_id, uint32_t frame_num, const CapturePacketCallback& cb) {
+  cb_ = cb;
+  frame_num_ = 64;
+  while (frame_num_ < frame_num) {
+    frame_num_ <<= 1;
+  }
+
+  fd_ = socket(AF_XDP, SOCK_RAW, 0);
+  if (fd_ < 0) {
+    LOG_ERROR("Create xdp socket failed, errno: {}", errno);
+    return false;
+  }
+
+  umem_size_ = static_cast<size_t>(frame_num_) * kXdpFrameSize;
+  void* umem = mmap(nullptr, umem_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (umem == MAP_FAILED) {
+    LOG_ERROR("Map xdp umem failed, errno: {}", errno);
+    umem_size_ = 0;
+    Uninit();
+    return false;
+  }
+  umem_ = static_cast<uint8_t*>(umem);
+
+  struct xdp_umem_reg umem_reg;
+  memset(&umem_reg, 0, sizeof(umem_reg));
+  umem_reg.addr = reinterpret_cast<uint64_t>(umem_);
+  umem_reg.len = umem_size_;
+  umem_reg.chunk_size = kXdpFrameSize;
+  umem_reg.headroom = 0;
+  if (setsockopt(fd_, SOL_XDP, XDP_UMEM_REG, &umem_reg, sizeof(umem_reg)) != 0) {
+    LOG_ERROR("Register xdp umem failed, errno: {}", errno);
+    Uninit();
+    return false;
+  }
+
+  // The fill ring holds every frame, so returning a received frame never finds it full.
+  int ring_size = static_cast<int>(frame_num_);
+  if (setsockopt(fd_, SOL_XDP, XDP_UMEM_FILL_RING, &ring_size, sizeof(ring_size)) != 0 ||
+      setsockopt(fd_, SOL_XDP, XDP_UMEM_COMPLETION_RING, &ring_size, sizeof(ring_size)) != 0 ||
+      setsockopt(fd_, SOL_XDP, XDP_RX_RING, &ring_size, sizeof(ring_size)) != 0) {
+    LOG_ERROR("Set xdp ring size failed, errno: {}", errno);
+    Uninit();
+    return false;
+  }
+
+  struct xdp_mmap_offsets off;
+  socklen_t optlen = sizeof(off);
+  if (getsockopt(fd_, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) != 0) {
+    LOG_ERROR("Get xdp mmap offsets failed, errno: {}", errno);
+    Uninit();
+    return false;
+  }
+
+  if (!MapRing(fill_ring_, XDP_UMEM_PGOFF_FILL_RING, off.fr.producer, off.fr.consumer, off.fr.desc,
+               sizeof(uint64_t), frame_num_) ||
+      !MapRing(completion_ring_, XDP_UMEM_PGOFF_COMPLETION_RING, off.cr.producer, off.cr.consumer, off.cr.desc,
+               sizeof(uint64_t), frame_num_) ||
+      !MapRing(rx_ring_, XDP_PGOFF_RX_RING, off.rx.producer, off.rx.consumer, off.rx.desc,
+               sizeof(struct xdp_desc), frame_num_)) {
+    Uninit();
+    return false;
+  }
+
+  uint64_t* fill_descs = static_cast<uint64_t*>(fill_ring_.descs);
+  for (uint32_t i = 0; i < frame_num_; ++i) {
+    fill_descs[i] = static_cast<uint64_t>(i) * kXdpFrameSize;
+  }
+  __atomic_store_n(fill_ring_.producer, frame_num_, __ATOMIC_RELEASE);
+
+  struct sockaddr_xdp addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sxdp_family = AF_XDP;
+  addr.sxdp_flags = XDP_COPY;
+  addr.sxdp_ifindex = ifindex;
+  addr.sxdp_queue_id = queue_id;
+  if (bind(fd_, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+    LOG_ERROR("Bind xdp socket to queue {} failed, errno: {}", queue_id, errno);
+    Uninit();
+    return false;
+  }
+  return true;
+}
+
+bool XdpSocket::MapRing(XdpRing& ring, uint64_t offset, uint32_t producer, uint32_t consumer, uint32_t desc,
+                        size_t desc_size, uint32_t size) {
+  ring.map_size = desc + desc_size * size;
+  void* map = mmap(nullptr, ring.map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+  if (map == MAP_FAILED) {
+    LOG_ERROR("Map xdp ring failed, errno: {}", errno);
+    ring.map = nullptr;
+    return false;
+  }
+  ring.map = map;
+  ring.producer = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(map) + producer);
+  ring.consumer = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(map) + consumer);
+  ring.descs = static_cast<uint8_t*>(map) + desc;
+  return true;
+}
+
+void XdpSocket::UnmapRing(XdpRing& ring) {
+  if (ring.map != nullptr) {
+    munmap(ring.map, ring.map_size);
+    ring.map = nullptr;
+  }
+}
+
+void XdpSocket::Uninit() {
+  UnmapRing(rx_ring_);
+  UnmapRing(completion_ring_);
+  UnmapRing(fill_ring_);
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+  if (umem_ != nullptr) {
+    munmap(umem_, umem_size_);
+    umem_ = nullptr;
+    umem_size_ = 0;
+  }
+}
+
+void XdpSocket::OnData(socket_t sock, void *client_data) {
+  if (rx_ring_.map == nullptr) {
+    return;
+  }
+
+  const uint32_t mask = frame_num_ - 1;
+  const struct xdp_desc* rx_descs = static_cast<const struct xdp_desc*>(rx_ring_.descs);
+  uint64_t* fill_descs = static_cast<uint64_t*>(fill_ring_.descs);
+  uint32_t rx_consumer = *rx_ring_.consumer;
+  uint32_t rx_producer = __atomic_load_n(rx_ring_.producer, __ATOMIC_ACQUIRE);
+  uint32_t fill_producer = *fill_ring_.producer;
+  uint32_t packets = 0;
+
+  for (; rx_consumer != rx_producer; ++rx_consumer) {
+    const struct xdp_desc& desc = rx_descs[rx_consumer & mask];
+    const uint8_t* frame = umem_ + desc.addr;
+    uint32_t handle = 0;
+    uint16_t src_port = 0;
+    uint16_t dst_port = 0;
+    const uint8_t* payload = nullptr;
+    uint32_t payload_len = 0;
+    if (desc.len > kEthHeaderSize &&
+        ParseUdpDatagram(frame + kEthHeaderSize, desc.len - kEthHeaderSize, handle, src_port, dst_port,
+                         payload, payload_len)) {
+      ++packet_count_;
+      ++packets;
+      if (cb_) {
+        cb_(handle, src_port, const_cast<uint8_t*>(payload), payload_len, 0);
+      }
+    }
+    fill_descs[fill_producer & mask] = desc.addr & ~static_cast<uint64_t>(kXdpFrameSize - 1);
+    ++fill_producer;
+  }
+  if (batch_cb_) {
+    batch_cb_(packets);
+  }
+
+  __atomic_store_n(rx_ring_.consumer, rx_consumer, __ATOMIC_RELEASE);
+  __atomic_store_n(fill_ring_.producer, fill_producer, __ATOMIC_RELEASE);
+}
+
+uint64_t XdpSocket::GetDropCount() {
+  struct xdp_statistics stats;
+  memset(&stats, 0, sizeof(stats));
+  socklen_t len = sizeof(stats);
+  if (fd_ < 0 || getsockopt(fd_, SOL_XDP, XDP_STATISTICS, &stats, &len) != 0) {
+    return 0;
+  }
+  return stats.rx_dropped + stats.rx_ring_full + stats.rx_fill_ring_empty_descs;
+}
+
+#else
+
+XdpProgram::XdpProgram() : ifindex_(0), map_fd_(-1), prog_fd_(-1), link_fd_(-1) {}
+
+XdpProgram::~XdpProgram() {}
+
+bool XdpProgram::Init(const std::string& netif, const std::vector<uint16_t>& dst_ports, uint32_t max_queue_num) {
+  LOG_ERROR("AF_XDP is not supported on this platform.");
+  return false;
+}
+
+bool XdpProgram::LoadProgram(const std::vector<uint16_t>& dst_ports) {
+  return false;
+}
+
+bool XdpProgram::AddSocket(uint32_t queue_id, socket_t xsk_fd) {
+  return false;
+}
+
+void XdpProgram::Uninit() {}
+
+XdpSocket::XdpSocket()
+    : fd_(-1),
+      umem_(nullptr),
+      umem_size_(0),
+      frame_num_(0),
+      fill_ring_(),
+      completion_ring_(),
+      rx_ring_(),
+      cb_(nullptr),
+      batch_cb_(nullptr),
+      packet_count_(0) {}
+
+XdpSocket::~XdpSocket() {}
+
+bool XdpSocket::Init(uint32_t ifindex, uint32_t queue_id, uint32_t frame_num, const CapturePacketCallback& cb) {
+  return false;
+}
+
+bool XdpSocket::MapRing(XdpRing& ring, uint64_t offset, uint32_t producer, uint32_t consumer, uint32_t desc,
+                        size_t desc_size, uint32_t size) {
+  return false;
+}
+
+void XdpSocket::UnmapRing(XdpRing& ring) {}
+
+void XdpSocket::Uninit() {}
+
+void XdpSocket::OnData(socket_t sock, void *client_data) {}
+
+uint64_t XdpSocket::GetDropCount() {
+  return 0;
+}
+
+#endif  // HAVE_XDP
+
+} // namespace lidar
+}  // namespace livox
@@ -0,0 +1,110 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef LIVOX_XDP_SOCKET_H_
+#define LIVOX_XDP_SOCKET_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "base/io_loop.h"
+#include "packet_ring.h"
+#include "livox_lidar_cfg.h"
+
+namespace livox {
+namespace lidar {
+
+/**
+ * XDP program attached to an interface in generic (SKB) mode. Ipv4 udp datagrams sent to
+ * one of the given destination ports are redirected to the AF_XDP socket of the rx queue
+ * they arrive on, every other frame, or a frame of a queue without socket, continues up the
+ * normal network stack.
+ */
+class XdpProgram {
+ public:
+  XdpProgram();
+  ~XdpProgram();
+  bool Init(const std::string& netif, const std::vector<uint16_t>& dst_ports, uint32_t max_queue_num);
+  void Uninit();
+  bool AddSocket(uint32_t queue_id, socket_t xsk_fd);
+  uint32_t GetIfindex() const { return ifindex_; }
+
+ private:
+  bool LoadProgram(const std::vector<uint16_t>& dst_ports);
+
+  uint32_t ifindex_;
+  int map_fd_;
+  int prog_fd_;
+  int link_fd_;
+};
+
+/**
+ * AF_XDP socket bound to one rx queue in copy mode. The umem frames are cycled between the
+ * fill ring and the rx ring, each readable event drains the rx ring, passes the udp payloads
+ * to the callback and gives the frames back to the kernel.
+ */
+class XdpSocket : public IOLoop::IOLoopDelegate {
+ public:
+  XdpSocket();
+  ~XdpSocket();
+  bool Init(uint32_t ifindex, uint32_t queue_id, uint32_t frame_num, const CapturePacketCallback& cb);
+  void Uninit();
+  socket_t GetFd() const { return fd_; }
+  void OnData(socket_t sock, void *client_data);
+  /** The batch callback is called once per drain of the rx ring. */
+  void SetBatchCallback(const CaptureBatchCallback& batch_cb) { batch_cb_ = batch_cb; }
+
+  uint64_t GetPacketCount() const { return packet_count_; }
+  /** Frames dropped by the kernel because the rx ring was full or no frame was filled. */
+  uint64_t GetDropCount();
+
+ private:
+  typedef struct {
+    uint32_t* producer;
+    uint32_t* consumer;
+    void* descs;
+    void* map;
+    size_t map_size;
+  } XdpRing;
+
+  bool MapRing(XdpRing& ring, uint64_t offset, uint32_t producer, uint32_t consumer, uint32_t desc,
+               size_t desc_size, uint32_t size);
+  void UnmapRing(XdpRing& ring);
+
+  socket_t fd_;
+  uint8_t* umem_;
+  size_t umem_size_;
+  uint32_t frame_num_;
+  XdpRing fill_ring_;
+  XdpRing completion_ring_;
+  XdpRing rx_ring_;
+  CapturePacketCallback cb_;
+  CaptureBatchCallback batch_cb_;
+  uint64_t packet_count_;
+};
+
+} // namespace lidar
+}  // namespace livox
+
+#endif  // LIVOX_XDP_SOCKET_H_
@@ -28,6 +28,13 @@
 #include <iostream>
 #include <algorithm>
 #include "logging.h"
+#include "livox_lidar_cfg.h"
+
+#ifdef HAVE_TIMERFD
+#include <string.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
 
 using std::lock_guard;
 using std::mutex;
@@ -37,44 +44,116 @@ using std::chrono::steady_clock;
 namespace livox {
 namespace lidar {
 
-bool IOLoop::Init() {
-  auto multiple_io = MultipleIOFactory::CreateMultipleIO();
-  if (!multiple_io) {
-    LOG_ERROR("Creat Multiple IO Failed!");
-    return false;
+bool IOLoop::Init(const IOLoopCfg& cfg) {
+  busy_poll_enable_ = cfg.busy_poll_enable;
+  busy_poll_idle_ = std::chrono::microseconds(cfg.busy_poll_idle_us);
+  multiple_io_base_.reset();
+  if (cfg.io_uring_enable) {
+    auto multiple_io = MultipleIOFactory::CreateMultipleIOUring();
+    if (multiple_io && multiple_io->PollCreate(OPEN_MAX_POLL)) {
+      multiple_io_base_ = std::move(multiple_io);
+    } else {
+      LOG_WARN("io_uring is not available, fall back to the default multiple io.");
+    }
+  }
+
+  if (!multiple_io_base_) {
+    auto multiple_io = MultipleIOFactory::CreateMultipleIO();
+    if (!multiple_io) {
+      LOG_ERROR("Creat Multiple IO Failed!");
+      return false;
+    }
+    multiple_io_base_ = std::move(multiple_io);
+    if (!multiple_io_base_->PollCreate(OPEN_MAX_POLL)) {
+      LOG_ERROR("Poll Create Failed!");
+      return false;
+    }
+    if (cfg.drain_budget > 0 && !multiple_io_base_->SetEdgeTriggered(cfg.drain_budget)) {
+      LOG_WARN("The multiple io does not support edge triggered mode, use level triggered mode.");
+    }
   }
-  multiple_io_base_ = std::move(multiple_io);
-  if (!multiple_io_base_->PollCreate(OPEN_MAX_POLL)) {
-    LOG_ERROR("Poll Create Failed!");
+
+  // Every backend polls the timerfd, io_uring with a poll request.
+#ifdef HAVE_TIMERFD
+  timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (timer_fd_ < 0) {
+    LOG_ERROR("Create timerfd failed.");
     return false;
   }
+  // The timerfd only wakes the poll up, the due timers are fired after every poll.
+  PollFd timer_fd = {};
+  timer_fd.fd = timer_fd_;
+  timer_fd.event = READBLE_EVENT;
+  timer_fd.event_callback = [this](FdEvent) {
+    uint64_t expirations = 0;
+    ssize_t ret = read(timer_fd_, &expirations, sizeof(expirations));
+    (void)ret;
+  };
+  multiple_io_base_->PollSetAdd(timer_fd);
+#endif
   return true;
 }
 
-void IOLoop::Uninit() {
-  multiple_io_base_->PollDestroy();
+void IOLoop::AddDelegate(socket_t sock, IOLoop::IOLoopDelegate *delegate, void *data) {
+  PostTask(std::bind(&IOLoop::AddDelegateAsync, this, sock, delegate, data, false));
 }
 
-void IOLoop::AddDelegate(socket_t sock, IOLoop::IOLoopDelegate *delegate, void *data) {
-  PostTask(std::bind(&IOLoop::AddDelegateAsync, this, sock, delegate, data));
+void IOLoop::AddRecvDelegate(socket_t sock, IOLoop::IOLoopDelegate *delegate, void *data) {
+  PostTask(std::bind(&IOLoop::AddDelegateAsync, this, sock, delegate, data, true));
 }
 
 void IOLoop::RemoveDelegate(socket_t sock, IOLoopDelegate *) {
   PostTask(std::bind(&IOLoop::RemoveDelegateAsync, this, sock));
 }
 
-void IOLoop::Loop() {
-  multiple_io_base_->Poll(POLL_TIMEOUT);
+void IOLoop::Uninit() {
+#ifdef HAVE_TIMERFD
+  if (timer_fd_ >= 0) {
+    PollFd timer_fd = {};
+    timer_fd.fd = timer_fd_;
+    timer_fd.event = READBLE_EVENT;
+    multiple_io_base_->PollSetRemove(timer_fd);
+    close(timer_fd_);
+    timer_fd_ = -1;
+  }
+#endif
+  multiple_io_base_->PollDestroy();
+}
 
-  vector<IOLoopTask> tasks;
-  {
-    lock_guard<mutex> lock(mutex_);
-    tasks.swap(pending_tasks_);
+void IOLoop::Loop() {
+  int timeout = GetPollTimeout();
+  // Busy polling spins with a zero timeout and backs off to the blocking poll once idle, the
+  // first packet after that wakes the poll and spinning resumes.
+  if (busy_poll_enable_ && (busy_poll_idle_.count() == 0 || steady_clock::now() - last_busy_ < busy_poll_idle_)) {
+    timeout = 0;
+  }
+  multiple_io_base_->Poll(timeout);
+  if (busy_poll_enable_) {
+    uint64_t packet_count = multiple_io_base_->GetStats().packet_count;
+    if (packet_count != last_packet_count_) {
+      last_packet_count_ = packet_count;
+      last_busy_ = steady_clock::now();
+    }
   }
+  FireTimers();
+  RunTasks();
+}
 
-  for (auto &task : tasks) {
+void IOLoop::RunTasks() {
+  // Clear the flag before popping, a task posted after this point wakes the loop again.
+  if (!wake_pending_.exchange(false, std::memory_order_acq_rel)) {
+    return;
+  }
+  IOLoopTask task;
+  for (int i = 0; i < MAX_LOOP_TASKS; ++i) {
+    if (!pending_tasks_.Pop(task)) {
+      return;
+    }
     task();
   }
+  // Leave the rest to the next loop so the sockets are not starved.
+  wake_pending_.store(true, std::memory_order_release);
+  Wakeup();
 }
 
  bool IOLoop::Wakeup() {
@@ -85,14 +164,117 @@ void IOLoop::Loop() {
  }
 
 void IOLoop::PostTask(const IOLoopTask &task) {
+  pending_tasks_.Push(task);
+  if (!wake_pending_.exchange(true, std::memory_order_acq_rel)) {
+    Wakeup();
+  }
+}
+
+uint64_t IOLoop::AddTimer(uint32_t delay_ms, uint32_t interval_ms, const TimerCallback& cb) {
+  uint64_t id = 0;
   {
-    lock_guard<mutex> lock(mutex_);
-    pending_tasks_.push_back(task);
+    lock_guard<mutex> lock(timer_mutex_);
+    id = timer_wheel_.AddTimer(steady_clock::now(), delay_ms, interval_ms, cb);
+    ArmTimer();
   }
+#ifndef HAVE_TIMERFD
+  // Let the poll pick the new deadline up.
   Wakeup();
+#endif
+  return id;
 }
 
-void IOLoop::AddDelegateAsync(socket_t sock, IOLoop::IOLoopDelegate *delegate, void *data) {
+void IOLoop::RemoveTimer(uint64_t id) {
+  std::unique_lock<mutex> lock(timer_mutex_);
+  timer_wheel_.RemoveTimer(id);
+  // A fired callback which did not start yet is skipped.
+  firing_timers_.erase(id);
+  if (std::this_thread::get_id() != loop_thread_id_) {
+    timer_done_cv_.wait(lock, [this, id]() { return running_timer_ != id; });
+  }
+}
+
+void IOLoop::FireTimers() {
+  vector<FiredTimer> fired;
+  TimePoint now = steady_clock::now();
+  {
+    lock_guard<mutex> lock(timer_mutex_);
+    loop_thread_id_ = std::this_thread::get_id();
+    if (timer_wheel_.Empty()) {
+      return;
+    }
+    timer_wheel_.Advance(now, fired);
+    ArmTimer();
+    for (const FiredTimer& timer : fired) {
+      firing_timers_.insert(timer.first);
+    }
+  }
+  // The callbacks run without the lock, RemoveTimer only waits for the one it removes.
+  for (const FiredTimer& timer : fired) {
+    {
+      lock_guard<mutex> lock(timer_mutex_);
+      if (firing_timers_.erase(timer.first) == 0) {
+        continue;
+      }
+      running_timer_ = timer.first;
+    }
+    timer.second(now);
+    {
+      lock_guard<mutex> lock(timer_mutex_);
+      running_timer_ = 0;
+    }
+    timer_done_cv_.notify_all();
+  }
+}
+
+void IOLoop::ArmTimer() {
+#ifdef HAVE_TIMERFD
+  TimePoint expiry = TimePoint();
+  if (timer_fd_ < 0 || (!timer_wheel_.NextExpiry(expiry) && armed_expiry_ == TimePoint())) {
+    return;
+  }
+  if (expiry == armed_expiry_) {
+    return;
+  }
+  armed_expiry_ = expiry;
+
+  struct itimerspec spec;
+  memset(&spec, 0, sizeof(spec));
+  if (expiry != TimePoint()) {
+    int64_t delay = std::chrono::duration_cast<std::chrono::nanoseconds>(expiry - steady_clock::now()).count();
+    delay = std::max<int64_t>(delay, 1);
+    spec.it_value.tv_sec = delay / 1000000000;
+    spec.it_value.tv_nsec = delay % 1000000000;
+  }
+  timerfd_settime(timer_fd_, 0, &spec, nullptr);
+#endif
+}
+
+int IOLoop::GetPollTimeout() {
+#ifdef HAVE_TIMERFD
+  return POLL_TIMEOUT;
+#else
+  lock_guard<mutex> lock(timer_mutex_);
+  TimePoint expiry;
+  if (!timer_wheel_.NextExpiry(expiry)) {
+    return POLL_TIMEOUT;
+  }
+  int64_t timeout = std::chrono::duration_cast<std::chrono::milliseconds>(expiry - steady_clock::now()).count() + 1;
+  return static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(timeout, POLL_TIMEOUT)));
+#endif
+}
+
+PollStats IOLoop::GetStats() {
+  return multiple_io_base_ ? multiple_io_base_->GetStats() : PollStats();
+}
+
+void IOLoop::AddStats(uint32_t packets) {
+  if (multiple_io_base_) {
+    multiple_io_base_->AddStats(packets);
+  }
+}
+
+void IOLoop::AddDelegateAsync(socket_t sock, IOLoop::IOLoopDelegate *delegate, void *data, bool recv) {
   PollFd pollfd = {};
   pollfd.fd = sock;
   pollfd.event = READBLE_EVENT;
@@ -103,11 +285,15 @@ void IOLoop::AddDelegateAsync(socket_t sock, IOLoop::IOLoopDelegate *delegate, v
       }
     }
   };
-  if (enable_timer_) {
-    pollfd.timer_callback = [=](TimePoint t) {
-      if (delegate) {
-        delegate->OnTimer(t);
-      }
+  if (recv && delegate) {
+    pollfd.recv_callback = [=](uint8_t* buf, int size, const struct sockaddr* addr, uint64_t timestamp) {
+      delegate->OnDatagram(sock, buf, size, addr, timestamp, data);
+    };
+    pollfd.recv_batch_callback = [=]() {
+      delegate->OnDatagramBatch(sock, data);
+    };
+    pollfd.drain_callback = [=](int budget) {
+      return delegate->OnDrain(sock, data, budget);
     };
   }
   if (enable_wake_) {
@@ -117,7 +303,9 @@ void IOLoop::AddDelegateAsync(socket_t sock, IOLoop::IOLoopDelegate *delegate, v
       }
     };
   }
-  multiple_io_base_->PollSetAdd(pollfd);
+  if (!multiple_io_base_->PollSetAdd(pollfd)) {
+    LOG_ERROR("Add the socket {} to the io loop failed.", sock);
+  }
 }
 
 void IOLoop::RemoveDelegateAsync(socket_t sock) {
@@ -25,58 +25,120 @@
 #ifndef LIVOX_IO_LOOP_H_
 #define LIVOX_IO_LOOP_H_
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 #include <algorithm>
 #include "command_callback.h"
 #include "noncopyable.h"
+#include "task_queue.h"
 #include "thread_base.h"
+#include "timer_wheel.h"
 #include "multiple_io/multiple_io_base.h"
 #include "multiple_io/multiple_io_factory.h"
 
 namespace livox {
 namespace lidar {
 
-#define OPEN_MAX_POLL 48
+#define OPEN_MAX_POLL 48 // initial descriptor capacity, grows on demand
 #define POLL_TIMEOUT 50 //ms
+#define MAX_LOOP_TASKS 1024
 typedef int socket_t;
 
+typedef struct {
+  bool io_uring_enable;   /* Use the io_uring backend if the kernel supports it. */
+  int drain_budget;       /* Drain the recv delegates edge triggered with this budget, 0 is level triggered. */
+  bool busy_poll_enable;  /* Poll without blocking while packets arrive. */
+  uint32_t busy_poll_idle_us;   /* Block in the poll again after this long without a packet, 0 never blocks. */
+} IOLoopCfg;
+
 class IOLoop : public noncopyable {
  public:
- typedef std::function<void(void)> IOLoopTask;
+ typedef TaskQueue::Task IOLoopTask;
 
   class IOLoopDelegate {
    public:
     virtual void OnData(socket_t, void *) {}
-    virtual void OnTimer(std::chrono::steady_clock::time_point) {}
+    virtual void OnDatagram(socket_t, uint8_t *, int, const struct sockaddr *, uint64_t, void *) {}
+    /** Called after the OnDatagram calls of one loop wakeup, their buffers are still valid. */
+    virtual void OnDatagramBatch(socket_t, void *) {}
+    /** Read up to budget packets, or until the socket would block, and return the packets read. */
+    virtual int OnDrain(socket_t sock, void *data, int) { OnData(sock, data); return 0; }
     virtual void OnWake() {}
   };
 
  public:
-  explicit IOLoop(bool enable_timer = true, bool enable_wake = true)
-      : enable_timer_(enable_timer), enable_wake_(enable_wake){};
+  explicit IOLoop(bool enable_wake = true)
+      : enable_wake_(enable_wake), wake_pending_(false), running_timer_(0), timer_fd_(-1), armed_expiry_(),
+        busy_poll_enable_(false), busy_poll_idle_(0), last_busy_(), last_packet_count_(0) {};
 
 
-  bool Init();
+  bool Init(const IOLoopCfg& cfg = IOLoopCfg());
   void Uninit();
   void AddDelegate(socket_t sock, IOLoopDelegate *delegate, void *data = NULL);
+  /**
+   * Add a datagram socket. The datagrams are passed to OnDatagram when the backend receives
+   * them itself (io_uring), otherwise OnDrain is called when the socket is readable.
+   */
+  void AddRecvDelegate(socket_t sock, IOLoopDelegate *delegate, void *data = NULL);
   void RemoveDelegate(socket_t sock, IOLoopDelegate *delegate);
   void Loop();
   bool Wakeup();
+  /**
+   * Run task on the loop thread. Lock free and thread safe, the posts made before the loop
+   * wakes up share one wakeup.
+   */
   void PostTask(const IOLoopTask &task);
+  PollStats GetStats();
+  /**
+   * Count packets received off the poll on the loop thread, e.g. by a capture ring, so that
+   * they keep the busy poll spinning and show up in the stats.
+   */
+  void AddStats(uint32_t packets);
+  /**
+   * Run cb on the loop thread delay_ms from now, then every interval_ms if interval_ms is not
+   * 0. Thread safe, the returned id removes the timer.
+   */
+  uint64_t AddTimer(uint32_t delay_ms, uint32_t interval_ms, const TimerCallback& cb);
+  /**
+   * Called off the loop thread it waits for a running callback of this timer, so what the
+   * callback uses may be released once it returns. The caller must not hold a lock the
+   * callback of this timer takes.
+   */
+  void RemoveTimer(uint64_t id);
 
  private:
-  void AddDelegateAsync(socket_t sock, IOLoopDelegate *delegate, void *data);
+  void AddDelegateAsync(socket_t sock, IOLoopDelegate *delegate, void *data, bool recv);
   void RemoveDelegateAsync(socket_t sock);
+  void FireTimers();
+  void RunTasks();
+  void ArmTimer();
+  int GetPollTimeout();
 
  private:
-  std::mutex mutex_;
-  bool enable_timer_;
   bool enable_wake_;
-  std::vector<IOLoopTask> pending_tasks_;
+  TaskQueue pending_tasks_;
+  std::atomic<bool> wake_pending_;
+
+  std::mutex timer_mutex_;
+  std::condition_variable timer_done_cv_;
+  std::unordered_set<uint64_t> firing_timers_;  /* Fired timers whose callback did not start yet. */
+  uint64_t running_timer_;        /* Timer whose callback runs, 0 if none. */
+  std::thread::id loop_thread_id_;
+  TimerWheel timer_wheel_;
+  int timer_fd_;
+  TimePoint armed_expiry_;
+
+  bool busy_poll_enable_;
+  std::chrono::microseconds busy_poll_idle_;
+  TimePoint last_busy_;           /* Last poll which handled a packet. */
+  uint64_t last_packet_count_;
   std::unique_ptr<MultipleIOBase> multiple_io_base_;
 };
 
@@ -41,9 +41,14 @@ void IOThread::ThreadFunc() {
   }
 }
 
-bool IOThread::Init(bool enable_timer, bool enable_wake) {
-  loop_ = std::make_shared<IOLoop>(enable_timer, enable_wake);
-  return loop_->Init();
+bool IOThread::Init(bool enable_wake, const IOLoopCfg& cfg) {
+  loop_ = std::make_shared<IOLoop>(enable_wake);
+  return loop_->Init(cfg);
+}
+
+bool IOThread::InitRecvBufferPool(size_t slot_size, size_t slot_num, size_t spare_num) {
+  recv_buffer_pool_.reset(new RecvBufferPool(slot_size, slot_num, spare_num));
+  return recv_buffer_pool_->Init();
 }
 
 void IOThread::Uninit() {
@@ -26,6 +26,7 @@
 #define LIVOX_IO_THREAD_H_
 #include <memory>
 #include "io_loop.h"
+#include "recv_buffer_pool.h"
 #include "thread_base.h"
 
 namespace livox {
@@ -33,15 +34,18 @@ namespace lidar {
 
 class IOThread : public ThreadBase {
  public:
-  IOThread() : loop_(nullptr) {}
+  IOThread() : loop_(nullptr), recv_buffer_pool_(nullptr) {}
   virtual ~IOThread();
-  bool Init(bool enable_timer = true, bool enable_wake = true);
+  bool Init(bool enable_wake = true, const IOLoopCfg& cfg = IOLoopCfg());
+  bool InitRecvBufferPool(size_t slot_size, size_t slot_num, size_t spare_num = 0);
   std::weak_ptr<IOLoop> GetLoop() { return loop_; }
+  RecvBufferPool* GetRecvBufferPool() { return recv_buffer_pool_.get(); }
   void ThreadFunc();
 
  private:
   void Uninit();
   std::shared_ptr<IOLoop> loop_;
+  std::unique_ptr<RecvBufferPool> recv_buffer_pool_;
 };
 
 } // namespace lidar
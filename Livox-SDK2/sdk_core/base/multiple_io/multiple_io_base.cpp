@@ -27,16 +27,14 @@
 namespace livox {
 namespace lidar {
 
-void MultipleIOBase::CheckTimer() {
-  TimePoint t = std::chrono::steady_clock::now();
-  if (t - last_timeout_ > std::chrono::milliseconds(50)) {
-    last_timeout_ = t;
-    for (auto & descriptor : descriptors_) {
-      PollFd pollfd =  descriptor.second;
-      if (pollfd.timer_callback) {
-        pollfd.timer_callback(t);
-      }
-    }
+void MultipleIOBase::AddStats(uint32_t packets) {
+  if (packets == 0) {
+    return;
+  }
+  ++stats_.wakeup_count;
+  stats_.packet_count += packets;
+  if (packets > stats_.max_wakeup_packets) {
+    stats_.max_wakeup_packets = packets;
   }
 }
 
@@ -53,17 +51,21 @@ void MultipleIOBase::WakeUpInit() {
       if (wake_up_pipe_) {
         wake_up_pipe_->Drain();
       }
-      for (auto & descriptor : descriptors_) {
-        PollFd pollfd =  descriptor.second;
-        if (pollfd.wake_callback) {
-          pollfd.wake_callback();
-        }
-      }
+      OnWakeUp();
     }
   };
   PollSetAdd(wake_fd);
 }
 
+void MultipleIOBase::OnWakeUp() {
+  for (auto & descriptor : descriptors_) {
+    PollFd pollfd =  descriptor.second;
+    if (pollfd.wake_callback) {
+      pollfd.wake_callback();
+    }
+  }
+}
+
 void MultipleIOBase::WakeUpUninit() {
   PollFd wake_fd = {};
   wake_fd.fd = wake_up_pipe_->GetPipeOut();
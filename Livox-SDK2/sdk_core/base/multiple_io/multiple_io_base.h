@@ -25,11 +25,15 @@
 #ifndef MULTIPLE_IO_BASE_H_
 #define MULTIPLE_IO_BASE_H_
 
+#include <stdint.h>
 #include <map>
 #include <functional>
 #include <chrono>
 #include <memory>
 #include "base/wake_up/wake_up_pipe.h"
+#include "base/timer_wheel.h"
+
+struct sockaddr;
 
 namespace livox {
 namespace lidar {
@@ -38,31 +42,54 @@ namespace lidar {
 #define READBLE_EVENT 1    /* when descriptor is readable. */
 #define WRITABLE_EVENT 2   /* when descriptor is writeable. */
 
-typedef std::chrono::steady_clock::time_point TimePoint;
 typedef int FdEvent;
 
 typedef struct {
   int fd;                                         /* File descriptor. */
   FdEvent event;                                  /* Read | Write Event to listen. */
   std::function<void(FdEvent)> event_callback;    /* Read or Write Event Callback. */
-  std::function<void(TimePoint)> timer_callback;  /* Timer Event Callback. */
   std::function<void()> wake_callback;            /* WakeUp Event Callback. */
+  /*
+   * Datagram Callback, used instead of event_callback by backends which receive the datagrams themselves.
+   * The last argument is the SO_TIMESTAMPNS receive time in ns, 0 if the socket does not stamp.
+   */
+  std::function<void(uint8_t*, int, const struct sockaddr*, uint64_t)> recv_callback;
+  /* Called once a poll passed its datagrams to recv_callback, before their buffers are reused. */
+  std::function<void()> recv_batch_callback;
+  /* Drain Callback, reads up to budget packets and returns the packets read. */
+  std::function<int(int)> drain_callback;
 } PollFd;
 
+typedef struct {
+  uint64_t wakeup_count;          /* Polls which handled at least one packet. */
+  uint64_t packet_count;          /* Packets handled. */
+  uint32_t max_wakeup_packets;    /* Most packets handled in one poll. */
+} PollStats;
+
 class MultipleIOBase {
  public:
   MultipleIOBase() = default;
   virtual ~MultipleIOBase() = default;
+  /** size is the initial descriptor capacity, PollSetAdd grows it on demand. */
   virtual bool PollCreate(int size) = 0;
   virtual void PollDestroy() = 0;
   virtual bool PollSetAdd(PollFd poll_fd) = 0;
   virtual bool PollSetRemove(PollFd poll_fd) = 0;
   virtual void Poll(int timeout) = 0;
   virtual void PollWakeUp();
+  /**
+   * Register the descriptors with a drain callback edge triggered, each is drained until it
+   * would block or budget packets were read. Returns false if the backend does not support it.
+   */
+  virtual bool SetEdgeTriggered(int budget) { return false; }
+  const PollStats& GetStats() const { return stats_; }
+  /** Count a wakeup which handled packets, called on the poll thread. */
+  void AddStats(uint32_t packets);
  protected:
-  virtual void CheckTimer();
+  /** Call the wake callbacks of the registered descriptors. */
+  virtual void OnWakeUp();
+  PollStats stats_ = PollStats();
   std::map<int, PollFd> descriptors_;
-  TimePoint last_timeout_ = TimePoint();
 
   virtual void WakeUpInit();
   virtual void WakeUpUninit();
@@ -24,6 +24,7 @@
 
 #include "multiple_io_epoll.h"
 #ifdef HAVE_EPOLL
+#include <algorithm>
 namespace livox {
 namespace lidar {
 
@@ -42,7 +43,7 @@ bool MultipleIOEpoll::PollCreate(int size) {
   if (epoll_fd_ < 0) {
     return false;
   }
-  pollset_.reset(new struct epoll_event[size]);
+  pollset_.resize(max_poll_size_);
   WakeUpInit();
   return true;
 }
@@ -56,18 +57,38 @@ void MultipleIOEpoll::PollDestroy() {
 }
 
 bool MultipleIOEpoll::PollSetAdd(PollFd poll_fd) {
-  if (max_poll_size_ <= (int)descriptors_.size()) {
+  int fd = poll_fd.fd;
+  if (fd < 0) {
+    return false;
+  }
+  if (fd < (int)handlers_.size() && handlers_[fd]) {
     return false;
   }
+
+  std::unique_ptr<Handler> handler(new Handler());
+  handler->fd = fd;
+  handler->pending = false;
+  handler->poll_fd = std::move(poll_fd);
+
   struct epoll_event ee = {0};
-  ee.events = GetEvent(poll_fd.event);
-  ee.data.fd = poll_fd.fd;
-  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, poll_fd.fd, &ee) == -1) {
+  ee.events = GetEvent(handler->poll_fd.event);
+  if (drain_budget_ > 0 && handler->poll_fd.drain_callback) {
+    ee.events |= EPOLLET;
+  }
+  ee.data.ptr = handler.get();
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ee) == -1) {
       return false;
   }
 
-  int fd = poll_fd.fd;
-  descriptors_[fd] = poll_fd;
+  if (fd >= (int)handlers_.size()) {
+    handlers_.resize(fd + 1);
+  }
+  handlers_[fd] = std::move(handler);
+  ++handler_count_;
+  if (handler_count_ > max_poll_size_) {
+    // The event buffer follows on the next poll, it may be in use by the current one.
+    max_poll_size_ *= 2;
+  }
   return true;
 }
 
@@ -75,15 +96,61 @@ bool MultipleIOEpoll::PollSetRemove(PollFd poll_fd) {
   int fd = poll_fd.fd;
   struct epoll_event ee = {0};
   epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, &ee);
-  if (descriptors_.find(fd) != descriptors_.end()) {
-      descriptors_.erase(fd);
+  if (fd < 0 || fd >= (int)handlers_.size() || !handlers_[fd]) {
+    return true;
+  }
+
+  // Events of this poll may still point at the record, so it is only released by the next poll.
+  Handler* handler = handlers_[fd].get();
+  handler->fd = -1;
+  if (handler->pending) {
+    pending_handlers_.erase(std::remove(pending_handlers_.begin(), pending_handlers_.end(), handler),
+                            pending_handlers_.end());
+    handler->pending = false;
   }
+  retired_handlers_.push_back(std::move(handlers_[fd]));
+  --handler_count_;
+  return true;
+}
+
+bool MultipleIOEpoll::SetEdgeTriggered(int budget) {
+  drain_budget_ = budget;
   return true;
 }
 
+void MultipleIOEpoll::OnWakeUp() {
+  for (auto & handler : handlers_) {
+    if (handler && handler->poll_fd.wake_callback) {
+      handler->poll_fd.wake_callback();
+    }
+  }
+}
+
+int MultipleIOEpoll::Drain(Handler* handler) {
+  int budget = drain_budget_ > 0 ? drain_budget_ : 1;
+  int packets = handler->poll_fd.drain_callback(budget);
+  // Out of budget, the descriptor may still be readable but no new edge will be reported.
+  if (drain_budget_ > 0 && packets >= budget && handler->fd >= 0 && !handler->pending) {
+    handler->pending = true;
+    pending_handlers_.push_back(handler);
+  }
+  return packets;
+}
+
 void MultipleIOEpoll::Poll(int time_out) {
-  int ret = epoll_wait(epoll_fd_, pollset_.get(), (int)descriptors_.size(),
-                    time_out);
+  retired_handlers_.clear();
+  if ((int)pollset_.size() < max_poll_size_) {
+    pollset_.resize(max_poll_size_);
+  }
+  draining_handlers_.swap(pending_handlers_);
+  pending_handlers_.clear();
+  for (Handler* handler : draining_handlers_) {
+    handler->pending = false;
+  }
+
+  int ret = epoll_wait(epoll_fd_, pollset_.data(), (int)pollset_.size(),
+                    draining_handlers_.empty() ? time_out : 0);
+  uint32_t packets = 0;
   if (ret > 0) {
     for (int i =0; i< ret; i++) {
       FdEvent fd_event = NONE_EVENT;
@@ -93,14 +160,25 @@ void MultipleIOEpoll::Poll(int time_out) {
       if (pollset_[i].events & EPOLLOUT) {
         fd_event |= WRITABLE_EVENT;
       }
-      int fd = pollset_[i].data.fd;
-      if (descriptors_.find(fd) != descriptors_.end()) {
-        PollFd pollfd =  descriptors_[fd];
-        pollfd.event_callback(fd_event);
+      Handler* handler = static_cast<Handler*>(pollset_[i].data.ptr);
+      if (handler->fd < 0) {
+        continue;
+      }
+      if (handler->poll_fd.drain_callback && (fd_event & READBLE_EVENT)) {
+        packets += Drain(handler);
+      } else if (handler->poll_fd.event_callback) {
+        handler->poll_fd.event_callback(fd_event);
       }
     }
   }
-  CheckTimer();
+
+  for (Handler* handler : draining_handlers_) {
+    if (handler->fd >= 0 && !handler->pending) {
+      packets += Drain(handler);
+    }
+  }
+  draining_handlers_.clear();
+  AddStats(packets);
 }
 
 } // namespace lidar
@@ -28,6 +28,7 @@
 #include "multiple_io_base.h"
 #include "livox_lidar_cfg.h"
 #include <memory>
+#include <vector>
 
 #ifdef HAVE_EPOLL
 
@@ -41,9 +42,26 @@ class MultipleIOEpoll : public MultipleIOBase {
   bool PollSetRemove(PollFd poll_fd);
   void Poll(int timeout);
   void PollDestroy();
+  bool SetEdgeTriggered(int budget);
+ protected:
+  void OnWakeUp();
  private:
+  /** Handler record of one descriptor, its address is the epoll_event data.ptr. */
+  struct Handler {
+    int fd;                 /* -1 once removed. */
+    bool pending;           /* In pending_handlers_. */
+    PollFd poll_fd;
+  };
+  int Drain(Handler* handler);
   int epoll_fd_ = -1;
-  std::unique_ptr<struct epoll_event[]> pollset_;
+  int drain_budget_ = 0;
+  /* Indexed by fd, the records of the removed descriptors are kept until the next poll. */
+  std::vector<std::unique_ptr<Handler>> handlers_;
+  std::vector<std::unique_ptr<Handler>> retired_handlers_;
+  int handler_count_ = 0;
+  std::vector<Handler*> pending_handlers_;    /* Edge triggered descriptors which ran out of budget. */
+  std::vector<Handler*> draining_handlers_;
+  std::vector<struct epoll_event> pollset_;
   int max_poll_size_ = 0;
 };
 
@@ -30,6 +30,7 @@
 #include "multiple_io_kqueue.h"
 #include "multiple_io_select.h"
 #include "multiple_io_poll.h"
+#include "multiple_io_uring.h"
 #include <memory>
 
 namespace livox {
@@ -37,6 +38,14 @@ namespace lidar {
 
 class MultipleIOFactory {
  public:
+  static std::unique_ptr<MultipleIOBase> CreateMultipleIOUring() {
+#if defined(HAVE_IO_URING)
+    return std::unique_ptr<MultipleIOBase>(new MultipleIOUring());
+#else
+    return nullptr;
+#endif
+  }
+
   static std::unique_ptr<MultipleIOBase> CreateMultipleIO() {
 #if defined(HAVE_EPOLL)
     return std::unique_ptr<MultipleIOBase>(new MultipleIOEpoll());
@@ -61,7 +61,8 @@ void MultipleIOKqueue::PollDestroy() {
 
 bool MultipleIOKqueue::PollSetAdd(PollFd poll_fd) {
   if (max_poll_size_ <= (int)descriptors_.size()) {
-    return false;
+    // The event buffer follows on the next poll, it may be in use by the current one.
+    max_poll_size_ *= 2;
   }
   int fd = poll_fd.fd;
   descriptors_[fd] = poll_fd;
@@ -118,6 +119,11 @@ void MultipleIOKqueue::Poll(int time_out) {
     tvptr = &tv;
   }
 
+  if (set_size_ < 2 * max_poll_size_) {
+    set_size_ = 2 * max_poll_size_;
+    kevent_set_.reset(new struct kevent[set_size_]);
+  }
+
   int rv = kevent(kqueue_fd_, NULL, 0, kevent_set_.get(), set_size_, tvptr);
   if (rv > 0) {
     for (int i = 0; i < rv; i++) {
@@ -133,7 +139,6 @@ void MultipleIOKqueue::Poll(int time_out) {
       }
     }
   }
-  CheckTimer();
 }
 
 } // namespace lidar
@@ -23,6 +23,7 @@
 //
 
 #include "multiple_io_poll.h"
+#include <algorithm>
 
 #ifdef HAVE_POLL
 
@@ -39,25 +40,20 @@ int GetEvent (FdEvent event) {
 }
 
 bool MultipleIOPoll:: PollCreate(int size) {
-  max_poll_size_ = size + 1;
-  pollset_.reset(new struct pollfd[max_poll_size_]);
+  pollset_.reserve(size + 1);
   WakeUpInit();
   return true;
 }
 
 bool MultipleIOPoll:: PollSetAdd(PollFd poll_fd) {
-  if (max_poll_size_ <= (int)descriptors_.size()) {
-    return false;
-  }
-
   int fd = poll_fd.fd;
   descriptors_[fd] = poll_fd;
 
   struct pollfd fds;
   fds.fd = fd;
   fds.events = GetEvent(poll_fd.event);
-  pollset_[pollset_num_] = fds;
-  pollset_num_++;
+  fds.revents = NONE_EVENT;
+  pollset_.push_back(fds);
   return true;
 }
 
@@ -72,26 +68,16 @@ bool MultipleIOPoll:: PollSetRemove(PollFd poll_fd) {
     descriptors_.erase(fd);
   }
 
-  for (int i = 0; i< pollset_num_; i++) {
-    if (pollset_[i].fd == fd) {
-      int dst = i;
-      for (i++; i < pollset_num_ - 1; i++) {
-        if (pollset_[i].fd == fd) {
-          pollset_num_--;
-        } else {
-          pollset_[dst] = pollset_[i];
-          dst++;
-        }
-      }
-    }
-  }
+  pollset_.erase(std::remove_if(pollset_.begin(), pollset_.end(), [fd](const struct pollfd& fds) {
+    return fds.fd == fd;
+  }), pollset_.end());
   return true;
 }
 
 void MultipleIOPoll:: Poll(int time_out) {
-  int rv = poll(pollset_.get(), pollset_num_, time_out);
+  int rv = poll(pollset_.data(), static_cast<nfds_t>(pollset_.size()), time_out);
   if (rv > 0) {
-    for (int i = 0; i < pollset_num_; i++) {
+    for (size_t i = 0; i < pollset_.size(); i++) {
       FdEvent fd_event = NONE_EVENT;
       if (pollset_[i].revents & POLLIN) {
         fd_event |= READBLE_EVENT;
@@ -107,7 +93,6 @@ void MultipleIOPoll:: Poll(int time_out) {
       pollset_[i].revents = NONE_EVENT;
     }
   }
-  CheckTimer();
 }
 
 } // namespace lidar
@@ -32,8 +32,6 @@ namespace lidar {
 bool MultipleIOSelect:: PollCreate(int size) {
   FD_ZERO(&rfds_);
   FD_ZERO(&wfds_);
-  //wake up fd + 1
-  max_poll_size_ = size + 1;
   WakeUpInit();
   return true;
 }
@@ -45,7 +43,8 @@ void MultipleIOSelect::PollDestroy() {
 }
 
 bool MultipleIOSelect:: PollSetAdd(PollFd poll_fd) {
-  if (max_poll_size_ <= (int)descriptors_.size()) {
+  // An fd_set holds FD_SETSIZE descriptors, the sdk raises it on Windows.
+  if ((int)descriptors_.size() >= FD_SETSIZE) {
     return false;
   }
   int fd = poll_fd.fd;
@@ -114,7 +113,6 @@ void MultipleIOSelect:: Poll(int time_out) {
       }
     }
   }
-  CheckTimer();
 }
 
 } // namespace lidar
@@ -44,7 +44,6 @@ class MultipleIOSelect : public MultipleIOBase {
   int max_fd_ = -1;
   fd_set rfds_;
   fd_set wfds_;
-  int max_poll_size_ = 0;
 };
 
 } // namespace lidar
@@ -0,0 +1,451 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "multiple_io_uring.h"
+
+#ifdef HAVE_IO_URING
+
+#include <algorithm>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "base/logging.h"
+#include "base/network/network_util.h"
+
+namespace livox {
+namespace lidar {
+
+static const uint32_t kSqEntries = 256;
+static const uint32_t kCqEntries = 4096;
+static const uint32_t kBufNum = 512;
+// Holds a datagram of a 1500 byte mtu with the recvmsg header, larger ones are dropped.
+static const uint32_t kBufSize = 4096;
+static const uint16_t kBufGroupId = 0;
+static const uint64_t kCancelUserData = ~0ULL;
+
+static int IOUringSetup(uint32_t entries, struct io_uring_params* params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int IOUringEnter(int fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags, void* arg, size_t arg_size) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, arg_size));
+}
+
+static int IOUringRegister(int fd, uint32_t opcode, void* arg, uint32_t nr_args) {
+  return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+MultipleIOUring::MultipleIOUring()
+    : ring_fd_(-1),
+      sq_ring_(nullptr),
+      sq_ring_size_(0),
+      cq_ring_(nullptr),
+      cq_ring_size_(0),
+      sqes_(nullptr),
+      sqes_size_(0),
+      sq_head_(nullptr),
+      sq_tail_(nullptr),
+      sq_mask_(0),
+      sq_entries_(0),
+      sq_local_tail_(0),
+      cq_head_(nullptr),
+      cq_tail_(nullptr),
+      cq_mask_(0),
+      cqes_(nullptr),
+      buf_ring_(nullptr),
+      buf_ring_size_(0),
+      bufs_(nullptr),
+      bufs_size_(0),
+      buf_ring_tail_(0),
+      buf_ring_registered_(false),
+      recv_multishot_(true),
+      truncated_count_(0),
+      poll_packets_(0),
+      next_seq_(0) {}
+
+MultipleIOUring::~MultipleIOUring() {
+  PollDestroy();
+}
+
+bool MultipleIOUring::PollCreate(int size) {
+  if (!SetupRing() || !SetupBufferRing()) {
+    PollDestroy();
+    return false;
+  }
+  WakeUpInit();
+  return true;
+}
+
+bool MultipleIOUring::SetupRing() {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = kCqEntries;
+  ring_fd_ = IOUringSetup(kSqEntries, &params);
+  if (ring_fd_ < 0) {
+    LOG_WARN("io_uring setup failed, errno: {}", errno);
+    return false;
+  }
+  if (!(params.features & IORING_FEAT_EXT_ARG)) {
+    LOG_WARN("io_uring of this kernel does not support waiting with a timeout.");
+    return false;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    sq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    cq_ring_size_ = sq_ring_size_;
+  }
+  void* sq_ring = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                       IORING_OFF_SQ_RING);
+  if (sq_ring == MAP_FAILED) {
+    LOG_WARN("Map io_uring sq ring failed, errno: {}", errno);
+    return false;
+  }
+  sq_ring_ = sq_ring;
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    cq_ring_ = sq_ring_;
+  } else {
+    void* cq_ring = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                         IORING_OFF_CQ_RING);
+    if (cq_ring == MAP_FAILED) {
+      LOG_WARN("Map io_uring cq ring failed, errno: {}", errno);
+      return false;
+    }
+    cq_ring_ = cq_ring;
+  }
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                    IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    LOG_WARN("Map io_uring sqes failed, errno: {}", errno);
+    sqes_size_ = 0;
+    return false;
+  }
+  sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+  uint8_t* sq = static_cast<uint8_t*>(sq_ring_);
+  sq_head_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+  sq_mask_ = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+  sq_entries_ = params.sq_entries;
+  sq_local_tail_ = *sq_tail_;
+  // The sqe slots are used in order, so the index array is an identity map.
+  uint32_t* sq_array = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+  for (uint32_t i = 0; i < sq_entries_; ++i) {
+    sq_array[i] = i;
+  }
+
+  uint8_t* cq = static_cast<uint8_t*>(cq_ring_);
+  cq_head_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+  return true;
+}
+
+bool MultipleIOUring::SetupBufferRing() {
+  buf_ring_size_ = kBufNum * sizeof(struct io_uring_buf);
+  void* buf_ring = mmap(nullptr, buf_ring_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (buf_ring == MAP_FAILED) {
+    buf_ring_size_ = 0;
+    return false;
+  }
+  // Addressed as an array of io_uring_buf, io_uring_buf_ring declares its flexible array in
+  // a way which shifts the entries when compiled as c++. The tail overlays bufs[0].resv.
+  buf_ring_ = static_cast<struct io_uring_buf*>(buf_ring);
+
+  bufs_size_ = static_cast<size_t>(kBufNum) * kBufSize;
+  void* bufs = mmap(nullptr, bufs_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (bufs == MAP_FAILED) {
+    bufs_size_ = 0;
+    return false;
+  }
+  bufs_ = static_cast<uint8_t*>(bufs);
+
+  struct io_uring_buf_reg reg;
+  memset(&reg, 0, sizeof(reg));
+  reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+  reg.ring_entries = kBufNum;
+  reg.bgid = kBufGroupId;
+  if (IOUringRegister(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+    LOG_WARN("io_uring of this kernel does not support provided buffer rings, errno: {}", errno);
+    return false;
+  }
+  buf_ring_registered_ = true;
+  held_bufs_.reserve(kBufNum);
+
+  for (uint32_t i = 0; i < kBufNum; ++i) {
+    RecycleBuffer(static_cast<uint16_t>(i));
+  }
+  __atomic_store_n(&buf_ring_[0].resv, buf_ring_tail_, __ATOMIC_RELEASE);
+  return true;
+}
+
+void MultipleIOUring::PollDestroy() {
+  if (wake_up_pipe_) {
+    WakeUpUninit();
+  }
+  if (buf_ring_registered_) {
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.bgid = kBufGroupId;
+    IOUringRegister(ring_fd_, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+    buf_ring_registered_ = false;
+  }
+  // Closing the ring cancels the outstanding requests.
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+    ring_fd_ = -1;
+  }
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+    sqes_ = nullptr;
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  cq_ring_ = nullptr;
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+    sq_ring_ = nullptr;
+  }
+  if (bufs_ != nullptr) {
+    munmap(bufs_, bufs_size_);
+    bufs_ = nullptr;
+  }
+  if (buf_ring_ != nullptr) {
+    munmap(buf_ring_, buf_ring_size_);
+    buf_ring_ = nullptr;
+  }
+  requests_.clear();
+  descriptors_.clear();
+  held_bufs_.clear();
+  batch_fds_.clear();
+}
+
+bool MultipleIOUring::PollSetAdd(PollFd poll_fd) {
+  int fd = poll_fd.fd;
+  descriptors_[fd] = poll_fd;
+  Request& request = requests_[fd];
+  memset(&request, 0, sizeof(request));
+  request.seq = ++next_seq_;
+  request.msg.msg_namelen = sizeof(struct sockaddr_in);
+  // Room for the SO_TIMESTAMPNS control message of sockets which enabled it.
+  request.msg.msg_controllen = CMSG_SPACE(sizeof(struct timespec));
+  ArmRequest(fd, request);
+  Submit(0, 0);
+  return true;
+}
+
+bool MultipleIOUring::PollSetRemove(PollFd poll_fd) {
+  int fd = poll_fd.fd;
+  auto it = requests_.find(fd);
+  if (it != requests_.end()) {
+    // Cancel right away, the request holds a reference on the socket until it completes.
+    struct io_uring_sqe* sqe = GetSqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = (static_cast<uint64_t>(it->second.seq) << 32) | static_cast<uint32_t>(fd);
+    sqe->user_data = kCancelUserData;
+    requests_.erase(it);
+    Submit(0, 0);
+  }
+  if (descriptors_.find(fd) != descriptors_.end()) {
+    descriptors_.erase(fd);
+  }
+  return true;
+}
+
+struct io_uring_sqe* MultipleIOUring::GetSqe() {
+  while (sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+    Submit(0, 0);
+  }
+  struct io_uring_sqe* sqe = &sqes_[sq_local_tail_ & sq_mask_];
+  ++sq_local_tail_;
+  memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+int MultipleIOUring::Submit(uint32_t wait_nr, int timeout) {
+  __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+  uint32_t to_submit = sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  if (wait_nr == 0) {
+    return to_submit == 0 ? 0 : IOUringEnter(ring_fd_, to_submit, 0, 0, nullptr, 0);
+  }
+
+  struct __kernel_timespec ts;
+  ts.tv_sec = timeout / 1000;
+  ts.tv_nsec = (timeout % 1000) * 1000000LL;
+  struct io_uring_getevents_arg arg;
+  memset(&arg, 0, sizeof(arg));
+  arg.ts = reinterpret_cast<uint64_t>(&ts);
+  return IOUringEnter(ring_fd_, to_submit, wait_nr, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                      &arg, sizeof(arg));
+}
+
+void MultipleIOUring::ArmRequest(int fd, Request& request) {
+  const PollFd& pollfd = descriptors_[fd];
+  struct io_uring_sqe* sqe = GetSqe();
+  sqe->fd = fd;
+  sqe->user_data = (static_cast<uint64_t>(request.seq) << 32) | static_cast<uint32_t>(fd);
+  if (pollfd.recv_callback && recv_multishot_) {
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->addr = reinterpret_cast<uint64_t>(&request.msg);
+    sqe->len = 1;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufGroupId;
+  } else {
+    // One shot, re-armed on completion, so the readiness is level triggered like epoll and a
+    // callback never runs on a descriptor which was drained since the event was posted.
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->poll32_events = POLLIN;
+  }
+}
+
+void MultipleIOUring::RecycleBuffer(uint16_t bid) {
+  struct io_uring_buf* buf = &buf_ring_[buf_ring_tail_ & (kBufNum - 1)];
+  buf->addr = reinterpret_cast<uint64_t>(bufs_ + static_cast<size_t>(bid) * kBufSize);
+  buf->len = kBufSize;
+  buf->bid = bid;
+  ++buf_ring_tail_;
+}
+
+void MultipleIOUring::HandleDatagram(const PollFd& poll_fd, uint8_t* buf, const struct msghdr& msg, uint32_t size) {
+  const struct io_uring_recvmsg_out* out = reinterpret_cast<const struct io_uring_recvmsg_out*>(buf);
+  size_t offset = sizeof(*out) + msg.msg_namelen + msg.msg_controllen;
+  struct msghdr control;
+  memset(&control, 0, sizeof(control));
+  control.msg_control = buf + sizeof(*out) + msg.msg_namelen;
+  control.msg_controllen = out->controllen;
+  // Removals are posted loop tasks, so the descriptor outlives the callback.
+  poll_fd.recv_callback(buf + offset, static_cast<int>(size), reinterpret_cast<const struct sockaddr*>(out + 1),
+                        util::GetRxTimestamp(&control));
+  ++poll_packets_;
+  if (poll_fd.recv_batch_callback &&
+      std::find(batch_fds_.begin(), batch_fds_.end(), poll_fd.fd) == batch_fds_.end()) {
+    batch_fds_.push_back(poll_fd.fd);
+  }
+}
+
+void MultipleIOUring::DropTruncated(size_t buf_size) {
+  // Logged on the 1st, 2nd, 4th, ... drop so a stream of jumbo frames does not flood the log.
+  ++truncated_count_;
+  if ((truncated_count_ & (truncated_count_ - 1)) == 0) {
+    LOG_WARN("io_uring dropped a datagram longer than the {} bytes a receive buffer holds, {} dropped so far.",
+             buf_size, truncated_count_);
+  }
+}
+
+void MultipleIOUring::HandleCqe(const struct io_uring_cqe* cqe) {
+  if (cqe->user_data == kCancelUserData) {
+    return;
+  }
+  int fd = static_cast<int>(cqe->user_data & 0xffffffff);
+  uint32_t seq = static_cast<uint32_t>(cqe->user_data >> 32);
+  uint8_t* buf = nullptr;
+  uint16_t bid = 0;
+  if (cqe->flags & IORING_CQE_F_BUFFER) {
+    bid = static_cast<uint16_t>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+    buf = bufs_ + static_cast<size_t>(bid) * kBufSize;
+  }
+
+  // A completion of a removed or re-added descriptor is stale.
+  auto request = requests_.find(fd);
+  auto descriptor = descriptors_.find(fd);
+  if (request != requests_.end() && request->second.seq == seq && descriptor != descriptors_.end()) {
+    const struct msghdr& msg = request->second.msg;
+    if (buf != nullptr && cqe->res >= 0) {
+      // [io_uring_recvmsg_out][name][control][payload], the payload is cut at the buffer end.
+      const struct io_uring_recvmsg_out* out = reinterpret_cast<const struct io_uring_recvmsg_out*>(buf);
+      size_t offset = sizeof(*out) + msg.msg_namelen + msg.msg_controllen;
+      if ((out->flags & MSG_TRUNC) || out->payloadlen > kBufSize - offset) {
+        DropTruncated(kBufSize - offset);
+      } else {
+        HandleDatagram(descriptor->second, buf, msg, out->payloadlen);
+      }
+    } else if (buf == nullptr && cqe->res > 0) {
+      PollFd pollfd = descriptor->second;
+      if (pollfd.drain_callback) {
+        poll_packets_ += pollfd.drain_callback(1);
+      } else {
+        pollfd.event_callback(READBLE_EVENT);
+      }
+    } else if ((cqe->res == -EINVAL || cqe->res == -EOPNOTSUPP) && recv_multishot_ &&
+               descriptor->second.recv_callback) {
+      LOG_WARN("io_uring of this kernel does not support multishot recvmsg, poll the sockets instead.");
+      recv_multishot_ = false;
+    }
+  }
+  if (buf != nullptr) {
+    held_bufs_.push_back(bid);
+  }
+
+  // A poll request ends after each event and a multishot request ends on errors such as
+  // running out of buffers, arm it again.
+  if (!(cqe->flags & IORING_CQE_F_MORE)) {
+    request = requests_.find(fd);
+    if (request != requests_.end() && request->second.seq == seq) {
+      ArmRequest(fd, request->second);
+    }
+  }
+}
+
+void MultipleIOUring::Poll(int time_out) {
+  Submit(1, time_out);
+
+  uint32_t head = *cq_head_;
+  uint32_t tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+  uint16_t buf_ring_tail = buf_ring_tail_;
+  poll_packets_ = 0;
+  for (; head != tail; ++head) {
+    HandleCqe(&cqes_[head & cq_mask_]);
+  }
+  __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+  for (int fd : batch_fds_) {
+    auto descriptor = descriptors_.find(fd);
+    if (descriptor != descriptors_.end()) {
+      descriptor->second.recv_batch_callback();
+    }
+  }
+  batch_fds_.clear();
+  for (uint16_t bid : held_bufs_) {
+    RecycleBuffer(bid);
+  }
+  held_bufs_.clear();
+  if (buf_ring_tail != buf_ring_tail_) {
+    __atomic_store_n(&buf_ring_[0].resv, buf_ring_tail_, __ATOMIC_RELEASE);
+  }
+  AddStats(poll_packets_);
+}
+
+} // namespace lidar
+}  // namespace livox
+
+#endif  // HAVE_IO_URING
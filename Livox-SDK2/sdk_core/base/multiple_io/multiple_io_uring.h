@@ -0,0 +1,124 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef MULTIPLE_IO_URING_H_
+#define MULTIPLE_IO_URING_H_
+
+#include "multiple_io_base.h"
+#include "livox_lidar_cfg.h"
+#include <map>
+#include <vector>
+
+// Kept out of livox_lidar_cfg.h, the sdk users do not need the kernel uapi headers.
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#if defined(IORING_RECV_MULTISHOT)
+#define HAVE_IO_URING 1
+#endif
+#endif
+#endif
+
+#ifdef HAVE_IO_URING
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+namespace livox {
+namespace lidar {
+
+/**
+ * io_uring backend. A descriptor registered with a recv callback gets a multishot recvmsg
+ * request which takes its buffers from a provided buffer ring, the datagrams are passed to
+ * the callback straight from the completion queue. Every other descriptor, or every
+ * descriptor when the kernel has no multishot recvmsg, gets a poll request.
+ */
+class MultipleIOUring : public MultipleIOBase {
+ public:
+  MultipleIOUring();
+  ~MultipleIOUring();
+  bool PollCreate(int size);
+  bool PollSetAdd(PollFd poll_fd);
+  bool PollSetRemove(PollFd poll_fd);
+  void Poll(int timeout);
+  void PollDestroy();
+
+ private:
+  typedef struct {
+    uint32_t seq;
+    struct msghdr msg;
+  } Request;
+
+  bool SetupRing();
+  bool SetupBufferRing();
+  struct io_uring_sqe* GetSqe();
+  int Submit(uint32_t wait_nr, int timeout);
+  void ArmRequest(int fd, Request& request);
+  void HandleCqe(const struct io_uring_cqe* cqe);
+  void HandleDatagram(const PollFd& poll_fd, uint8_t* buf, const struct msghdr& msg, uint32_t size);
+  /** Counts and logs a datagram longer than the provided buffers, it is dropped. */
+  void DropTruncated(size_t buf_size);
+  void RecycleBuffer(uint16_t bid);
+
+  int ring_fd_;
+  void* sq_ring_;
+  size_t sq_ring_size_;
+  void* cq_ring_;
+  size_t cq_ring_size_;
+  struct io_uring_sqe* sqes_;
+  size_t sqes_size_;
+
+  uint32_t* sq_head_;
+  uint32_t* sq_tail_;
+  uint32_t sq_mask_;
+  uint32_t sq_entries_;
+  uint32_t sq_local_tail_;
+  uint32_t* cq_head_;
+  uint32_t* cq_tail_;
+  uint32_t cq_mask_;
+  struct io_uring_cqe* cqes_;
+
+  struct io_uring_buf* buf_ring_;
+  size_t buf_ring_size_;
+  uint8_t* bufs_;
+  size_t bufs_size_;
+  uint16_t buf_ring_tail_;
+  bool buf_ring_registered_;
+
+  bool recv_multishot_;
+  uint64_t truncated_count_;
+  // The buffers of a poll go back to the ring once the recv batch callbacks of the
+  // descriptors which got datagrams have run.
+  std::vector<uint16_t> held_bufs_;
+  std::vector<int> batch_fds_;
+  uint32_t poll_packets_;
+  uint32_t next_seq_;
+  std::map<int, Request> requests_;
+};
+
+} // namespace lidar
+}  // namespace livox
+
+#endif  // HAVE_IO_URING
+#endif  // MULTIPLE_IO_URING_H_
@@ -39,6 +39,8 @@
 #include <stdio.h>
 #include <fcntl.h>
 #include <string>
+#include <vector>
+#include <utility>
 
 namespace livox {
 namespace lidar {
@@ -46,15 +48,84 @@ namespace lidar {
 namespace util {
 
 typedef int socket_t;
-socket_t CreateSocket(uint16_t port, bool nonblock = true, bool reuse_port = true, bool is_broadcast = false, const std::string netif = "", const std::string multicast_ip = "");
+
+/** Max datagrams received by one RecvMultiFrom call. */
+const int kMaxRecvMsgNum = 64;
+
+/** SO_RCVBUF requested when the caller does not size the socket. */
+const int kDefaultRecvBufferSize = 200 * 1024 * 1024;
+
+typedef struct {
+  void *buff;
+  size_t buf_size;
+  struct sockaddr addr;
+  int addrlen;
+  int size;
+  int segment_size;   /* UDP GRO segment size, 0 if the datagram was not coalesced. */
+  uint64_t timestamp; /* Kernel receive time in ns since the epoch, 0 if it is not enabled. */
+} RecvMsg;
+
+/**
+ * gro enables UDP_GRO, the kernel then coalesces datagrams of one flow up to 64 KB.
+ * recv_buff_size is the SO_RCVBUF requested, 0 keeps the kernel default.
+ */
+socket_t CreateSocket(uint16_t port, bool nonblock = true, bool reuse_port = true, bool is_broadcast = false, const std::string netif = "", const std::string multicast_ip = "", bool gro = false,
+                      int recv_buff_size = kDefaultRecvBufferSize);
 //socket_t CreateSocket(uint16_t port, bool nonblock = true, bool reuse_port = true, bool is_broadcast = false);
 
+/**
+ * Create a nonblocking socket which joins the SO_REUSEPORT group of host netif:port.
+ * @return the socket, -1 if failed or SO_REUSEPORT is not supported.
+ */
+socket_t CreateReusePortSocket(uint16_t port, const std::string netif = "", bool gro = false,
+                               int recv_buff_size = kDefaultRecvBufferSize);
+
+/** SO_RCVBUF granted by the kernel, Linux reports twice the size requested to cover its overhead. */
+int GetRecvBufferSize(socket_t sock);
+
+/**
+ * Steer the datagrams of a SO_REUSEPORT group by source ip with a classic BPF program.
+ * ip_index holds the source ip (network byte order) and the index of the target socket in
+ * the group, the index is the bind order. Other sources are steered by source ip % group_size.
+ * @return true if the program is attached.
+ */
+bool AttachReusePortFilter(socket_t sock, const std::vector<std::pair<uint32_t, uint32_t>>& ip_index,
+                           uint32_t group_size);
+
+/** Busy poll the device queue for up to us microseconds when a receive finds no data (SO_BUSY_POLL). */
+bool SetBusyPoll(socket_t sock, uint32_t us);
+
+/** Let the kernel stamp every received datagram with its receive time (SO_TIMESTAMPNS). */
+bool EnableRxTimestamp(socket_t sock);
+
+#ifndef WIN32
+/** The SO_TIMESTAMPNS receive time in ns since the epoch carried by hdr, 0 if there is none. */
+uint64_t GetRxTimestamp(struct msghdr* hdr);
+#endif
+
+/** Drop every datagram of the socket in the kernel, used when the data is captured below the socket. */
+bool AttachDropFilter(socket_t sock);
+
+/**
+ * Wait until one of the sockets has a datagram pending or timeout_us elapsed.
+ * @return true if a socket is readable.
+ */
+bool WaitReadable(const std::vector<socket_t>& socks, uint32_t timeout_us);
+
 void CloseSock(socket_t sock);
 
 bool FindLocalIp(const struct sockaddr_in &client_addr, uint32_t &local_ip);
 
 size_t RecvFrom(socket_t &sock, void *buff,  size_t buf_size, int flag, struct sockaddr *addr, int* addrlen);
 
+/**
+ * Receive up to msg_num datagrams from a nonblocking socket. buff and buf_size of each msg
+ * must be set by the caller, addr, addrlen, size, segment_size and timestamp are filled in for
+ * the received ones.
+ * @return the number of datagrams received, 0 if none is pending.
+ */
+int RecvMultiFrom(socket_t &sock, RecvMsg *msgs, int msg_num);
+
 }  // namespace util
 } // namespace lidar
 }  // namespace livox
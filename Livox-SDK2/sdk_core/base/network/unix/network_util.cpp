@@ -26,19 +26,34 @@
 #include <ifaddrs.h>
 #include <string>
 #include <string.h>
+#include <poll.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <netdb.h>
+#ifdef __linux__
+#include <linux/filter.h>
+#include <netinet/udp.h>
+#endif
 
 namespace livox {
 namespace lidar {
 namespace util {
 
-socket_t CreateSocket(uint16_t port, bool nonblock, bool reuse_port, bool is_broadcast, const std::string netif, const std::string multicast_ip) {
+static void EnableGro(socket_t sock) {
+#if defined(__linux__) && defined(UDP_GRO)
+  int on = 1;
+  if (setsockopt(sock, SOL_UDP, UDP_GRO, (char *)&on, sizeof(on)) != 0) {
+    printf("udp gro is not supported\n");
+  }
+#endif
+}
+
+socket_t CreateSocket(uint16_t port, bool nonblock, bool reuse_port, bool is_broadcast, const std::string netif, const std::string multicast_ip, bool gro,
+                      int recv_buff_size) {
   int status = -1;
   int on = -1;
   int sock = -1;
-  int recv_buff_size = 1024 * 1024 * 200;
   struct sockaddr_in servaddr;
 
   sock = socket(AF_INET, SOCK_DGRAM, 0);
@@ -65,11 +80,16 @@ socket_t CreateSocket(uint16_t port, bool nonblock, bool reuse_port, bool is_bro
       return -1;
    }
   }
-  status = setsockopt(sock, SOL_SOCKET, SO_RCVBUF,
-	  (char *)&recv_buff_size, sizeof(recv_buff_size));
-  if (status != 0) {
-	  close(sock);
-	  return -1;
+  if (recv_buff_size > 0) {
+    status = setsockopt(sock, SOL_SOCKET, SO_RCVBUF,
+      (char *)&recv_buff_size, sizeof(recv_buff_size));
+    if (status != 0) {
+      close(sock);
+      return -1;
+    }
+  }
+  if (gro) {
+    EnableGro(sock);
   }
 
   memset(&servaddr, 0, sizeof(servaddr));
@@ -170,6 +190,153 @@ socket_t CreateSocket(uint16_t port, bool nonblock, bool reuse_port, bool is_bro
 //   return sock;
 // }
 
+socket_t CreateReusePortSocket(uint16_t port, const std::string netif, bool gro, int recv_buff_size) {
+#ifdef SO_REUSEPORT
+  int on = 1;
+  struct sockaddr_in servaddr;
+
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock < 0) {
+    printf("create failed\n");
+    return -1;
+  }
+
+  if (ioctl(sock, FIONBIO, (char*)&on) != 0) {
+    printf("noblock failed\n");
+    close(sock);
+    return -1;
+  }
+
+  if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, (char *)&on, sizeof(on)) != 0) {
+    printf("reuse port failed\n");
+    close(sock);
+    return -1;
+  }
+
+  if (recv_buff_size > 0 &&
+      setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char *)&recv_buff_size, sizeof(recv_buff_size)) != 0) {
+    close(sock);
+    return -1;
+  }
+  if (gro) {
+    EnableGro(sock);
+  }
+
+  memset(&servaddr, 0, sizeof(servaddr));
+  servaddr.sin_family = AF_INET;
+  servaddr.sin_addr.s_addr = netif.empty() ? INADDR_ANY : inet_addr(netif.c_str());
+  servaddr.sin_port = htons(port);
+  if (bind(sock, (const struct sockaddr *)&servaddr, sizeof(servaddr)) != 0) {
+    printf("bind failed\n");
+    close(sock);
+    return -1;
+  }
+  return sock;
+#else
+  return -1;
+#endif
+}
+
+bool AttachReusePortFilter(socket_t sock, const std::vector<std::pair<uint32_t, uint32_t>>& ip_index,
+                           uint32_t group_size) {
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+  if (group_size == 0) {
+    return false;
+  }
+
+  // The program runs with skb data at the udp payload, the source ip is read relative to the
+  // network header. A word load converts it to host byte order.
+  std::vector<struct sock_filter> code;
+  code.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<uint32_t>(SKF_NET_OFF + 12)));
+  for (const auto& item : ip_index) {
+    code.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ntohl(item.first), 0, 1));
+    code.push_back(BPF_STMT(BPF_RET | BPF_K, item.second % group_size));
+  }
+  code.push_back(BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, group_size));
+  code.push_back(BPF_STMT(BPF_RET | BPF_A, 0));
+
+  struct sock_fprog prog;
+  prog.len = static_cast<unsigned short>(code.size());
+  prog.filter = code.data();
+  if (setsockopt(sock, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) != 0) {
+    printf("attach reuse port filter failed\n");
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+int GetRecvBufferSize(socket_t sock) {
+  int recv_buff_size = 0;
+  socklen_t len = sizeof(recv_buff_size);
+  if (getsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char *)&recv_buff_size, &len) != 0) {
+    return 0;
+  }
+  return recv_buff_size;
+}
+
+bool SetBusyPoll(socket_t sock, uint32_t us) {
+#ifdef SO_BUSY_POLL
+  int value = static_cast<int>(us);
+  return setsockopt(sock, SOL_SOCKET, SO_BUSY_POLL, (char *)&value, sizeof(value)) == 0;
+#else
+  return false;
+#endif
+}
+
+bool EnableRxTimestamp(socket_t sock) {
+#ifdef SO_TIMESTAMPNS
+  int on = 1;
+  return setsockopt(sock, SOL_SOCKET, SO_TIMESTAMPNS, (char *)&on, sizeof(on)) == 0;
+#else
+  return false;
+#endif
+}
+
+uint64_t GetRxTimestamp(struct msghdr* hdr) {
+#ifdef SO_TIMESTAMPNS
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(hdr, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_TIMESTAMPNS) {
+      struct timespec ts;
+      memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+      return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+    }
+  }
+#endif
+  return 0;
+}
+
+bool AttachDropFilter(socket_t sock) {
+#ifdef __linux__
+  struct sock_filter code[] = { BPF_STMT(BPF_RET | BPF_K, 0) };
+  struct sock_fprog prog;
+  prog.len = 1;
+  prog.filter = code;
+  return setsockopt(sock, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) == 0;
+#else
+  return false;
+#endif
+}
+
+bool WaitReadable(const std::vector<socket_t>& socks, uint32_t timeout_us) {
+  std::vector<struct pollfd> fds(socks.size());
+  for (size_t i = 0; i < socks.size(); ++i) {
+    fds[i].fd = socks[i];
+    fds[i].events = POLLIN;
+    fds[i].revents = 0;
+  }
+#ifdef __linux__
+  struct timespec timeout;
+  timeout.tv_sec = timeout_us / 1000000;
+  timeout.tv_nsec = static_cast<long>(timeout_us % 1000000) * 1000;
+  return ppoll(fds.data(), fds.size(), &timeout, nullptr) > 0;
+#else
+  return poll(fds.data(), fds.size(), static_cast<int>((timeout_us + 999) / 1000)) > 0;
+#endif
+}
+
 void CloseSock(int sock) {
   if (sock > 0) {
     close(sock);
@@ -211,6 +378,66 @@ size_t RecvFrom(socket_t &sock, void *buff,  size_t buf_size, int flag, struct s
   return recvfrom(sock, buff, buf_size, 0, addr, (socklen_t *)addrlen);
 }
 
+int RecvMultiFrom(socket_t &sock, RecvMsg *msgs, int msg_num) {
+  if (msg_num > kMaxRecvMsgNum) {
+    msg_num = kMaxRecvMsgNum;
+  }
+  if (msg_num <= 0) {
+    return 0;
+  }
+
+#ifdef __linux__
+  struct mmsghdr hdrs[kMaxRecvMsgNum];
+  struct iovec iovs[kMaxRecvMsgNum];
+  char controls[kMaxRecvMsgNum][CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(struct timespec))];
+  memset(hdrs, 0, sizeof(struct mmsghdr) * msg_num);
+  for (int i = 0; i < msg_num; ++i) {
+    iovs[i].iov_base = msgs[i].buff;
+    iovs[i].iov_len = msgs[i].buf_size;
+    hdrs[i].msg_hdr.msg_name = &msgs[i].addr;
+    hdrs[i].msg_hdr.msg_namelen = sizeof(msgs[i].addr);
+    hdrs[i].msg_hdr.msg_iov = &iovs[i];
+    hdrs[i].msg_hdr.msg_iovlen = 1;
+    hdrs[i].msg_hdr.msg_control = controls[i];
+    hdrs[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+  }
+
+  int num = recvmmsg(sock, hdrs, msg_num, 0, nullptr);
+  if (num <= 0) {
+    return 0;
+  }
+  for (int i = 0; i < num; ++i) {
+    msgs[i].addrlen = hdrs[i].msg_hdr.msg_namelen;
+    msgs[i].size = hdrs[i].msg_len;
+    msgs[i].segment_size = 0;
+    msgs[i].timestamp = GetRxTimestamp(&hdrs[i].msg_hdr);
+#ifdef UDP_GRO
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdrs[i].msg_hdr); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(&hdrs[i].msg_hdr, cmsg)) {
+      if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+        memcpy(&msgs[i].segment_size, CMSG_DATA(cmsg), sizeof(int));
+      }
+    }
+#endif
+  }
+  return num;
+#else
+  int num = 0;
+  for (; num < msg_num; ++num) {
+    RecvMsg& msg = msgs[num];
+    msg.addrlen = sizeof(msg.addr);
+    int size = recvfrom(sock, msg.buff, msg.buf_size, 0, &msg.addr, (socklen_t *)&msg.addrlen);
+    if (size <= 0) {
+      break;
+    }
+    msg.size = size;
+    msg.segment_size = 0;
+    msg.timestamp = 0;
+  }
+  return num;
+#endif
+}
+
 }  // namespace util
 } // namespace lidar
 }  // namespace livox
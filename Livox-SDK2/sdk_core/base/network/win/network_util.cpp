@@ -38,11 +38,53 @@ void CloseSock(socket_t sock) {
   closesocket(sock);
 }
 
-socket_t CreateSocket(uint16_t port, bool nonblock, bool reuse_port, bool is_broadcast, std::string netif, const std::string multicast_ip) {
+socket_t CreateReusePortSocket(uint16_t port, const std::string netif, bool, int) {
+  return -1;
+}
+
+int GetRecvBufferSize(socket_t sock) {
+  int recv_buff_size = 0;
+  int len = sizeof(recv_buff_size);
+  if (getsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char *)&recv_buff_size, &len) != 0) {
+    return 0;
+  }
+  return recv_buff_size;
+}
+
+bool AttachReusePortFilter(socket_t sock, const std::vector<std::pair<uint32_t, uint32_t>>& ip_index,
+                           uint32_t group_size) {
+  return false;
+}
+
+bool SetBusyPoll(socket_t sock, uint32_t us) {
+  return false;
+}
+
+bool EnableRxTimestamp(socket_t sock) {
+  return false;
+}
+
+bool AttachDropFilter(socket_t sock) {
+  return false;
+}
+
+bool WaitReadable(const std::vector<socket_t>& socks, uint32_t timeout_us) {
+  fd_set read_fds;
+  FD_ZERO(&read_fds);
+  for (socket_t sock : socks) {
+    FD_SET(sock, &read_fds);
+  }
+  struct timeval timeout;
+  timeout.tv_sec = static_cast<long>(timeout_us / 1000000);
+  timeout.tv_usec = static_cast<long>(timeout_us % 1000000);
+  return select(0, &read_fds, nullptr, nullptr, &timeout) > 0;
+}
+
+socket_t CreateSocket(uint16_t port, bool nonblock, bool reuse_port, bool is_broadcast, std::string netif, const std::string multicast_ip, bool,
+                      int recv_buff_size) {
   int status = -1;
   int on = -1;
   int sock = -1;
-  int recv_buff_size = 1024 * 1024 * 200;
   struct sockaddr_in servaddr;
   sock = socket(AF_INET, SOCK_DGRAM, 0);
   if (sock == INVALID_SOCKET) {
@@ -71,11 +113,13 @@ socket_t CreateSocket(uint16_t port, bool nonblock, bool reuse_port, bool is_bro
       return -1;
     }
   }
-  status = setsockopt(sock, SOL_SOCKET, SO_RCVBUF,
-	  (char *)&recv_buff_size, sizeof(recv_buff_size));
-  if (status != 0) {
-	  closesocket(sock);
-	  return -1;
+  if (recv_buff_size > 0) {
+    status = setsockopt(sock, SOL_SOCKET, SO_RCVBUF,
+      (char *)&recv_buff_size, sizeof(recv_buff_size));
+    if (status != 0) {
+      closesocket(sock);
+      return -1;
+    }
   }
 
   memset(&servaddr, 0, sizeof(servaddr));
@@ -170,6 +214,26 @@ size_t RecvFrom(socket_t &sock, void *buff,  size_t buf_size, int flag, struct s
   return recvfrom(sock, (char *)buff, buf_size, 0, addr, addrlen);
 }
 
+int RecvMultiFrom(socket_t &sock, RecvMsg *msgs, int msg_num) {
+  if (msg_num > kMaxRecvMsgNum) {
+    msg_num = kMaxRecvMsgNum;
+  }
+
+  int num = 0;
+  for (; num < msg_num; ++num) {
+    RecvMsg& msg = msgs[num];
+    msg.addrlen = sizeof(msg.addr);
+    int size = recvfrom(sock, (char *)msg.buff, (int)msg.buf_size, 0, &msg.addr, &msg.addrlen);
+    if (size <= 0) {
+      break;
+    }
+    msg.size = size;
+    msg.segment_size = 0;
+    msg.timestamp = 0;
+  }
+  return num;
+}
+
 } // namespace util
 }  // namespace lidar
 }  // namespace livox
@@ -0,0 +1,50 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include "reader_epoch.h"
+#include <thread>
+
+namespace livox {
+namespace lidar {
+
+ReaderEpoch::ReaderEpoch() : epoch_(0) {
+  readers_[0].store(0);
+  readers_[1].store(0);
+}
+
+void ReaderEpoch::Synchronize() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  // A reader may have read the epoch before the previous flip and not be counted yet, so
+  // both slots are drained, as the userspace RCU does.
+  for (int i = 0; i < 2; ++i) {
+    uint32_t slot = epoch_.fetch_add(1, std::memory_order_seq_cst) & 1;
+    while (readers_[slot].load(std::memory_order_acquire) != 0) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+} // namespace lidar
+}  // namespace livox
@@ -0,0 +1,71 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef LIVOX_READER_EPOCH_H_
+#define LIVOX_READER_EPOCH_H_
+
+#include <stdint.h>
+#include <atomic>
+#include "noncopyable.h"
+
+namespace livox {
+namespace lidar {
+
+/**
+ * Grace periods for data published through an atomic pointer and read without a lock. A reader
+ * counts itself in the slot of the current epoch between ReadLock and ReadUnlock. Synchronize
+ * flips the epoch and waits for the slots to drain, after which no reader can still hold a
+ * pointer loaded before the call, so the data it replaced may be freed.
+ *
+ * The counter increment of ReadLock and the pointer store before Synchronize are each followed
+ * by a seq_cst fence, so either the reader loads the new pointer or Synchronize sees it counted.
+ */
+class ReaderEpoch : public noncopyable {
+ public:
+  ReaderEpoch();
+
+  uint32_t ReadLock() {
+    uint32_t slot = epoch_.load(std::memory_order_relaxed) & 1;
+    readers_[slot].fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return slot;
+  }
+
+  void ReadUnlock(uint32_t slot) {
+    readers_[slot].fetch_sub(1, std::memory_order_release);
+  }
+
+  /** Call after publishing the new pointer, never between ReadLock and ReadUnlock. */
+  void Synchronize();
+
+ private:
+  std::atomic<uint32_t> epoch_;
+  std::atomic<uint32_t> readers_[2];
+};
+
+} // namespace lidar
+}  // namespace livox
+
+#endif  // LIVOX_READER_EPOCH_H_
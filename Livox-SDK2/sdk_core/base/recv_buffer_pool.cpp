@@ -0,0 +1,188 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "recv_buffer_pool.h"
+#include <string.h>
+#include <new>
+
+namespace livox {
+namespace lidar {
+
+// The copy of a packet follows its PacketRef in the same allocation.
+static const size_t kPacketCopyOffset = (sizeof(PacketRef) + 15) / 16 * 16;
+
+PacketRef* CopyPacketRef(const uint8_t* buf, size_t size, uint8_t** data) {
+  uint8_t* memory = new (std::nothrow) uint8_t[kPacketCopyOffset + size];
+  if (memory == nullptr) {
+    return nullptr;
+  }
+  PacketRef* packet_ref = new (memory) PacketRef();
+  packet_ref->ref_count.store(1, std::memory_order_relaxed);
+  packet_ref->pooled = false;
+  memcpy(memory + kPacketCopyOffset, buf, size);
+  *data = memory + kPacketCopyOffset;
+  return packet_ref;
+}
+
+void AddPacketRef(PacketRef* packet_ref) {
+  packet_ref->ref_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ReleasePacketRef(PacketRef* packet_ref) {
+  if (packet_ref->ref_count.fetch_sub(1, std::memory_order_acq_rel) != 1 || packet_ref->pooled) {
+    return;
+  }
+  packet_ref->~PacketRef();
+  delete[] reinterpret_cast<uint8_t*>(packet_ref);
+}
+
+RecvBufferPool::RecvBufferPool(size_t slot_size, size_t slot_num, size_t spare_num)
+    : slot_size_((slot_size + kCacheLineSize - 1) / kCacheLineSize * kCacheLineSize),
+      slot_num_(slot_num),
+      spare_num_(spare_num),
+      memory_(nullptr),
+      refs_(nullptr),
+      slots_(nullptr),
+      active_(CountingAllocator<uint32_t>(&heap_alloc_count_)),
+      active_index_(CountingAllocator<int32_t>(&heap_alloc_count_)),
+      free_(CountingAllocator<uint32_t>(&heap_alloc_count_)),
+      retained_(CountingAllocator<uint32_t>(&heap_alloc_count_)),
+      retain_fail_count_(0),
+      packet_count_(0),
+      heap_alloc_count_(0) {}
+
+RecvBufferPool::~RecvBufferPool() {
+  Recycle();
+  if (!retained_.empty()) {
+    // Packets are still held by the user, leave the slots and their refs to the late releases.
+    memory_.release();
+    refs_.release();
+  }
+}
+
+bool RecvBufferPool::Init() {
+  if (slots_ != nullptr) {
+    return true;
+  }
+  if (slot_size_ == 0 || slot_num_ == 0) {
+    return false;
+  }
+
+  size_t total_num = slot_num_ + spare_num_;
+  memory_.reset(new (std::nothrow) uint8_t[slot_size_ * total_num + kCacheLineSize]);
+  refs_.reset(new (std::nothrow) PacketRef[total_num]);
+  if (!memory_ || !refs_) {
+    return false;
+  }
+  // The two arrays above, the vectors below count themselves.
+  heap_alloc_count_ += 2;
+
+  uintptr_t addr = reinterpret_cast<uintptr_t>(memory_.get());
+  addr = (addr + kCacheLineSize - 1) & ~(static_cast<uintptr_t>(kCacheLineSize) - 1);
+  slots_ = reinterpret_cast<uint8_t*>(addr);
+
+  // The bookkeeping vectors never grow past these sizes, Recycle and Retain do not allocate.
+  active_.resize(slot_num_);
+  active_index_.resize(total_num, -1);
+  free_.reserve(spare_num_);
+  retained_.reserve(spare_num_);
+  for (size_t i = 0; i < total_num; ++i) {
+    refs_[i].ref_count.store(0, std::memory_order_relaxed);
+    refs_[i].pooled = true;
+    if (i < slot_num_) {
+      active_[i] = static_cast<uint32_t>(i);
+      active_index_[i] = static_cast<int32_t>(i);
+    } else {
+      free_.push_back(static_cast<uint32_t>(i));
+    }
+  }
+  return true;
+}
+
+uint8_t* RecvBufferPool::GetSlot(size_t index) const {
+  if (slots_ == nullptr || index >= slot_num_) {
+    return nullptr;
+  }
+  return slots_ + active_[index] * slot_size_;
+}
+
+void RecvBufferPool::Recycle() {
+  for (size_t i = 0; i < retained_.size();) {
+    if (refs_[retained_[i]].ref_count.load(std::memory_order_acquire) != 0) {
+      ++i;
+      continue;
+    }
+    free_.push_back(retained_[i]);
+    retained_[i] = retained_.back();
+    retained_.pop_back();
+  }
+}
+
+size_t RecvBufferPool::GetLentNum() const {
+  size_t lent_num = 0;
+  for (uint32_t slot : retained_) {
+    if (refs_[slot].ref_count.load(std::memory_order_acquire) != 0) {
+      ++lent_num;
+    }
+  }
+  return lent_num;
+}
+
+PacketRef* RecvBufferPool::Retain(const uint8_t* buf) {
+  if (slots_ == nullptr || buf < slots_ || buf >= slots_ + slot_size_ * (slot_num_ + spare_num_)) {
+    return nullptr;
+  }
+  uint32_t slot = static_cast<uint32_t>((buf - slots_) / slot_size_);
+  PacketRef* packet_ref = &refs_[slot];
+  // Already swapped out for an earlier packet of the same coalesced datagram.
+  int32_t index = active_index_[slot];
+  if (index < 0) {
+    AddPacketRef(packet_ref);
+    return packet_ref;
+  }
+  if (free_.empty()) {
+    ++retain_fail_count_;
+    return nullptr;
+  }
+
+  uint32_t spare = free_.back();
+  free_.pop_back();
+  active_[index] = spare;
+  active_index_[spare] = index;
+  active_index_[slot] = -1;
+  retained_.push_back(slot);
+  packet_ref->ref_count.store(1, std::memory_order_relaxed);
+  return packet_ref;
+}
+
+PacketRef* RecvBufferPool::Copy(const uint8_t* buf, size_t size, uint8_t** data) {
+  PacketRef* packet_ref = CopyPacketRef(buf, size, data);
+  if (packet_ref != nullptr) {
+    ++heap_alloc_count_;
+  }
+  return packet_ref;
+}
+
+} // namespace lidar
+}  // namespace livox
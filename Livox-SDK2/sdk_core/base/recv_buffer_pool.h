@@ -0,0 +1,136 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef LIVOX_RECV_BUFFER_POOL_H_
+#define LIVOX_RECV_BUFFER_POOL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "noncopyable.h"
+
+namespace livox {
+namespace lidar {
+
+static const size_t kCacheLineSize = 64;
+
+/**
+ * Reference on a received packet kept past its callback. Every slot of a pool carries one, the
+ * pool reuses the slot once the count drops to 0. A packet outside a pool is copied behind one.
+ */
+typedef struct {
+  std::atomic<uint32_t> ref_count;
+  bool pooled;
+} PacketRef;
+
+/** std::allocator which adds its allocations to *count. */
+template <typename T>
+class CountingAllocator {
+ public:
+  typedef T value_type;
+
+  explicit CountingAllocator(uint64_t* count) : count_(count) {}
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>& other) : count_(other.GetCount()) {}
+
+  T* allocate(size_t n) {
+    ++*count_;
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T* p, size_t n) { std::allocator<T>().deallocate(p, n); }
+  uint64_t* GetCount() const { return count_; }
+
+  template <typename U>
+  bool operator==(const CountingAllocator<U>& other) const { return count_ == other.GetCount(); }
+  template <typename U>
+  bool operator!=(const CountingAllocator<U>& other) const { return count_ != other.GetCount(); }
+
+ private:
+  uint64_t* count_;
+};
+
+/** Copies a packet received outside a pool, *data points to the copy. */
+PacketRef* CopyPacketRef(const uint8_t* buf, size_t size, uint8_t** data);
+void AddPacketRef(PacketRef* packet_ref);
+/** May be called from any thread, also after the pool is gone. */
+void ReleasePacketRef(PacketRef* packet_ref);
+
+/**
+ * Fixed set of cache line aligned receive slots. A pool belongs to one io thread and is
+ * only touched from that thread, so it needs no lock. The memory is allocated once by Init,
+ * the receive path then reuses the same slots for every wakeup.
+ *
+ * spare_num more slots stand by for the packets retained past their callback. Retain swaps
+ * a spare in for the slot of the packet, which then stays untouched until its last
+ * reference is released and Recycle hands it back to the spares.
+ */
+class RecvBufferPool : public noncopyable {
+ public:
+  RecvBufferPool(size_t slot_size, size_t slot_num, size_t spare_num = 0);
+  ~RecvBufferPool();
+  bool Init();
+
+  uint8_t* GetSlot(size_t index) const;
+  size_t GetSlotSize() const { return slot_size_; }
+  size_t GetSlotNum() const { return slot_num_; }
+
+  /** Called before the slots are filled, gives the released slots back to the spares. */
+  void Recycle();
+  /** Reference on the slot holding buf, nullptr if buf is not in the pool or no spare is left. */
+  PacketRef* Retain(const uint8_t* buf);
+  /** CopyPacketRef for the packets Retain can not keep, counted as a heap allocation of the pool. */
+  PacketRef* Copy(const uint8_t* buf, size_t size, uint8_t** data);
+  /** Slots still referenced by the user. */
+  size_t GetLentNum() const;
+  uint64_t GetRetainFailCount() const { return retain_fail_count_; }
+
+  void AddPacketCount(uint64_t count) { packet_count_ += count; }
+  uint64_t GetPacketCount() const { return packet_count_; }
+  /** Heap allocations done by the pool: the slots, the refs and the bookkeeping of Init, and the packet copies of Copy. */
+  uint64_t GetHeapAllocCount() const { return heap_alloc_count_; }
+
+ private:
+  size_t slot_size_;
+  size_t slot_num_;
+  size_t spare_num_;
+  std::unique_ptr<uint8_t[]> memory_;
+  std::unique_ptr<PacketRef[]> refs_;
+  uint8_t* slots_;
+  // Physical slot behind each index of GetSlot, and the index of each physical slot or -1.
+  // Their allocator counts into heap_alloc_count_.
+  std::vector<uint32_t, CountingAllocator<uint32_t>> active_;
+  std::vector<int32_t, CountingAllocator<int32_t>> active_index_;
+  std::vector<uint32_t, CountingAllocator<uint32_t>> free_;
+  std::vector<uint32_t, CountingAllocator<uint32_t>> retained_;
+  uint64_t retain_fail_count_;
+  uint64_t packet_count_;
+  uint64_t heap_alloc_count_;
+};
+
+} // namespace lidar
+}  // namespace livox
+
+#endif  // LIVOX_RECV_BUFFER_POOL_H_
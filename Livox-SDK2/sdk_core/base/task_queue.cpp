@@ -0,0 +1,125 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "task_queue.h"
+
+namespace livox {
+namespace lidar {
+
+TaskQueue::TaskQueue(uint32_t pool_size)
+    : pool_size_(pool_size),
+      pool_(new Node[pool_size]),
+      free_head_(0),
+      head_(&stub_),
+      tail_(&stub_) {
+  stub_.next.store(nullptr, std::memory_order_relaxed);
+  stub_.index = 0;
+  for (uint32_t i = 0; i < pool_size_; ++i) {
+    pool_[i].next.store(nullptr, std::memory_order_relaxed);
+    pool_[i].index = i + 1;
+    pool_[i].free_next.store(i + 2 <= pool_size_ ? i + 2 : 0, std::memory_order_relaxed);
+  }
+  free_head_.store(pool_size_ > 0 ? 1 : 0, std::memory_order_relaxed);
+}
+
+TaskQueue::~TaskQueue() {
+  Task task;
+  while (Pop(task)) {
+  }
+}
+
+void TaskQueue::Push(const Task& task) {
+  Node* node = Allocate();
+  node->task = task;
+  PushNode(node);
+}
+
+void TaskQueue::PushNode(Node* node) {
+  node->next.store(nullptr, std::memory_order_relaxed);
+  Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+  prev->next.store(node, std::memory_order_release);
+}
+
+bool TaskQueue::Pop(Task& task) {
+  Node* tail = tail_;
+  Node* next = tail->next.load(std::memory_order_acquire);
+  if (tail == &stub_) {
+    if (next == nullptr) {
+      return false;
+    }
+    tail_ = next;
+    tail = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+
+  if (next == nullptr) {
+    if (tail != head_.load(std::memory_order_acquire)) {
+      // A producer swapped the head but has not linked its node yet.
+      return false;
+    }
+    // Put the stub behind the last node so the last node can be handed out.
+    PushNode(&stub_);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return false;
+    }
+  }
+
+  tail_ = next;
+  task = std::move(tail->task);
+  tail->task = nullptr;
+  Release(tail);
+  return true;
+}
+
+TaskQueue::Node* TaskQueue::Allocate() {
+  uint64_t head = free_head_.load(std::memory_order_acquire);
+  while (static_cast<uint32_t>(head) != 0) {
+    Node* node = &pool_[static_cast<uint32_t>(head) - 1];
+    uint32_t next = node->free_next.load(std::memory_order_relaxed);
+    uint64_t new_head = (((head >> 32) + 1) << 32) | next;
+    if (free_head_.compare_exchange_weak(head, new_head, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      return node;
+    }
+  }
+  Node* node = new Node();
+  node->index = 0;
+  return node;
+}
+
+void TaskQueue::Release(Node* node) {
+  if (node->index == 0) {
+    delete node;
+    return;
+  }
+  uint64_t head = free_head_.load(std::memory_order_relaxed);
+  uint64_t new_head = 0;
+  do {
+    node->free_next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+    new_head = (((head >> 32) + 1) << 32) | node->index;
+  } while (!free_head_.compare_exchange_weak(head, new_head, std::memory_order_release, std::memory_order_relaxed));
+}
+
+} // namespace lidar
+}  // namespace livox
@@ -0,0 +1,78 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef LIVOX_TASK_QUEUE_H_
+#define LIVOX_TASK_QUEUE_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "noncopyable.h"
+
+namespace livox {
+namespace lidar {
+
+/**
+ * Lock free multi producer, single consumer task queue (intrusive Vyukov queue). Push may be
+ * called from any thread, Pop only from the thread owning the queue. The nodes come from a
+ * fixed pool whose free list is a tagged Treiber stack, the heap is only used once the pool
+ * runs dry.
+ */
+class TaskQueue : public noncopyable {
+ public:
+  typedef std::function<void(void)> Task;
+
+  explicit TaskQueue(uint32_t pool_size = 1024);
+  ~TaskQueue();
+
+  void Push(const Task& task);
+  /** Move the oldest task to task, returns false when nothing is ready yet. Consumer only. */
+  bool Pop(Task& task);
+
+ private:
+  struct Node {
+    std::atomic<Node*> next;
+    std::atomic<uint32_t> free_next;   /* Free list link, the pool index + 1, 0 ends the list. */
+    uint32_t index;                    /* Pool index + 1, 0 for nodes from the heap. */
+    Task task;
+  };
+
+  Node* Allocate();
+  void Release(Node* node);
+  void PushNode(Node* node);
+
+ private:
+  uint32_t pool_size_;
+  std::unique_ptr<Node[]> pool_;
+  std::atomic<uint64_t> free_head_;    /* ABA tag << 32 | head index + 1. */
+  std::atomic<Node*> head_;
+  Node* tail_;
+  Node stub_;
+};
+
+} // namespace lidar
+}  // namespace livox
+
+#endif  // LIVOX_TASK_QUEUE_H_
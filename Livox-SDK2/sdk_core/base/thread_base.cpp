@@ -26,19 +26,59 @@
 #include <thread>
 #include <iostream>
 #include <memory>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#endif
+#include "logging.h"
 
 namespace livox {
 namespace lidar {
 
 
-ThreadBase::ThreadBase() : quit_(false) {}
+ThreadBase::ThreadBase() : quit_(false), name_(""), cpu_(-1), priority_(0) {}
 
 bool ThreadBase::Start() {
   quit_ = false;
-  thread_ = std::make_shared<std::thread>(&ThreadBase::ThreadFunc, this);
+  thread_ = std::make_shared<std::thread>(&ThreadBase::Run, this);
   return true;
 }
 
+void ThreadBase::Run() {
+  ApplyThreadAttr();
+  ThreadFunc();
+}
+
+void ThreadBase::ApplyThreadAttr() {
+#ifdef __linux__
+  if (!name_.empty()) {
+    // The kernel limits the thread name to 15 characters.
+    pthread_setname_np(pthread_self(), name_.substr(0, 15).c_str());
+  }
+  if (cpu_ >= 0) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu_, &cpu_set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
+      LOG_WARN("Set cpu affinity of thread {} to cpu {} failed.", name_, cpu_);
+    }
+  }
+  if (priority_ > 0) {
+    struct sched_param param;
+    param.sched_priority = priority_;
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0) {
+      LOG_WARN("Set SCHED_FIFO priority {} of thread {} failed, it needs CAP_SYS_NICE.", priority_, name_);
+    }
+  }
+#elif defined(__APPLE__)
+  if (!name_.empty()) {
+    pthread_setname_np(name_.c_str());
+  }
+#endif
+}
+
 ThreadBase::~ThreadBase() {
   if (thread_) {
     Join();
@@ -27,6 +27,7 @@
 #include <atomic>
 #include <thread>
 #include <memory>
+#include <string>
 #include "noncopyable.h"
 
 namespace livox {
@@ -40,11 +41,25 @@ class ThreadBase : public noncopyable {
   bool Start();
   bool IsQuit() { return quit_; }
 
+  /**
+   * All take effect on the next Start. cpu < 0 leaves the thread unbound, priority > 0 runs the
+   * thread SCHED_FIFO with that priority (Linux only).
+   */
+  void SetName(const std::string& name) { name_ = name; }
+  void SetCpuAffinity(int cpu) { cpu_ = cpu; }
+  void SetRealtimePriority(int priority) { priority_ = priority; }
+
  protected:
   void Join();
   
  private:
+  void ApplyThreadAttr();
+  void Run();
+
   std::atomic_bool quit_;
+  std::string name_;
+  int cpu_;
+  int priority_;
   std::shared_ptr<std::thread> thread_;
 };
 
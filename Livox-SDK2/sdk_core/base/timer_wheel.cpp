@@ -0,0 +1,167 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "timer_wheel.h"
+
+namespace livox {
+namespace lidar {
+
+static const int kLevelNum = 4;
+static const uint32_t kLevel0Bits = 8;
+static const uint32_t kLevelBits = 6;
+static const uint32_t kLevel0Size = 1 << kLevel0Bits;
+static const uint32_t kLevelSize = 1 << kLevelBits;
+static const uint64_t kMaxDelayTick = (1ULL << (kLevel0Bits + (kLevelNum - 1) * kLevelBits)) - 1;
+
+static uint32_t LevelShift(int level) {
+  return level == 0 ? 0 : kLevel0Bits + (level - 1) * kLevelBits;
+}
+
+static uint32_t LevelOffset(int level) {
+  return level == 0 ? 0 : kLevel0Size + (level - 1) * kLevelSize;
+}
+
+TimerWheel::TimerWheel()
+    : start_(std::chrono::steady_clock::now()),
+      current_tick_(0),
+      next_id_(0),
+      timers_(),
+      slots_(kLevel0Size + (kLevelNum - 1) * kLevelSize) {}
+
+uint64_t TimerWheel::GetTick(TimePoint now) const {
+  if (now <= start_) {
+    return 0;
+  }
+  return std::chrono::duration_cast<std::chrono::milliseconds>(now - start_).count();
+}
+
+uint64_t TimerWheel::AddTimer(TimePoint now, uint32_t delay_ms, uint32_t interval_ms, const TimerCallback& cb) {
+  uint64_t id = ++next_id_;
+  if (timers_.empty() && GetTick(now) > current_tick_) {
+    // Nothing to expire in between, skip the idle ticks.
+    current_tick_ = GetTick(now);
+  }
+  // A timer is due once a whole tick has passed, so it never fires early.
+  uint64_t expire = GetTick(now) + delay_ms + 1;
+  Timer& timer = timers_[id];
+  timer.expire = expire;
+  timer.interval = interval_ms;
+  timer.cb = cb;
+  Place(id, expire);
+  return id;
+}
+
+void TimerWheel::RemoveTimer(uint64_t id) {
+  timers_.erase(id);
+}
+
+void TimerWheel::Place(uint64_t id, uint64_t expire) {
+  if (expire < current_tick_) {
+    expire = current_tick_;
+  }
+  uint64_t delta = expire - current_tick_;
+  if (delta > kMaxDelayTick) {
+    expire = current_tick_ + kMaxDelayTick;
+    delta = kMaxDelayTick;
+    timers_[id].expire = expire;
+  }
+
+  int level = 0;
+  while (level < kLevelNum - 1 && delta >= (1ULL << LevelShift(level + 1))) {
+    ++level;
+  }
+  uint32_t mask = (level == 0 ? kLevel0Size : kLevelSize) - 1;
+  uint32_t index = static_cast<uint32_t>(expire >> LevelShift(level)) & mask;
+  slots_[LevelOffset(level) + index].push_back(id);
+}
+
+void TimerWheel::Cascade(int level, uint32_t index) {
+  std::vector<uint64_t> ids;
+  ids.swap(slots_[LevelOffset(level) + index]);
+  for (uint64_t id : ids) {
+    auto it = timers_.find(id);
+    if (it != timers_.end()) {
+      Place(id, it->second.expire);
+    }
+  }
+}
+
+void TimerWheel::Advance(TimePoint now, std::vector<FiredTimer>& fired) {
+  uint64_t now_tick = GetTick(now);
+  std::vector<uint64_t> ids;
+  while (current_tick_ <= now_tick) {
+    if (timers_.empty()) {
+      current_tick_ = now_tick + 1;
+      break;
+    }
+
+    // Entering a new lap of a level moves the timers of the next upper slot down.
+    uint32_t index = static_cast<uint32_t>(current_tick_) & (kLevel0Size - 1);
+    for (int level = 1; level < kLevelNum && index == 0; ++level) {
+      index = static_cast<uint32_t>(current_tick_ >> LevelShift(level)) & (kLevelSize - 1);
+      Cascade(level, index);
+    }
+
+    ids.clear();
+    ids.swap(slots_[current_tick_ & (kLevel0Size - 1)]);
+    for (uint64_t id : ids) {
+      auto it = timers_.find(id);
+      if (it == timers_.end()) {
+        continue;
+      }
+      Timer& timer = it->second;
+      if (timer.expire > current_tick_) {
+        Place(id, timer.expire);
+        continue;
+      }
+      fired.emplace_back(id, timer.cb);
+      if (timer.interval == 0) {
+        timers_.erase(it);
+      } else {
+        timer.expire = current_tick_ + timer.interval;
+        Place(id, timer.expire);
+      }
+    }
+    ++current_tick_;
+  }
+}
+
+bool TimerWheel::NextExpiry(TimePoint& expiry) const {
+  if (timers_.empty()) {
+    return false;
+  }
+  // The first non empty level 0 slot, or the next cascade when level 0 is empty.
+  uint64_t tick = current_tick_;
+  uint64_t lap_end = (current_tick_ | (kLevel0Size - 1)) + 1;
+  for (; tick < lap_end; ++tick) {
+    if (!slots_[tick & (kLevel0Size - 1)].empty()) {
+      break;
+    }
+  }
+  expiry = start_ + std::chrono::milliseconds(tick);
+  return true;
+}
+
+} // namespace lidar
+}  // namespace livox
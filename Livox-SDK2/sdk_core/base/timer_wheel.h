@@ -0,0 +1,83 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef LIVOX_TIMER_WHEEL_H_
+#define LIVOX_TIMER_WHEEL_H_
+
+#include <stdint.h>
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "noncopyable.h"
+
+namespace livox {
+namespace lidar {
+
+typedef std::chrono::steady_clock::time_point TimePoint;
+typedef std::function<void(TimePoint)> TimerCallback;
+typedef std::pair<uint64_t, TimerCallback> FiredTimer;
+
+/**
+ * Hierarchical timer wheel with a 1 ms tick. Level 0 has 256 slots of one tick, the three
+ * upper levels have 64 slots each covering the range of the level below, so a timer is
+ * touched once per level on its way down instead of on every tick. Timers are addressed by
+ * id, a removed timer is dropped lazily when its slot is reached. Not thread safe, the
+ * owning io loop serializes the calls.
+ */
+class TimerWheel : public noncopyable {
+ public:
+  TimerWheel();
+  /** Add a timer firing delay_ms from now, then every interval_ms if interval_ms is not 0. */
+  uint64_t AddTimer(TimePoint now, uint32_t delay_ms, uint32_t interval_ms, const TimerCallback& cb);
+  void RemoveTimer(uint64_t id);
+  /** Expire the timers due at now, their ids and callbacks are appended to fired. */
+  void Advance(TimePoint now, std::vector<FiredTimer>& fired);
+  /** Earliest time a timer may be due, false if there is no timer. */
+  bool NextExpiry(TimePoint& expiry) const;
+  bool Empty() const { return timers_.empty(); }
+
+ private:
+  typedef struct {
+    uint64_t expire;
+    uint32_t interval;
+    TimerCallback cb;
+  } Timer;
+
+  uint64_t GetTick(TimePoint now) const;
+  void Place(uint64_t id, uint64_t expire);
+  void Cascade(int level, uint32_t index);
+
+  TimePoint start_;
+  uint64_t current_tick_;
+  uint64_t next_id_;
+  std::unordered_map<uint64_t, Timer> timers_;
+  std::vector<std::vector<uint64_t>> slots_;
+};
+
+} // namespace lidar
+}  // namespace livox
+
+#endif  // LIVOX_TIMER_WHEEL_H_
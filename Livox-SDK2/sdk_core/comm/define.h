@@ -30,6 +30,7 @@
 #include <memory>
 #include <functional>
 #include <vector>
+#include <map>
 #include <atomic>
 
 #include "livox_lidar_def.h"
@@ -41,6 +42,21 @@ namespace lidar {
 
 const uint16_t KDefaultTimeOut = 1000;
 static const uint32_t kMaxCommandBufferSize = 1400;
+static const uint32_t kMaxDataIOThreadNum = 32;
+/** Spare receive buffers of a data io thread for the packets kept with LivoxLidarAcquirePacket. */
+static const uint32_t kDefaultPacketHandleNum = 64;
+/** Largest ring of a point cloud consumer, see LivoxLidarAddPointCloudConsumer. */
+static const uint32_t kMaxConsumerCapacity = 65536;
+
+/** SO_RCVBUF of each LivoxLidarSocketRole in bytes, the point data keeps the former 200 MB request. */
+static const uint32_t kDefaultSocketRecvBufferSize[kLivoxLidarSocketRoleNum] = {
+  200 * 1024 * 1024,  // point
+  1024 * 1024,        // imu
+  256 * 1024,         // cmd
+  256 * 1024,         // push
+  1024 * 1024,        // log
+  16 * 1024 * 1024    // debug
+};
 
 typedef struct {
   std::string lidar_ipaddr;
@@ -84,6 +100,35 @@ typedef struct {
 
 typedef struct {
   bool master_sdk;
+  uint32_t recv_batch_size;
+  uint32_t data_io_thread_num;
+  std::vector<int32_t> data_io_thread_cpus;               /* cpu of each data io thread, -1 means not bound. */
+  std::map<std::string, uint32_t> lidar_data_io_thread;   /* lidar ip -> data io thread index. */
+  bool data_reuseport_enable;                             /* one SO_REUSEPORT socket per data io thread. */
+  bool packet_ring_enable;                                /* capture point and imu data with a TPACKET_V3 ring. */
+  std::string packet_ring_netif;
+  uint32_t packet_ring_block_size;
+  uint32_t packet_ring_block_num;
+  uint32_t packet_ring_block_timeout_ms;
+  bool xdp_enable;                                        /* receive point and imu data with AF_XDP sockets. */
+  std::string xdp_netif;
+  std::vector<uint32_t> xdp_queues;
+  uint32_t xdp_frame_num;
+  bool io_uring_enable;                                   /* use io_uring for the data io threads. */
+  bool data_edge_triggered_enable;                        /* drain the data sockets edge triggered. */
+  uint32_t data_drain_budget;                             /* packets per data socket and wakeup. */
+  bool udp_gro_enable;                                    /* receive the point data coalesced with UDP_GRO. */
+  bool rx_timestamp_enable;                               /* stamp the data packets with the kernel receive time. */
+  bool busy_poll_enable;                                  /* busy poll in the data io threads. */
+  uint32_t busy_poll_idle_us;
+  uint32_t socket_busy_poll_us;                           /* SO_BUSY_POLL of the data sockets, 0 keeps the default. */
+  bool imu_io_thread_enable;                              /* receive the imu data on its own io thread. */
+  int32_t imu_io_thread_cpu;
+  uint32_t imu_io_thread_priority;                        /* SCHED_FIFO priority, 0 keeps the default policy. */
+  bool embedded_profile;                                  /* cap the threads, pools and buffers for small targets. */
+  uint32_t socket_rcvbuf[kLivoxLidarSocketRoleNum];       /* SO_RCVBUF of each socket role in bytes, 0 keeps the kernel default. */
+  uint32_t packet_handle_num;                             /* spare receive buffers per data io thread for the acquired packets. */
+  bool data_poll_enable;                                  /* the application receives the data with LivoxLidarPollData. */
 } LivoxLidarSdkFrameworkCfg;
 
 typedef enum {
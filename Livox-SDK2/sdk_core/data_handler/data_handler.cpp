@@ -24,6 +24,8 @@
 
 #include "data_handler.h"
 #include <base/logging.h>
+#include <algorithm>
+#include <chrono>
 
 #include "livox_lidar_def.h"
 
@@ -32,12 +34,70 @@ namespace livox {
 namespace lidar {
 
 static const size_t kPrefixDataSize = 18;
+// A batch is flushed early once it holds this many packets, their buffers are still valid then.
+static const size_t kMaxBatchPacketNum = 256;
+
+static thread_local uint64_t rx_timestamp = 0;
+
+// Depth of the Handle calls on this thread, a callback must not wait for its own Handle.
+static thread_local uint32_t handle_depth = 0;
+
+static thread_local RecvBufferPool* handle_recv_buffer_pool = nullptr;
+// Packet whose callbacks are being run on this thread.
+static thread_local uint8_t* handle_buf = nullptr;
+static thread_local uint32_t handle_buf_size = 0;
+
+// Packets handled on this thread since the last FlushBatch.
+static thread_local std::vector<LivoxLidarBatchPacket> batch_packets;
+
+// Time since the packet being handled was received, 0 if it carries no receive timestamp.
+static uint64_t GetRxLatency() {
+  if (rx_timestamp == 0) {
+    return 0;
+  }
+  uint64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  return (now > rx_timestamp) ? now - rx_timestamp : 0;
+}
 
 DataHandler::DataHandler()
     : point_data_callbacks_(nullptr),
       point_client_data_(nullptr),
       imu_data_callbacks_(nullptr),
-      imu_client_data_(nullptr) {
+      imu_client_data_(nullptr),
+      snapshot_(nullptr) {
+  ResetImuLatency();
+}
+
+void DataHandler::SetRxTimestamp(uint64_t timestamp) {
+  rx_timestamp = timestamp;
+}
+
+uint64_t DataHandler::GetRxTimestamp() {
+  return rx_timestamp;
+}
+
+void DataHandler::SetRecvBufferPool(RecvBufferPool* recv_buffer_pool) {
+  handle_recv_buffer_pool = recv_buffer_pool;
+}
+
+PacketRef* DataHandler::AcquirePacket(LivoxLidarEthernetPacket** packet) {
+  if (handle_buf == nullptr || (uint8_t*)(*packet) != handle_buf) {
+    return nullptr;
+  }
+  PacketRef* packet_ref = (handle_recv_buffer_pool != nullptr) ? handle_recv_buffer_pool->Retain(handle_buf) : nullptr;
+  if (packet_ref != nullptr) {
+    return packet_ref;
+  }
+  // Not in a pool, or the spares are used up, keep a copy instead.
+  uint8_t* data = nullptr;
+  packet_ref = (handle_recv_buffer_pool != nullptr) ?
+      handle_recv_buffer_pool->Copy(handle_buf, handle_buf_size, &data) :
+      CopyPacketRef(handle_buf, handle_buf_size, &data);
+  if (packet_ref != nullptr) {
+    *packet = (LivoxLidarEthernetPacket*)data;
+  }
+  return packet_ref;
 }
 
 DataHandler& DataHandler::GetInstance() {
@@ -51,18 +111,28 @@ bool DataHandler::Init() {
 }
 
 void DataHandler::Destory() {
-  point_data_callbacks_ = nullptr;
-  point_client_data_ = nullptr;
+  std::unique_ptr<const ObserverSnapshot> replaced;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    point_data_callbacks_ = nullptr;
+    point_client_data_ = nullptr;
 
-  imu_data_callbacks_ = nullptr;
-  imu_client_data_ = nullptr;
+    imu_data_callbacks_ = nullptr;
+    imu_client_data_ = nullptr;
 
-  std::lock_guard<std::mutex> lock(mutex_);
-  observers_.clear();
+    observers_.clear();
+    consumers_.clear();
+    batch_observers_.clear();
+    replaced = PublishSnapshot();
+  }
+  RetireSnapshot(std::move(replaced));
+
+  ResetImuLatency();
 }
 
 DataHandler::~DataHandler() {
   Destory();
+  delete snapshot_.exchange(nullptr);
 }
 
 
@@ -72,42 +142,305 @@ void DataHandler::Handle(const uint8_t dev_type, const uint32_t handle, uint8_t
     return;
   }
 
-  if (lidar_data->data_type == kLivoxLidarImuData) {
-    if (imu_data_callbacks_) {
-      imu_data_callbacks_(handle, dev_type, lidar_data, imu_client_data_);
+  // The latency is taken up to the imu callback, the stats are only updated once it returned.
+  uint64_t imu_latency = (lidar_data->data_type == kLivoxLidarImuData) ? GetRxLatency() : 0;
+
+  handle_buf = buf;
+  handle_buf_size = buf_size;
+  uint32_t slot = ReadLock();
+  const ObserverSnapshot* snapshot = snapshot_.load();
+  if (snapshot != nullptr) {
+    if (lidar_data->data_type == kLivoxLidarImuData) {
+      if (snapshot->imu_data_callback) {
+        snapshot->imu_data_callback(handle, dev_type, lidar_data, snapshot->imu_client_data);
+      }
+    } else {
+      if (snapshot->point_data_callback) {
+        snapshot->point_data_callback(handle, dev_type, lidar_data, snapshot->point_client_data);
+      }
+    }
+
+    for (const auto& observer : snapshot->observers) {
+      observer.first(handle, dev_type, lidar_data, observer.second);
+    }
+    if (lidar_data->data_type < kPointDataTypeNum) {
+      for (const auto& observer : snapshot->type_observers[lidar_data->data_type]) {
+        observer.first(handle, dev_type, lidar_data, observer.second);
+      }
+    }
+
+    if (!snapshot->consumers.empty()) {
+      // One reference per consumer, each releases its own once its callback has run.
+      LivoxLidarEthernetPacket* packet = lidar_data;
+      PacketRef* packet_ref = AcquirePacket(&packet);
+      if (packet_ref != nullptr) {
+        for (size_t i = 1; i < snapshot->consumers.size(); ++i) {
+          AddPacketRef(packet_ref);
+        }
+        for (const auto& consumer : snapshot->consumers) {
+          consumer->Push(handle, dev_type, packet_ref, packet);
+        }
+      }
+    }
+
+    if (!snapshot->batch_observers.empty()) {
+      if (batch_packets.capacity() == 0) {
+        batch_packets.reserve(kMaxBatchPacketNum);
+      }
+      LivoxLidarBatchPacket batch_packet = {handle, dev_type, lidar_data};
+      batch_packets.push_back(batch_packet);
+    }
+  }
+  ReadUnlock(slot);
+  handle_buf = nullptr;
+
+  if (imu_latency != 0) {
+    UpdateImuLatency(handle, imu_latency);
+  }
+
+  if (batch_packets.size() >= kMaxBatchPacketNum) {
+    FlushBatch();
+  }
+}
+
+void DataHandler::FlushBatch() {
+  if (batch_packets.empty()) {
+    return;
+  }
+  uint32_t slot = ReadLock();
+  const ObserverSnapshot* snapshot = snapshot_.load();
+  if (snapshot != nullptr) {
+    for (const auto& batch_observer : snapshot->batch_observers) {
+      batch_observer.first(batch_packets.data(), static_cast<uint32_t>(batch_packets.size()), batch_observer.second);
+    }
+  }
+  ReadUnlock(slot);
+  batch_packets.clear();
+}
+
+uint32_t DataHandler::ReadLock() {
+  ++handle_depth;
+  return reader_epoch_.ReadLock();
+}
+
+void DataHandler::ReadUnlock(uint32_t slot) {
+  reader_epoch_.ReadUnlock(slot);
+  --handle_depth;
+}
+
+std::unique_ptr<const DataHandler::ObserverSnapshot> DataHandler::PublishSnapshot() {
+  std::unique_ptr<ObserverSnapshot> snapshot(new ObserverSnapshot());
+  snapshot->point_data_callback = point_data_callbacks_;
+  snapshot->point_client_data = point_client_data_;
+  snapshot->imu_data_callback = imu_data_callbacks_;
+  snapshot->imu_client_data = imu_client_data_;
+  for (const auto& observer : observers_) {
+    const Observer& entry = observer.second;
+    if (entry.cb == nullptr) {
+      continue;
     }
-  } else {  
-    if (point_data_callbacks_) {
-      point_data_callbacks_(handle, dev_type, lidar_data, point_client_data_);
+    if (entry.data_type == kAnyDataType) {
+      snapshot->observers.emplace_back(entry.cb, entry.client_data);
+    } else {
+      snapshot->type_observers[entry.data_type].emplace_back(entry.cb, entry.client_data);
     }
   }
+  snapshot->consumers.reserve(consumers_.size());
+  for (const auto& consumer : consumers_) {
+    snapshot->consumers.push_back(consumer.second);
+  }
+  snapshot->batch_observers.reserve(batch_observers_.size());
+  for (const auto& batch_observer : batch_observers_) {
+    snapshot->batch_observers.push_back(batch_observer.second);
+  }
+
+  return std::unique_ptr<const ObserverSnapshot>(snapshot_.exchange(snapshot.release()));
+}
 
+void DataHandler::RetireSnapshot(std::unique_ptr<const ObserverSnapshot> snapshot) {
+  if (handle_depth > 0 || PacketConsumer::InConsumerThread()) {
+    // Changed from a callback, the snapshot is freed by the next change made outside one. Freeing
+    // it may also stop a consumer, which a consumer thread can not wait for.
+    std::lock_guard<std::mutex> lock(retired_mutex_);
+    retired_snapshots_.push_back(std::move(snapshot));
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(synchronize_mutex_);
+  // Only the snapshots retired before the grace period starts are sure to be unused after it.
+  std::vector<std::unique_ptr<const ObserverSnapshot>> retired_snapshots;
   {
-    std::lock_guard<std::mutex> lock(mutex_);
-    for (const auto& observer : observers_) {
-      auto callback = observer.second.first;
-      auto client_data = observer.second.second;
-      if (callback) {
-        callback(handle, dev_type, lidar_data, client_data);
-      }
+    std::lock_guard<std::mutex> retired_lock(retired_mutex_);
+    retired_snapshots.swap(retired_snapshots_);
+  }
+  reader_epoch_.Synchronize();
+}
+
+DataHandler::ImuLatency* DataHandler::FindImuLatency(uint32_t handle, bool insert) {
+  if (handle == 0) {
+    return nullptr;
+  }
+  size_t mask = kImuLatencySlotNum - 1;
+  size_t begin = static_cast<size_t>((handle * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+  for (size_t n = 0, i = begin; n < kImuLatencySlotNum; ++n, i = (i + 1) & mask) {
+    ImuLatency& imu_latency = imu_latency_[i];
+    uint32_t slot_handle = imu_latency.handle.load(std::memory_order_acquire);
+    if (slot_handle == handle) {
+      return &imu_latency;
+    }
+    if (slot_handle != 0) {
+      continue;
+    }
+    if (!insert) {
+      return nullptr;
+    }
+    // Another io thread may claim the same free slot for its own lidar.
+    if (imu_latency.handle.compare_exchange_strong(slot_handle, handle, std::memory_order_acq_rel) ||
+        slot_handle == handle) {
+      return &imu_latency;
     }
   }
+  return nullptr;
+}
+
+void DataHandler::UpdateImuLatency(uint32_t handle, uint64_t latency) {
+  ImuLatency* imu_latency = FindImuLatency(handle, true);
+  if (imu_latency == nullptr) {
+    return;
+  }
+  imu_latency->sum.fetch_add(latency, std::memory_order_relaxed);
+  uint64_t max = imu_latency->max.load(std::memory_order_relaxed);
+  while (latency > max && !imu_latency->max.compare_exchange_weak(max, latency, std::memory_order_relaxed)) {
+  }
+  imu_latency->last.store(latency, std::memory_order_relaxed);
+  imu_latency->count.fetch_add(1, std::memory_order_release);
+}
+
+void DataHandler::ResetImuLatency() {
+  for (ImuLatency& imu_latency : imu_latency_) {
+    imu_latency.count.store(0, std::memory_order_relaxed);
+    imu_latency.sum.store(0, std::memory_order_relaxed);
+    imu_latency.max.store(0, std::memory_order_relaxed);
+    imu_latency.last.store(0, std::memory_order_relaxed);
+    imu_latency.handle.store(0, std::memory_order_release);
+  }
 }
 
-uint16_t DataHandler::AddPointCloudObserver(const DataCallback &cb, void *client_data) {
+bool DataHandler::GetImuLatencyStats(uint32_t handle, LivoxLidarImuLatencyStats* stats) {
+  const ImuLatency* imu_latency = FindImuLatency(handle, false);
+  if (imu_latency == nullptr) {
+    return false;
+  }
+  // The fields are read one by one, the average may be off by the packet being recorded.
+  uint64_t count = imu_latency->count.load(std::memory_order_acquire);
+  if (count == 0) {
+    return false;
+  }
+  stats->packet_count = count;
+  stats->avg_latency_ns = imu_latency->sum.load(std::memory_order_relaxed) / count;
+  stats->max_latency_ns = imu_latency->max.load(std::memory_order_relaxed);
+  stats->last_latency_ns = imu_latency->last.load(std::memory_order_relaxed);
+  return true;
+}
+
+uint16_t DataHandler::AddPointCloudObserver(LivoxLidarPointCloudObserver cb, void *client_data, uint8_t data_type) {
+  if (data_type != kAnyDataType && data_type >= kPointDataTypeNum) {
+    LOG_ERROR("Add point cloud observer failed, the data type {} is unknown.", data_type);
+    return 0;
+  }
   uint16_t observer_id = GenerateObserverId();
+  std::unique_ptr<const ObserverSnapshot> replaced;
   {
     std::lock_guard<std::mutex> lock(mutex_);
-    observers_[observer_id] = std::make_pair(cb, client_data);
+    Observer observer = {cb, client_data, data_type};
+    observers_[observer_id] = observer;
+    replaced = PublishSnapshot();
   }
+  RetireSnapshot(std::move(replaced));
   return observer_id;
 }
 
 void DataHandler::RemovePointCloudObserver(uint16_t id) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  if (observers_.find(id) != observers_.end()) {
+  // Once this returns outside a callback, the removed observer is not called any more.
+  std::unique_ptr<const ObserverSnapshot> replaced;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (observers_.find(id) == observers_.end()) {
+      return;
+    }
     observers_.erase(id);
+    replaced = PublishSnapshot();
   }
+  RetireSnapshot(std::move(replaced));
+}
+
+uint16_t DataHandler::AddPointCloudBatchObserver(LivoxLidarPointCloudBatchObserver cb, void* client_data) {
+  uint16_t observer_id = GenerateObserverId();
+  std::unique_ptr<const ObserverSnapshot> replaced;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batch_observers_[observer_id] = std::make_pair(cb, client_data);
+    replaced = PublishSnapshot();
+  }
+  RetireSnapshot(std::move(replaced));
+  return observer_id;
+}
+
+void DataHandler::RemovePointCloudBatchObserver(uint16_t id) {
+  std::unique_ptr<const ObserverSnapshot> replaced;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (batch_observers_.find(id) == batch_observers_.end()) {
+      return;
+    }
+    batch_observers_.erase(id);
+    replaced = PublishSnapshot();
+  }
+  RetireSnapshot(std::move(replaced));
+}
+
+uint16_t DataHandler::AddPointCloudConsumer(LivoxLidarPointCloudObserver cb, void* client_data, uint32_t capacity,
+                                            LivoxLidarOverflowPolicy policy) {
+  std::shared_ptr<PacketConsumer> consumer = std::make_shared<PacketConsumer>(cb, client_data, capacity, policy);
+  if (!consumer->Start()) {
+    LOG_ERROR("Start the point cloud consumer thread failed.");
+    return 0;
+  }
+
+  uint16_t consumer_id = GenerateObserverId();
+  std::unique_ptr<const ObserverSnapshot> replaced;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    consumers_[consumer_id] = consumer;
+    replaced = PublishSnapshot();
+  }
+  RetireSnapshot(std::move(replaced));
+  return consumer_id;
+}
+
+void DataHandler::RemovePointCloudConsumer(uint16_t id) {
+  // The consumer thread stops, and its queued packets are released, once no io thread can
+  // push to it any more.
+  std::unique_ptr<const ObserverSnapshot> replaced;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (consumers_.find(id) == consumers_.end()) {
+      return;
+    }
+    consumers_.erase(id);
+    replaced = PublishSnapshot();
+  }
+  RetireSnapshot(std::move(replaced));
+}
+
+bool DataHandler::GetConsumerStats(uint16_t id, LivoxLidarConsumerStats* stats) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = consumers_.find(id);
+  if (it == consumers_.end()) {
+    return false;
+  }
+  it->second->GetStats(stats);
+  return true;
 }
 
 uint16_t DataHandler::GenerateObserverId() {
@@ -124,14 +457,26 @@ uint16_t DataHandler::GenerateObserverId() {
   return desired;
 }
 
-void DataHandler::SetPointDataCallback(const DataCallback& cb, void *client_data) {
-  point_data_callbacks_ = cb;
-  point_client_data_ = client_data;
+void DataHandler::SetPointDataCallback(LivoxLidarPointCloudCallBack cb, void *client_data) {
+  std::unique_ptr<const ObserverSnapshot> replaced;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    point_data_callbacks_ = cb;
+    point_client_data_ = client_data;
+    replaced = PublishSnapshot();
+  }
+  RetireSnapshot(std::move(replaced));
 }
 
-void DataHandler::SetImuDataCallback(const DataCallback& cb, void* client_data) {
-  imu_data_callbacks_ = cb;
-  imu_client_data_ = client_data;
+void DataHandler::SetImuDataCallback(LivoxLidarImuDataCallback cb, void* client_data) {
+  std::unique_ptr<const ObserverSnapshot> replaced;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    imu_data_callbacks_ = cb;
+    imu_client_data_ = client_data;
+    replaced = PublishSnapshot();
+  }
+  RetireSnapshot(std::move(replaced));
 }
 
 } // namespace lidar
@@ -26,13 +26,20 @@
 #define LIVOX_DATA_HANDLER_H_
 
 #include <array>
+#include <atomic>
 #include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <utility>
+#include <vector>
 
 #include "comm/define.h"
 #include "base/io_loop.h"
+#include "base/reader_epoch.h"
+#include "base/recv_buffer_pool.h"
+#include "packet_consumer.h"
+#include "livox_lidar_def.h"
 
 namespace livox {
 namespace lidar {
@@ -43,6 +50,9 @@ class DataHandler : public noncopyable {
   DataHandler(const DataHandler& other) = delete;
   DataHandler& operator=(const DataHandler& other) = delete;
  public:
+  static const uint8_t kAnyDataType = 0xFF;
+  static const uint8_t kPointDataTypeNum = kLivoxLidarSphericalCoordinateData + 1;
+
   void Destory();
   ~DataHandler();
   static DataHandler& GetInstance();
@@ -51,23 +61,104 @@ class DataHandler : public noncopyable {
 
   void Handle(const uint8_t dev_type, const uint32_t handle, uint8_t *buf, uint32_t buf_size);
 
-  uint16_t AddPointCloudObserver(const DataCallback &cb, void *client_data);
+  /** data_type limits the observer to the packets of one LivoxLidarPointDataType, kAnyDataType takes all. */
+  uint16_t AddPointCloudObserver(LivoxLidarPointCloudObserver cb, void *client_data, uint8_t data_type = kAnyDataType);
   void RemovePointCloudObserver(uint16_t id);
 
-  void SetPointDataCallback(const DataCallback& cb, void *client_data);
-  void SetImuDataCallback(const DataCallback& cb, void* client_data);
+  uint16_t AddPointCloudBatchObserver(LivoxLidarPointCloudBatchObserver cb, void* client_data);
+  void RemovePointCloudBatchObserver(uint16_t id);
+  /**
+   * Passes the packets handled on the calling thread since the last call to the batch
+   * observers. The receive paths call it before the buffers of those packets are reused.
+   */
+  void FlushBatch();
+
+  /** 0 on failure. */
+  uint16_t AddPointCloudConsumer(LivoxLidarPointCloudObserver cb, void* client_data, uint32_t capacity,
+                                 LivoxLidarOverflowPolicy policy);
+  void RemovePointCloudConsumer(uint16_t id);
+  bool GetConsumerStats(uint16_t id, LivoxLidarConsumerStats* stats);
+
+  void SetPointDataCallback(LivoxLidarPointCloudCallBack cb, void *client_data);
+  void SetImuDataCallback(LivoxLidarImuDataCallback cb, void* client_data);
+
+  /** Receive time of the packet being handled on the calling thread, see LivoxLidarGetRxTimestamp. */
+  static void SetRxTimestamp(uint64_t timestamp);
+  static uint64_t GetRxTimestamp();
+
+  /** Pool holding the packets handled on the calling thread, nullptr if they are not received into one. */
+  static void SetRecvBufferPool(RecvBufferPool* recv_buffer_pool);
+  /** Reference on the packet of the data callback being run, see LivoxLidarAcquirePacket. */
+  static PacketRef* AcquirePacket(LivoxLidarEthernetPacket** packet);
+
+  /** False if no imu packet of the lidar carried a receive timestamp. */
+  bool GetImuLatencyStats(uint32_t handle, LivoxLidarImuLatencyStats* stats);
 
  private:
+  // Written by the io thread of the lidar, a slot is claimed for good by storing its handle.
+  typedef struct {
+    std::atomic<uint32_t> handle;
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> max;
+    std::atomic<uint64_t> last;
+  } ImuLatency;
+  // Open addressing like the RouteTable, kept at a load factor of at most 1/2.
+  static const size_t kImuLatencySlotNum = 2 * kMaxLidarCount;
+
+  typedef struct {
+    LivoxLidarPointCloudObserver cb;
+    void* client_data;
+    uint8_t data_type;
+  } Observer;
+
+  // Immutable once published, Handle reads it without a lock and calls plain function pointers.
+  typedef struct {
+    LivoxLidarPointCloudCallBack point_data_callback;
+    void* point_client_data;
+    LivoxLidarImuDataCallback imu_data_callback;
+    void* imu_client_data;
+    std::vector<std::pair<LivoxLidarPointCloudObserver, void*>> observers;
+    // The observers of one data type, indexed by it, so they are not called for the other packets.
+    std::vector<std::pair<LivoxLidarPointCloudObserver, void*>> type_observers[kPointDataTypeNum];
+    std::vector<std::shared_ptr<PacketConsumer>> consumers;
+    std::vector<std::pair<LivoxLidarPointCloudBatchObserver, void*>> batch_observers;
+  } ObserverSnapshot;
+
   uint16_t GenerateObserverId();
+  /** Nullptr if the lidar has no slot and insert is false. */
+  ImuLatency* FindImuLatency(uint32_t handle, bool insert);
+  void UpdateImuLatency(uint32_t handle, uint64_t latency);
+  void ResetImuLatency();
+
+  uint32_t ReadLock();
+  void ReadUnlock(uint32_t slot);
+  /** Called with mutex_ held, replaces the snapshot with one built from the callbacks below. */
+  std::unique_ptr<const ObserverSnapshot> PublishSnapshot();
+  /** Called without mutex_, frees a replaced snapshot once no Handle can still see it. */
+  void RetireSnapshot(std::unique_ptr<const ObserverSnapshot> snapshot);
  private:
-  DataCallback point_data_callbacks_;
+  // Written under mutex_, Handle only sees them through snapshot_.
+  LivoxLidarPointCloudCallBack point_data_callbacks_;
   void* point_client_data_;
 
-  DataCallback imu_data_callbacks_;
+  LivoxLidarImuDataCallback imu_data_callbacks_;
   void* imu_client_data_;
 
-  std::map<uint16_t, std::pair<DataCallback, void*>> observers_;
+  std::map<uint16_t, Observer> observers_;
+  std::map<uint16_t, std::shared_ptr<PacketConsumer>> consumers_;
+  std::map<uint16_t, std::pair<LivoxLidarPointCloudBatchObserver, void*>> batch_observers_;
   std::mutex mutex_;
+
+  std::atomic<const ObserverSnapshot*> snapshot_;
+  // Handle reads snapshot_ inside a read section, a replaced snapshot is freed after a grace period.
+  ReaderEpoch reader_epoch_;
+  std::mutex synchronize_mutex_;
+  // Snapshots replaced from inside a callback, which can not wait for itself to return.
+  std::mutex retired_mutex_;
+  std::vector<std::unique_ptr<const ObserverSnapshot>> retired_snapshots_;
+
+  ImuLatency imu_latency_[kImuLatencySlotNum];
 };
 
 } // namespace lidar
@@ -0,0 +1,320 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include "packet_consumer.h"
+
+#include <chrono>
+#include <thread>
+
+#include "base/logging.h"
+
+namespace livox {
+namespace lidar {
+
+// The data io threads, the imu io thread and room for the threads of a later init.
+static const uint32_t kMaxProducerNum = 64;
+// Bounds the wait of a consumer thread in case a wake up is missed.
+static const uint32_t kConsumerWaitMs = 100;
+
+static std::mutex producer_mutex;
+static std::vector<bool> producer_used(kMaxProducerNum, false);
+
+namespace {
+
+// Gives each thread handling the data its own ring of every consumer, and frees the index
+// when the thread exits, so the next thread may take over its rings.
+class ProducerIndex {
+ public:
+  ProducerIndex() : index_(-1) {
+    std::lock_guard<std::mutex> lock(producer_mutex);
+    for (uint32_t i = 0; i < kMaxProducerNum; ++i) {
+      if (!producer_used[i]) {
+        producer_used[i] = true;
+        index_ = static_cast<int32_t>(i);
+        return;
+      }
+    }
+  }
+  ~ProducerIndex() {
+    if (index_ >= 0) {
+      std::lock_guard<std::mutex> lock(producer_mutex);
+      producer_used[index_] = false;
+    }
+  }
+  int32_t Get() const { return index_; }
+
+ private:
+  int32_t index_;
+};
+
+}  // namespace
+
+static thread_local ProducerIndex producer_index;
+static thread_local bool in_consumer_thread = false;
+
+ConsumerRing::ConsumerRing(uint32_t capacity)
+    : capacity_(capacity),
+      slots_(new Slot[capacity]) {
+  head_.value.store(0);
+  tail_.value.store(0);
+}
+
+ConsumerRing::~ConsumerRing() {
+  Item item;
+  while (Pop(&item)) {
+    ReleasePacketRef(item.packet_ref);
+  }
+}
+
+void ConsumerRing::Load(uint64_t index, Item* item) const {
+  const Slot& slot = slots_[index % capacity_];
+  uint64_t meta = slot.meta.load(std::memory_order_relaxed);
+  item->handle = static_cast<uint32_t>(meta >> 8);
+  item->dev_type = static_cast<uint8_t>(meta);
+  item->packet_ref = slot.packet_ref.load(std::memory_order_relaxed);
+  item->packet = slot.packet.load(std::memory_order_relaxed);
+}
+
+bool ConsumerRing::Push(const Item& item) {
+  uint64_t tail = tail_.value.load(std::memory_order_relaxed);
+  if (tail - head_.value.load(std::memory_order_acquire) >= capacity_) {
+    return false;
+  }
+  // The slot was last used by the packet tail - capacity_, which is owned by whoever moved
+  // head_ past it, so it is free to overwrite.
+  Slot& slot = slots_[tail % capacity_];
+  slot.meta.store((static_cast<uint64_t>(item.handle) << 8) | item.dev_type, std::memory_order_relaxed);
+  slot.packet_ref.store(item.packet_ref, std::memory_order_relaxed);
+  slot.packet.store(item.packet, std::memory_order_relaxed);
+  tail_.value.store(tail + 1, std::memory_order_seq_cst);
+  return true;
+}
+
+bool ConsumerRing::DropOldest(Item* item) {
+  uint64_t head = head_.value.load(std::memory_order_acquire);
+  if (tail_.value.load(std::memory_order_relaxed) - head < capacity_) {
+    return false;
+  }
+  // The producer wrote the slot itself, it may read it back at any time.
+  Load(head, item);
+  return head_.value.compare_exchange_strong(head, head + 1, std::memory_order_acq_rel);
+}
+
+bool ConsumerRing::Pop(Item* item) {
+  uint64_t head = head_.value.load(std::memory_order_acquire);
+  while (head < tail_.value.load(std::memory_order_acquire)) {
+    // The producer may drop this packet and reuse its slot meanwhile, the copy is only kept
+    // if head_ still points to it.
+    Load(head, item);
+    if (head_.value.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint32_t ConsumerRing::Size() const {
+  uint64_t head = head_.value.load(std::memory_order_acquire);
+  uint64_t tail = tail_.value.load(std::memory_order_acquire);
+  return tail > head ? static_cast<uint32_t>(tail - head) : 0;
+}
+
+PacketConsumer::PacketConsumer(LivoxLidarPointCloudObserver cb, void* client_data, uint32_t capacity,
+                               LivoxLidarOverflowPolicy policy)
+    : cb_(cb),
+      client_data_(client_data),
+      capacity_(capacity),
+      policy_(policy),
+      rings_(new std::atomic<ConsumerRing*>[kMaxProducerNum]),
+      waiting_(false),
+      blocked_num_(0),
+      stopping_(false),
+      started_(false),
+      delivered_count_(0),
+      dropped_count_(0) {
+  for (uint32_t i = 0; i < kMaxProducerNum; ++i) {
+    rings_[i].store(nullptr);
+  }
+}
+
+PacketConsumer::~PacketConsumer() {
+  Stop();
+}
+
+bool PacketConsumer::Start() {
+  SetName("livox_consumer");
+  started_ = ThreadBase::Start();
+  return started_;
+}
+
+void PacketConsumer::Stop() {
+  if (stopping_.exchange(true)) {
+    return;
+  }
+  Notify();
+  {
+    std::lock_guard<std::mutex> lock(space_mutex_);
+    space_cv_.notify_all();
+  }
+  if (started_) {
+    Join();
+  }
+  // The packets left in the rings are released by the rings.
+}
+
+ConsumerRing* PacketConsumer::GetProducerRing() {
+  int32_t index = producer_index.Get();
+  if (index < 0) {
+    return nullptr;
+  }
+  ConsumerRing* ring = rings_[index].load(std::memory_order_acquire);
+  if (ring != nullptr) {
+    return ring;
+  }
+  std::unique_ptr<ConsumerRing> ring_owner(new ConsumerRing(capacity_));
+  ring = ring_owner.get();
+  {
+    std::lock_guard<std::mutex> lock(ring_owners_mutex_);
+    ring_owners_.push_back(std::move(ring_owner));
+  }
+  rings_[index].store(ring, std::memory_order_release);
+  return ring;
+}
+
+void PacketConsumer::Push(uint32_t handle, uint8_t dev_type, PacketRef* packet_ref, LivoxLidarEthernetPacket* packet) {
+  ConsumerRing* ring = GetProducerRing();
+  if (ring == nullptr) {
+    dropped_count_.fetch_add(1, std::memory_order_relaxed);
+    ReleasePacketRef(packet_ref);
+    return;
+  }
+
+  ConsumerRing::Item item = {handle, dev_type, packet_ref, packet};
+  while (!ring->Push(item)) {
+    if (policy_ == kLivoxLidarOverflowDropNewest || stopping_.load()) {
+      dropped_count_.fetch_add(1, std::memory_order_relaxed);
+      ReleasePacketRef(packet_ref);
+      return;
+    }
+    if (policy_ == kLivoxLidarOverflowDropOldest) {
+      ConsumerRing::Item oldest;
+      if (ring->DropOldest(&oldest)) {
+        dropped_count_.fetch_add(1, std::memory_order_relaxed);
+        ReleasePacketRef(oldest.packet_ref);
+      }
+      continue;
+    }
+    // kLivoxLidarOverflowBlock, the io thread sleeps until the consumer makes room. It must not
+    // spin, a SCHED_FIFO io thread would starve the consumer.
+    Notify();
+    std::unique_lock<std::mutex> lock(space_mutex_);
+    blocked_num_.fetch_add(1);
+    space_cv_.wait_for(lock, std::chrono::milliseconds(kConsumerWaitMs), [this, ring]() {
+      return ring->Size() < capacity_ || stopping_.load();
+    });
+    blocked_num_.fetch_sub(1);
+  }
+
+  if (waiting_.load()) {
+    Notify();
+  }
+}
+
+void PacketConsumer::Notify() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cv_.notify_one();
+}
+
+bool PacketConsumer::IsEmpty() {
+  for (uint32_t i = 0; i < kMaxProducerNum; ++i) {
+    ConsumerRing* ring = rings_[i].load(std::memory_order_acquire);
+    if (ring != nullptr && ring->Size() != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PacketConsumer::Drain() {
+  bool drained = false;
+  // A round takes at most one ring's worth from each io thread, so none of them starves.
+  for (uint32_t i = 0; i < kMaxProducerNum; ++i) {
+    ConsumerRing* ring = rings_[i].load(std::memory_order_acquire);
+    if (ring == nullptr) {
+      continue;
+    }
+    ConsumerRing::Item item;
+    for (uint32_t n = 0; n < capacity_ && ring->Pop(&item); ++n) {
+      cb_(item.handle, item.dev_type, item.packet, client_data_);
+      ReleasePacketRef(item.packet_ref);
+      delivered_count_.fetch_add(1, std::memory_order_relaxed);
+      drained = true;
+    }
+  }
+  if (drained && blocked_num_.load() != 0) {
+    std::lock_guard<std::mutex> lock(space_mutex_);
+    space_cv_.notify_all();
+  }
+  return drained;
+}
+
+bool PacketConsumer::InConsumerThread() {
+  return in_consumer_thread;
+}
+
+void PacketConsumer::ThreadFunc() {
+  in_consumer_thread = true;
+  while (!stopping_.load()) {
+    if (Drain()) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    // Announce the wait before the last look at the rings, a producer pushing meanwhile then
+    // sees waiting_ and notifies once the wait has begun.
+    waiting_.store(true);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (IsEmpty() && !stopping_.load()) {
+      cv_.wait_for(lock, std::chrono::milliseconds(kConsumerWaitMs));
+    }
+    waiting_.store(false);
+  }
+}
+
+void PacketConsumer::GetStats(LivoxLidarConsumerStats* stats) {
+  uint32_t queued_num = 0;
+  for (uint32_t i = 0; i < kMaxProducerNum; ++i) {
+    ConsumerRing* ring = rings_[i].load(std::memory_order_acquire);
+    if (ring != nullptr) {
+      queued_num += ring->Size();
+    }
+  }
+  stats->capacity = capacity_;
+  stats->queued_num = queued_num;
+  stats->delivered_count = delivered_count_.load(std::memory_order_relaxed);
+  stats->dropped_count = dropped_count_.load(std::memory_order_relaxed);
+}
+
+} // namespace lidar
+}  // namespace livox
@@ -0,0 +1,143 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef LIVOX_PACKET_CONSUMER_H_
+#define LIVOX_PACKET_CONSUMER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "base/recv_buffer_pool.h"
+#include "base/thread_base.h"
+#include "livox_lidar_def.h"
+
+namespace livox {
+namespace lidar {
+
+/**
+ * Bounded single producer single consumer ring of acquired packets. The producer may also
+ * drop the oldest packet, so both ends advance head_ with a compare and swap, and only the
+ * winner owns the packet.
+ */
+class ConsumerRing : public noncopyable {
+ public:
+  explicit ConsumerRing(uint32_t capacity);
+  ~ConsumerRing();
+
+  typedef struct {
+    uint32_t handle;
+    uint8_t dev_type;
+    PacketRef* packet_ref;
+    LivoxLidarEthernetPacket* packet;
+  } Item;
+
+  /** Producer side, false if the ring is full. */
+  bool Push(const Item& item);
+  /** Producer side, drops the oldest packet of a full ring into *item. */
+  bool DropOldest(Item* item);
+  /** Consumer side. */
+  bool Pop(Item* item);
+  uint32_t Size() const;
+
+ private:
+  typedef struct {
+    std::atomic<uint64_t> meta;
+    std::atomic<PacketRef*> packet_ref;
+    std::atomic<LivoxLidarEthernetPacket*> packet;
+  } Slot;
+
+  // The ring is allocated with the default alignment, a whole cache line of padding on both
+  // sides keeps an index on cache lines of its own wherever the ring lands.
+  typedef struct {
+    char front_pad[kCacheLineSize];
+    std::atomic<uint64_t> value;
+    char back_pad[kCacheLineSize];
+  } PaddedIndex;
+
+  void Load(uint64_t index, Item* item) const;
+
+  uint32_t capacity_;
+  std::unique_ptr<Slot[]> slots_;
+  PaddedIndex head_;
+  PaddedIndex tail_;
+};
+
+/**
+ * Hands the packets over from the io threads to a thread of its own, which runs the callback,
+ * so a slow callback only holds up its own packets. Each io thread gets a ring, the packets of
+ * one io thread, and so of one lidar, keep their order.
+ */
+class PacketConsumer : public ThreadBase {
+ public:
+  PacketConsumer(LivoxLidarPointCloudObserver cb, void* client_data, uint32_t capacity,
+                 LivoxLidarOverflowPolicy policy);
+  ~PacketConsumer();
+
+  bool Start();
+  void Stop();
+  /** Called by the io threads, takes over the reference on the packet. */
+  void Push(uint32_t handle, uint8_t dev_type, PacketRef* packet_ref, LivoxLidarEthernetPacket* packet);
+  void GetStats(LivoxLidarConsumerStats* stats);
+  /** True on the thread of any consumer, which must not wait for a consumer to stop. */
+  static bool InConsumerThread();
+  void ThreadFunc();
+
+ private:
+  ConsumerRing* GetProducerRing();
+  bool Drain();
+  bool IsEmpty();
+  void Notify();
+
+  LivoxLidarPointCloudObserver cb_;
+  void* client_data_;
+  uint32_t capacity_;
+  LivoxLidarOverflowPolicy policy_;
+
+  // Indexed by the producer index of the io thread, created by that thread on its first packet.
+  std::unique_ptr<std::atomic<ConsumerRing*>[]> rings_;
+  std::vector<std::unique_ptr<ConsumerRing>> ring_owners_;
+  std::mutex ring_owners_mutex_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::atomic<bool> waiting_;
+  // The io threads blocked on a full ring, woken once the consumer made room.
+  std::mutex space_mutex_;
+  std::condition_variable space_cv_;
+  std::atomic<uint32_t> blocked_num_;
+  std::atomic<bool> stopping_;
+  bool started_;
+
+  std::atomic<uint64_t> delivered_count_;
+  std::atomic<uint64_t> dropped_count_;
+};
+
+} // namespace lidar
+}  // namespace livox
+
+#endif  // LIVOX_PACKET_CONSUMER_H_
@@ -26,6 +26,7 @@
 
 #include "FastCRC/FastCRC.h"
 #include "spdlog/fmt/fmt.h"
+#include "device_manager.h"
 
 #include <algorithm>
 #include <iostream>
@@ -41,11 +42,6 @@ DebugPointCloudHandler::DebugPointCloudHandler(std::uint32_t handle, std::string
 }
 
 DebugPointCloudHandler::~DebugPointCloudHandler() {
-  if (thread_ptr_) {
-    enable_.store(false);
-    thread_ptr_->join();
-    thread_ptr_ = nullptr;
-  }
 }
 
 const std::string GetCurrentSystemTime() {
@@ -62,58 +58,70 @@ const std::string GetCurrentSystemTime() {
 }
 
 bool DebugPointCloudHandler::StoreData(uint8_t* buf, uint32_t buf_size) {
-  if (buf) {
-    std::unique_lock<std::mutex> lock(data_mutex_);
+  if (buf == nullptr || !enable_.load()) {
+    return false;
+  }
+  bool post = false;
+  {
+    std::lock_guard<std::mutex> lock(data_mutex_);
+    // One write task is pending while data is buffered.
+    post = data_.empty();
     std::copy(buf, buf + buf_size, std::back_inserter(data_));
-    lock.unlock();
-    cv_.notify_one();
-    return true;
   }
-  return false;
+  if (post) {
+    std::shared_ptr<IOLoop> loop = DeviceManager::GetInstance().GetControlLoop();
+    if (!loop) {
+      return false;
+    }
+    std::shared_ptr<DebugPointCloudHandler> self = shared_from_this();
+    loop->PostTask([self]() { self->WriteData(); });
+  }
+  return true;
 }
 
 void DebugPointCloudHandler::WriteData() {
-  while (enable_.load()) {
-    std::unique_lock<std::mutex> lock(data_mutex_);
-    cv_.wait_for(lock, std::chrono::seconds(1), [this]{return !data_.empty() || !enable_.load();});
-    if (!enable_.load()) return;
-    if (file_size_ >=  max_file_size_) {
-      LOG_WARN("{} file size over 4 GB", file_name_);
+  std::vector<uint8_t> data;
+  {
+    std::lock_guard<std::mutex> lock(data_mutex_);
+    data.swap(data_);
+  }
+  if (!enable_.load() || data.empty()) {
+    return;
+  }
+  if (file_size_ >=  max_file_size_) {
+    LOG_WARN("{} file size over 4 GB", file_name_);
+    enable_.store(false);
+    return;
+  }
+  if (!file_handle_) {
+    file_handle_ = std::make_shared<std::ofstream>();
+    file_name_ = fmt::format("lidar_{}_{}.LivoxDebugPointCloudData", handle_, GetCurrentSystemTime());
+    file_handle_->open(fmt::format("{}/{}",file_path_, file_name_), std::ios::binary);
+    if (!file_handle_->is_open()) {
+      LOG_ERROR("filed to open {} path", file_path_);
+      enable_.store(false);
       return;
     }
-    if (!file_handle_) {
-      file_handle_ = std::make_shared<std::ofstream>();
-      file_name_ = fmt::format("lidar_{}_{}.LivoxDebugPointCloudData", handle_, GetCurrentSystemTime());
-      file_handle_->open(fmt::format("{}/{}",file_path_, file_name_), std::ios::binary);
-      if (!file_handle_->is_open()) {
-        LOG_ERROR("filed to open {} path", file_path_);
-        return;
-      }
-      // write file header
-      FastCRC16 crc_16;
-      LivoxLidarDebugPointCloudFileHeader file_header;
-      file_header.file_ver  = {0x01};
-      file_header.dev_type  = {dev_type_};
-      file_header.data_type = {0x01};
-      memcpy(file_header.sn, sn_.c_str(), sizeof(file_header.sn));
-      memset(file_header.rsvd, 0, sizeof(file_header.rsvd));
-      file_header.crc16 = crc_16.ccitt(reinterpret_cast<const uint8_t*>(&file_header),
-                                      offsetof(LivoxLidarDebugPointCloudFileHeader, crc16));
+    // write file header
+    FastCRC16 crc_16;
+    LivoxLidarDebugPointCloudFileHeader file_header;
+    file_header.file_ver  = {0x01};
+    file_header.dev_type  = {dev_type_};
+    file_header.data_type = {0x01};
+    memcpy(file_header.sn, sn_.c_str(), sizeof(file_header.sn));
+    memset(file_header.rsvd, 0, sizeof(file_header.rsvd));
+    file_header.crc16 = crc_16.ccitt(reinterpret_cast<const uint8_t*>(&file_header),
+                                    offsetof(LivoxLidarDebugPointCloudFileHeader, crc16));
 
-      file_handle_->write(reinterpret_cast<char*>(&file_header), sizeof(file_header));
-      file_size_ += sizeof(file_header);
-    }
-    file_handle_->write(reinterpret_cast<char*>(data_.data()), data_.size());
-    file_size_ += data_.size();
-    data_.resize(0);
+    file_handle_->write(reinterpret_cast<char*>(&file_header), sizeof(file_header));
+    file_size_ += sizeof(file_header);
   }
+  file_handle_->write(reinterpret_cast<char*>(data.data()), data.size());
+  file_size_ += data.size();
 }
 
 bool DebugPointCloudHandler::Enable(bool enable) {
   enable_.store(enable);
-  if (enable) {
-    thread_ptr_ = std::make_shared<std::thread>(&DebugPointCloudHandler::WriteData, this);
-  }
   return true;
 }
 
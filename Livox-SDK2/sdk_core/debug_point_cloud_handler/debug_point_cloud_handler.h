@@ -34,18 +34,18 @@
 
 #include <string>
 #include <fstream>
-#include <thread>
+#include <memory>
 #include <mutex>
-#include <condition_variable>
 #include <vector>
 
 namespace livox {
 namespace lidar {
 
-class DebugPointCloudHandler {
+class DebugPointCloudHandler : public std::enable_shared_from_this<DebugPointCloudHandler> {
  public:
   DebugPointCloudHandler(std::uint32_t handle, std::string sn, std::uint8_t dev_type, std::string path);
   ~DebugPointCloudHandler();
+  /** Buffer the data, it is written to the file by a task posted to the control loop. */
   bool StoreData(uint8_t* buf, uint32_t buf_size);
   void WriteData();
   bool Enable(bool enable);
@@ -61,9 +61,7 @@ class DebugPointCloudHandler {
 
   std::vector<uint8_t>  data_;
   std::mutex            data_mutex_;
-  std::condition_variable cv_;
 
-  std::shared_ptr<std::thread>    thread_ptr_{nullptr};
   std::shared_ptr<std::ofstream>  file_handle_{nullptr};
 
   static constexpr uint64_t max_file_size_ = {4ULL * 1024 * 1024 * 1024};
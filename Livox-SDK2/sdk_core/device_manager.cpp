@@ -30,6 +30,7 @@
 #include "device_manager.h"
 
 #include <iostream>
+#include <algorithm>
 
 #include "comm/define.h"
 #include "comm/generate_seq.h"
@@ -50,15 +51,20 @@ DeviceManager::DeviceManager()
       lidar_logger_cfg_ptr_(nullptr),
       detection_socket_(0),
       detection_broadcast_socket_(0),
-      cmd_io_thread_(nullptr),
-      data_io_thread_(nullptr),
-      detection_io_thread_(nullptr),
+      control_io_thread_(nullptr),
+      next_data_io_thread_(0),
+      imu_io_thread_(nullptr),
       comm_port_(nullptr),
-      is_stop_detection_(false),
-      detection_thread_(nullptr),
+      detection_timer_id_(0),
       is_view_(false),
       detection_host_ip_(""),
-      enable_save_log_(false) {
+      detection_host_addr_(0),
+      route_table_(nullptr),
+      route_table_owner_(nullptr),
+      enable_save_log_(false),
+      recv_batch_size_(1),
+      socket_buffer_info_(),
+      next_poll_socket_(0) {
 }
 
 DeviceManager& DeviceManager::GetInstance() {
@@ -69,8 +75,40 @@ DeviceManager& DeviceManager::GetInstance() {
 bool DeviceManager::Init(const std::string& host_ip, const LivoxLidarLoggerCfgInfo* log_cfg_info) {
   is_view_ = true;
   detection_host_ip_ = host_ip;
+  detection_host_addr_ = inet_addr(host_ip.c_str());
   comm_port_.reset(new CommPort());
 
+  sdk_framework_cfg_ptr_.reset(new LivoxLidarSdkFrameworkCfg());
+  sdk_framework_cfg_ptr_->master_sdk = true;
+  sdk_framework_cfg_ptr_->recv_batch_size = 1;
+  sdk_framework_cfg_ptr_->data_io_thread_num = 1;
+  sdk_framework_cfg_ptr_->data_reuseport_enable = false;
+  sdk_framework_cfg_ptr_->packet_ring_enable = false;
+  sdk_framework_cfg_ptr_->xdp_enable = false;
+  sdk_framework_cfg_ptr_->io_uring_enable = false;
+  sdk_framework_cfg_ptr_->data_edge_triggered_enable = false;
+  sdk_framework_cfg_ptr_->data_drain_budget = 0;
+  sdk_framework_cfg_ptr_->udp_gro_enable = false;
+  sdk_framework_cfg_ptr_->rx_timestamp_enable = false;
+  sdk_framework_cfg_ptr_->busy_poll_enable = false;
+  sdk_framework_cfg_ptr_->busy_poll_idle_us = 0;
+  sdk_framework_cfg_ptr_->socket_busy_poll_us = 0;
+  sdk_framework_cfg_ptr_->imu_io_thread_enable = false;
+  sdk_framework_cfg_ptr_->imu_io_thread_cpu = -1;
+  sdk_framework_cfg_ptr_->imu_io_thread_priority = 0;
+  sdk_framework_cfg_ptr_->embedded_profile = false;
+  sdk_framework_cfg_ptr_->packet_handle_num = kDefaultPacketHandleNum;
+  sdk_framework_cfg_ptr_->data_poll_enable = false;
+  for (int i = 0; i < kLivoxLidarSocketRoleNum; ++i) {
+    sdk_framework_cfg_ptr_->socket_rcvbuf[i] = kDefaultSocketRecvBufferSize[i];
+  }
+  recv_batch_size_ = sdk_framework_cfg_ptr_->recv_batch_size;
+
+  if (!CreateIOThread()) {
+    LOG_ERROR("Create IO thread failed.");
+    return false;
+  }
+
   std::shared_ptr<LivoxLidarLoggerCfg> lidar_logger_cfg_ptr(new LivoxLidarLoggerCfg());
   if (log_cfg_info != nullptr) {
     lidar_logger_cfg_ptr->lidar_log_enable = log_cfg_info->lidar_log_enable;
@@ -98,18 +136,12 @@ bool DeviceManager::Init(const std::string& host_ip, const LivoxLidarLoggerCfgIn
     return false;
   }
 
-  if (!CreateIOThread()) {
-    LOG_ERROR("Create IO thread failed.");
-    return false;
-  }
-
   if (!CreateDetectionChannel()) {
     LOG_ERROR("Create detection channel failed.");
     return false;
   }
 
-  detection_thread_ = std::make_shared<std::thread>(&DeviceManager::DetectionLidars, this);
-  is_stop_detection_.store(false);
+  StartDetection();
   return true;
 }
 
@@ -122,6 +154,14 @@ bool DeviceManager::Init(std::shared_ptr<std::vector<LivoxLidarCfg>>& lidars_cfg
   custom_lidars_cfg_ptr_ = custom_lidars_cfg_ptr;
   lidar_logger_cfg_ptr_ = lidar_logger_cfg_ptr;
   sdk_framework_cfg_ptr_ = sdk_framework_cfg_ptr;
+  if (!sdk_framework_cfg_ptr_) {
+    LOG_ERROR("sdk_framework_cfg_ptr is nullptr.");
+    return false;
+  }
+  recv_batch_size_ = sdk_framework_cfg_ptr_->recv_batch_size;
+  if (recv_batch_size_ == 0 || recv_batch_size_ > static_cast<uint32_t>(util::kMaxRecvMsgNum)) {
+    recv_batch_size_ = 1;
+  }
 
   if (lidars_cfg_ptr_ && !(lidars_cfg_ptr_->empty())) {
     detection_host_ip_ = lidars_cfg_ptr_->at(0).host_net_info.host_ip;
@@ -131,6 +171,7 @@ bool DeviceManager::Init(std::shared_ptr<std::vector<LivoxLidarCfg>>& lidars_cfg
     LOG_ERROR("Device manager init failed, can not find cmd host ip.");
     return false;
   }
+  detection_host_addr_ = inet_addr(detection_host_ip_.c_str());
   comm_port_.reset(new CommPort());
   
   if (!lidar_logger_cfg_ptr) {
@@ -143,6 +184,11 @@ bool DeviceManager::Init(std::shared_ptr<std::vector<LivoxLidarCfg>>& lidars_cfg
     return false;
   }
 
+  if (!CreateIOThread()) {
+    LOG_ERROR("Create IO thread failed.");
+    return false;
+  }
+
   if (!LoggerManager::GetInstance().Init(lidar_logger_cfg_ptr)) {
     LOG_ERROR("Logger manager init failed.");
     return false;
@@ -160,8 +206,13 @@ bool DeviceManager::Init(std::shared_ptr<std::vector<LivoxLidarCfg>>& lidars_cfg
 
   GetLidarConfigMap();
 
-  if (!CreateIOThread()) {
-    LOG_ERROR("Create IO thread failed.");
+  if (!CreatePacketRing()) {
+    LOG_ERROR("Create packet ring failed.");
+    return false;
+  }
+
+  if (!CreateXdpSockets()) {
+    LOG_ERROR("Create xdp sockets failed.");
     return false;
   }
 
@@ -171,8 +222,7 @@ bool DeviceManager::Init(std::shared_ptr<std::vector<LivoxLidarCfg>>& lidars_cfg
   }
 
   if (!(lidars_cfg_ptr_->empty()) || !(custom_lidars_cfg_ptr->empty())) {
-    detection_thread_ = std::make_shared<std::thread>(&DeviceManager::DetectionLidars, this);
-    is_stop_detection_.store(false);
+    StartDetection();
   }
 
   LOG_INFO("Init livox lidars succ.");
@@ -190,16 +240,45 @@ void DeviceManager::GetLidarConfigMap() {
     uint32_t lidar_ip = inet_addr(lidar_cfg.lidar_net_info.lidar_ipaddr.c_str());
     custom_lidars_cfg_map_[lidar_ip] = lidar_cfg;
   }
+  UpdateRouteTable();
 }
 
-bool DeviceManager::CreateIOThread() {
-  if (!CreateDetectionIOThread()) {
-    LOG_ERROR("Device manager init failed, create detection io thread failed.");
-    return false;
+void DeviceManager::UpdateRouteTable() {
+  std::unique_ptr<RouteTable> route_table(new RouteTable(custom_lidars_cfg_map_.size() * 7));
+  for (auto it = custom_lidars_cfg_map_.begin(); it != custom_lidars_cfg_map_.end(); ++it) {
+    const uint32_t handle = it->first;
+    const LivoxLidarCfg& lidar_cfg = it->second;
+    const LivoxLidarNetInfo& lidar_net_info = lidar_cfg.lidar_net_info;
+
+    route_table->Insert(handle, lidar_net_info.imu_data_port, kRouteData, lidar_cfg.device_type);
+    route_table->Insert(handle, lidar_net_info.point_data_port, kRouteData, lidar_cfg.device_type);
+    route_table->Insert(handle, kDetectionPort, kRouteCommand, lidar_cfg.device_type);
+    route_table->Insert(handle, lidar_net_info.cmd_data_port, kRouteCommand, lidar_cfg.device_type);
+    route_table->Insert(handle, lidar_net_info.push_msg_port, kRouteCommand, lidar_cfg.device_type);
+    route_table->Insert(handle, lidar_net_info.log_data_port, kRouteCommand, lidar_cfg.device_type);
+    route_table->Insert(handle, kPaLidarFaultPort, kRouteCommand, lidar_cfg.device_type);
+  }
+
+  route_table_.store(route_table.get(), std::memory_order_release);
+  // Called outside any lookup, the io threads may still be reading the previous table.
+  route_epoch_.Synchronize();
+  route_table_owner_ = std::move(route_table);
+}
+
+bool DeviceManager::FindRoute(uint32_t handle, uint16_t port, RouteEntry* route) {
+  uint32_t slot = route_epoch_.ReadLock();
+  const RouteTable* route_table = route_table_.load(std::memory_order_acquire);
+  const RouteEntry* entry = (route_table != nullptr) ? route_table->Find(handle, port) : nullptr;
+  if (entry != nullptr) {
+    *route = *entry;
   }
+  route_epoch_.ReadUnlock(slot);
+  return entry != nullptr;
+}
 
-  if (!CreateCommandIOThread()) {
-    LOG_ERROR("Device manager init failed, create comman io thread failed.");
+bool DeviceManager::CreateIOThread() {
+  if (!CreateControlIOThread()) {
+    LOG_ERROR("Device manager init failed, create control io thread failed.");
     return false;
   }
   
@@ -207,34 +286,192 @@ bool DeviceManager::CreateIOThread() {
     LOG_ERROR("Device manager init failed, create data io thread failed.");
     return false;
   }
+
+  if (!CreateImuIOThread()) {
+    LOG_ERROR("Device manager init failed, create imu io thread failed.");
+    return false;
+  }
   return true;
 }
 
-bool DeviceManager::CreateDetectionIOThread() {
-  detection_io_thread_ = std::make_shared<IOThread>();
-  if (detection_io_thread_ == nullptr || !(detection_io_thread_->Init(true, false))) {
-    LOG_ERROR("Create command io thread failed, thread_ptr is nullptr or thread init failed");
+bool DeviceManager::CreateControlIOThread() {
+  // One reactor for everything but the data: the detection and command sockets, the detection
+  // broadcast, the command timeouts, the lidar log files and the firmware upgrade.
+  control_io_thread_ = std::make_shared<IOThread>();
+  if (control_io_thread_ == nullptr || !(control_io_thread_->Init(false))) {
+    LOG_ERROR("Create control io thread failed, thread_ptr is nullptr or thread init failed");
     return false;
   }
-  return detection_io_thread_->Start();
+  if (!control_io_thread_->InitRecvBufferPool(kMaxBufferSize, recv_batch_size_)) {
+    LOG_ERROR("Init recv buffer pool failed.");
+    return false;
+  }
+  control_io_thread_->SetName("livox_control");
+  control_io_thread_->GetLoop().lock()->AddTimer(kCommandTimeoutCheckInterval, kCommandTimeoutCheckInterval, [](TimePoint now) {
+    GeneralCommandHandler::GetInstance().CommandsHandle(now);
+  });
+  return control_io_thread_->Start();
+}
+
+bool DeviceManager::CreateDataIOThread() {
+  uint32_t data_io_thread_num = sdk_framework_cfg_ptr_->data_io_thread_num;
+  if (data_io_thread_num == 0 || data_io_thread_num > kMaxDataIOThreadNum) {
+    data_io_thread_num = 1;
+  }
+  const std::vector<int32_t>& cpus = sdk_framework_cfg_ptr_->data_io_thread_cpus;
+
+  data_io_threads_.clear();
+  packet_rings_.clear();
+  packet_ring_ports_.clear();
+  xdp_sockets_.clear();
+  xdp_socket_threads_.clear();
+  xdp_program_.reset();
+  next_data_io_thread_ = 0;
+  for (uint32_t i = 0; i < data_io_thread_num; ++i) {
+    std::shared_ptr<IOThread> data_io_thread = std::make_shared<IOThread>();
+    IOLoopCfg loop_cfg;
+    loop_cfg.io_uring_enable = sdk_framework_cfg_ptr_->io_uring_enable;
+    loop_cfg.drain_budget = sdk_framework_cfg_ptr_->data_edge_triggered_enable ?
+        static_cast<int>(sdk_framework_cfg_ptr_->data_drain_budget) : 0;
+    loop_cfg.busy_poll_enable = sdk_framework_cfg_ptr_->busy_poll_enable;
+    loop_cfg.busy_poll_idle_us = sdk_framework_cfg_ptr_->busy_poll_idle_us;
+    if (data_io_thread == nullptr || !(data_io_thread->Init(false, loop_cfg))) {
+      LOG_ERROR("Create data io thread failed, thread_ptr is nullptr or thread init failed");
+      return false;
+    }
+    // A coalesced datagram carries up to 64 KB of point data.
+    if (!data_io_thread->InitRecvBufferPool(IsDataGroEnabled() ? kMaxGroBufferSize : kMaxBufferSize, recv_batch_size_,
+                                            sdk_framework_cfg_ptr_->packet_handle_num)) {
+      LOG_ERROR("Init recv buffer pool failed.");
+      return false;
+    }
+    data_io_thread->SetName("livox_data_" + std::to_string(i));
+    if (i < cpus.size()) {
+      data_io_thread->SetCpuAffinity(cpus[i]);
+    }
+    if (!data_io_thread->Start()) {
+      return false;
+    }
+    data_io_threads_.push_back(data_io_thread);
+  }
+  LOG_INFO("Create {} data io threads.", data_io_threads_.size());
+  if (sdk_framework_cfg_ptr_->data_poll_enable) {
+    LOG_INFO("The point cloud and imu data are received with LivoxLidarPollData.");
+  }
+  if (sdk_framework_cfg_ptr_->udp_gro_enable && !IsDataGroEnabled()) {
+    LOG_WARN("udp gro is not used with the io_uring backend or LivoxLidarPollData.");
+  }
+  return true;
 }
 
-bool DeviceManager::CreateCommandIOThread() {
-  cmd_io_thread_ = std::make_shared<IOThread>();
-  if (cmd_io_thread_ == nullptr || !(cmd_io_thread_->Init(true, false))) {
-    LOG_ERROR("Create command io thread failed, thread_ptr is nullptr or thread init failed");
+bool DeviceManager::CreateImuIOThread() {
+  imu_io_thread_.reset();
+  if (!sdk_framework_cfg_ptr_->imu_io_thread_enable) {
+    return true;
+  }
+  // The imu data is tiny and sparse, a plain blocking poll picks every packet up at once, so a
+  // point cloud burst or a slow point callback can not delay it.
+  std::shared_ptr<IOThread> imu_io_thread = std::make_shared<IOThread>();
+  if (imu_io_thread == nullptr || !(imu_io_thread->Init(false))) {
+    LOG_ERROR("Create imu io thread failed, thread_ptr is nullptr or thread init failed");
+    return false;
+  }
+  if (!imu_io_thread->InitRecvBufferPool(kMaxBufferSize, recv_batch_size_, sdk_framework_cfg_ptr_->packet_handle_num)) {
+    LOG_ERROR("Init recv buffer pool failed.");
     return false;
   }
-  return cmd_io_thread_->Start();
+  imu_io_thread->SetName("livox_imu");
+  imu_io_thread->SetCpuAffinity(sdk_framework_cfg_ptr_->imu_io_thread_cpu);
+  imu_io_thread->SetRealtimePriority(static_cast<int>(sdk_framework_cfg_ptr_->imu_io_thread_priority));
+  if (!imu_io_thread->Start()) {
+    return false;
+  }
+  imu_io_thread_ = imu_io_thread;
+  LOG_INFO("Create the imu io thread.");
+  return true;
 }
 
-bool DeviceManager::CreateDataIOThread() {
-  data_io_thread_ = std::make_shared<IOThread>();
-  if (data_io_thread_ == nullptr || !(data_io_thread_->Init(true, false))) {
-    LOG_ERROR("Create command io thread failed, thread_ptr is nullptr or thread init failed");
+void DeviceManager::SetDataSocketOptions(socket_t sock, const std::string& key) {
+  if (sdk_framework_cfg_ptr_->rx_timestamp_enable && !util::EnableRxTimestamp(sock)) {
+    LOG_WARN("Enable the receive timestamp on {} failed.", key);
+  }
+  uint32_t busy_poll_us = sdk_framework_cfg_ptr_->socket_busy_poll_us;
+  if (busy_poll_us > 0 && !util::SetBusyPoll(sock, busy_poll_us)) {
+    LOG_WARN("Set SO_BUSY_POLL on {} failed, it needs CAP_NET_ADMIN above net.core.busy_read.", key);
+  }
+}
+
+socket_t DeviceManager::CreateRoleSocket(LivoxLidarSocketRole role, uint16_t port, bool is_broadcast,
+                                         const std::string& netif, const std::string& multicast_ip) {
+  bool gro = role == kLivoxLidarSocketPoint && IsDataGroEnabled();
+  socket_t sock = util::CreateSocket(port, true, true, is_broadcast, netif, multicast_ip, gro,
+                                     static_cast<int>(sdk_framework_cfg_ptr_->socket_rcvbuf[role]));
+  if (sock >= 0) {
+    RecordSocketBuffer(sock, role);
+  }
+  return sock;
+}
+
+void DeviceManager::RecordSocketBuffer(socket_t sock, LivoxLidarSocketRole role) {
+  uint32_t requested_size = sdk_framework_cfg_ptr_->socket_rcvbuf[role];
+  uint32_t effective_size = static_cast<uint32_t>(util::GetRecvBufferSize(sock));
+#ifdef __linux__
+  // Linux reports twice the granted size, the half is in the unit of the request.
+  effective_size /= 2;
+#endif
+  if (requested_size > 0 && effective_size < requested_size) {
+    LOG_WARN("SO_RCVBUF of {} bytes is clamped to {}, raise net.core.rmem_max.", requested_size, effective_size);
+  }
+  std::lock_guard<std::mutex> lock(socket_buffer_info_mutex_);
+  LivoxLidarSocketBufferInfo& info = socket_buffer_info_[role];
+  ++info.socket_num;
+  info.requested_size = requested_size;
+  info.effective_size = effective_size;
+}
+
+bool DeviceManager::GetSocketBufferInfo(LivoxLidarSocketRole role, LivoxLidarSocketBufferInfo* info) {
+  if (role < 0 || role >= kLivoxLidarSocketRoleNum || info == nullptr) {
     return false;
   }
-  return data_io_thread_->Start();
+  std::lock_guard<std::mutex> lock(socket_buffer_info_mutex_);
+  *info = socket_buffer_info_[role];
+  info->requested_size = sdk_framework_cfg_ptr_ ? sdk_framework_cfg_ptr_->socket_rcvbuf[role] : 0;
+  return true;
+}
+
+bool DeviceManager::IsDataGroEnabled() const {
+  // The io_uring provided buffers and the poll buffers are too small for a coalesced datagram.
+  return sdk_framework_cfg_ptr_->udp_gro_enable && !sdk_framework_cfg_ptr_->io_uring_enable &&
+      !sdk_framework_cfg_ptr_->data_poll_enable;
+}
+
+std::shared_ptr<IOThread> DeviceManager::SelectDataIOThread(const std::string& lidar_ip, bool imu) {
+  if (imu && imu_io_thread_) {
+    return imu_io_thread_;
+  }
+  const std::map<std::string, uint32_t>& lidar_data_io_thread = sdk_framework_cfg_ptr_->lidar_data_io_thread;
+  auto it = lidar_data_io_thread.find(lidar_ip);
+  if (it != lidar_data_io_thread.end() && it->second < data_io_threads_.size()) {
+    return data_io_threads_[it->second];
+  }
+  return data_io_threads_[next_data_io_thread_++ % data_io_threads_.size()];
+}
+
+livox_status DeviceManager::PostDataTask(uint32_t data_io_thread_index, const IOLoop::IOLoopTask& task) {
+  if (data_io_thread_index >= data_io_threads_.size()) {
+    LOG_ERROR("Post data task failed, the data io thread index {} is out of range.", data_io_thread_index);
+    return kLivoxLidarStatusFailure;
+  }
+  std::shared_ptr<IOLoop> loop = data_io_threads_[data_io_thread_index]->GetLoop().lock();
+  if (!loop) {
+    return kLivoxLidarStatusFailure;
+  }
+  loop->PostTask(task);
+  return kLivoxLidarStatusSuccess;
+}
+
+std::shared_ptr<IOLoop> DeviceManager::GetControlLoop() {
+  return control_io_thread_ ? control_io_thread_->GetLoop().lock() : nullptr;
 }
 
 bool DeviceManager::CreateChannel() {
@@ -245,7 +482,7 @@ bool DeviceManager::CreateChannel() {
 
   for (auto it = custom_lidars_cfg_ptr_->begin(); it != custom_lidars_cfg_ptr_->end(); ++it) {
     const HostNetInfo& host_net_info = it->host_net_info;
-    if (!CreateDataChannel(host_net_info)) {
+    if (!CreateDataChannel(host_net_info, it->lidar_net_info.lidar_ipaddr)) {
       LOG_ERROR("Create data channel failed.");
       return false;
     }
@@ -261,21 +498,21 @@ bool DeviceManager::CreateChannel() {
 bool DeviceManager::CreateDetectionChannel() {
 #ifdef WIN32
 #else
-  detection_broadcast_socket_ = util::CreateSocket(kDetectionPort, true, true, true, "255.255.255.255", "");
+  detection_broadcast_socket_ = CreateRoleSocket(kLivoxLidarSocketCmd, kDetectionPort, true, "255.255.255.255");
   if (detection_broadcast_socket_ < 0) {
     LOG_ERROR("Create detection broadcast socket failed.");
     return false;
   }
-  detection_io_thread_->GetLoop().lock()->AddDelegate(detection_broadcast_socket_, this, nullptr);
+  control_io_thread_->GetLoop().lock()->AddDelegate(detection_broadcast_socket_, this, control_io_thread_->GetRecvBufferPool());
 #endif
 
   std::string key = detection_host_ip_ + ":" + std::to_string(kDetectionPort);
-  detection_socket_ = util::CreateSocket(kDetectionPort, true, true, true, detection_host_ip_, "");
+  detection_socket_ = CreateRoleSocket(kLivoxLidarSocketCmd, kDetectionPort, true, detection_host_ip_);
   if (detection_socket_ < 0) {
     LOG_ERROR("Create detection socket failed.");
     return false;
   }
-  detection_io_thread_->GetLoop().lock()->AddDelegate(detection_socket_, this, nullptr);
+  control_io_thread_->GetLoop().lock()->AddDelegate(detection_socket_, this, control_io_thread_->GetRecvBufferPool());
 
   channel_info_[key] = detection_socket_;
   if (custom_command_channel_.find(key) == custom_command_channel_.end()) {
@@ -285,18 +522,21 @@ bool DeviceManager::CreateDetectionChannel() {
   return true;
 }
 
-bool DeviceManager::CreateDataChannel(const HostNetInfo& host_net_info) {
-  if (!CreateDataSocketAndAddDelegate(host_net_info.host_ip, host_net_info.point_data_port, host_net_info.multicast_ip)) {
+bool DeviceManager::CreateDataChannel(const HostNetInfo& host_net_info, const std::string& lidar_ip) {
+  if (!CreateDataSocketAndAddDelegate(host_net_info.host_ip, host_net_info.point_data_port, host_net_info.multicast_ip, lidar_ip,
+                                      kLivoxLidarSocketPoint)) {
     LOG_ERROR("Create socket and add delegate failed.");
     return false;
   }
 
-  if (!CreateDataSocketAndAddDelegate(host_net_info.host_ip, host_net_info.imu_data_port, host_net_info.multicast_ip)) {
+  if (!CreateDataSocketAndAddDelegate(host_net_info.host_ip, host_net_info.imu_data_port, host_net_info.multicast_ip, lidar_ip,
+                                      kLivoxLidarSocketImu)) {
     LOG_ERROR("Create socket and add delegate failed.");
     return false;
   }
 
-  if (!CreateDataSocketAndAddDelegate(host_net_info.host_ip, kHostDebugPointCloudPort, host_net_info.multicast_ip)) {
+  if (!CreateDataSocketAndAddDelegate(host_net_info.host_ip, kHostDebugPointCloudPort, host_net_info.multicast_ip, lidar_ip,
+                                      kLivoxLidarSocketDebug)) {
     LOG_ERROR("Create debug point cloud socket and add delegate failed.");
     return false;
   }
@@ -327,13 +567,13 @@ bool DeviceManager::CreateCommandChannel(const uint8_t dev_type, const HostNetIn
 #ifdef WIN32
 #else
   if (dev_type == kLivoxLidarTypeMid360) {
-    socket_t broadcast_socket = util::CreateSocket(host_net_info.push_msg_port, true, true, true, "255.255.255.255", "");
+    socket_t broadcast_socket = CreateRoleSocket(kLivoxLidarSocketPush, host_net_info.push_msg_port, true, "255.255.255.255");
     if (broadcast_socket < 0) {
       LOG_ERROR("Create broadcast socket failed.");
       return false;
     }
     vec_broadcast_socket_.push_back(broadcast_socket);
-    cmd_io_thread_->GetLoop().lock()->AddDelegate(broadcast_socket, this, nullptr);
+    control_io_thread_->GetLoop().lock()->AddDelegate(broadcast_socket, this, control_io_thread_->GetRecvBufferPool());
   }
 #endif
 
@@ -362,11 +602,18 @@ bool DeviceManager::CreateCmdSocketAndAddDelegate(const uint8_t dev_type, const
     return true;
   }
 
+  LivoxLidarSocketRole role = kLivoxLidarSocketCmd;
+  if (type == kPush || type == kFault) {
+    role = kLivoxLidarSocketPush;
+  } else if (type == kLog) {
+    role = kLivoxLidarSocketLog;
+  }
+
   socket_t sock = -1;
   if (host_ip == "local") {
-    sock = util::CreateSocket(port, true, true, true, "", "");
+    sock = CreateRoleSocket(role, port, true, "");
   } else {
-    sock = util::CreateSocket(port, true, true, true, host_ip, "");
+    sock = CreateRoleSocket(role, port, true, host_ip);
   }
 
   if (sock < 0) {
@@ -380,25 +627,53 @@ bool DeviceManager::CreateCmdSocketAndAddDelegate(const uint8_t dev_type, const
   command_channel_.insert(sock); 
   custom_command_channel_[key] = sock;
 
-  cmd_io_thread_->GetLoop().lock()->AddDelegate(sock, this, nullptr);
+  control_io_thread_->GetLoop().lock()->AddDelegate(sock, this, control_io_thread_->GetRecvBufferPool());
   return true;
 }
 
-bool DeviceManager::CreateDataSocketAndAddDelegate(const std::string& host_ip, const uint16_t port, const std::string& multicast_ip) {
+bool DeviceManager::CreateDataSocketAndAddDelegate(const std::string& host_ip, const uint16_t port,
+                                                   const std::string& multicast_ip, const std::string& lidar_ip,
+                                                   LivoxLidarSocketRole role) {
   if (host_ip.empty() || port == 0 || port == kLogPort || port == kDetectionPort) {
     return true;
   }
 
+  bool imu = role == kLivoxLidarSocketImu;
+  bool imu_thread = imu && imu_io_thread_;
   std::string key = host_ip + ":" + std::to_string(port);
-  if (channel_info_.find(key) != channel_info_.end()) {
+  auto channel_it = channel_info_.find(key);
+  if (channel_it != channel_info_.end()) {
+    if (reuseport_groups_.find(key) != reuseport_groups_.end()) {
+      AttachReusePortFilter(key, host_ip, port);
+      return true;
+    }
+    // Without reuseport the lidars sharing a host port share its socket, which stays on the
+    // thread picked for the first of them.
+    const std::map<std::string, uint32_t>& lidar_data_io_thread = sdk_framework_cfg_ptr_->lidar_data_io_thread;
+    auto it = lidar_data_io_thread.find(lidar_ip);
+    auto channel = data_channel_.find(channel_it->second);
+    if (!imu_thread && it != lidar_data_io_thread.end() && it->second < data_io_threads_.size() &&
+        channel != data_channel_.end() && channel->second != data_io_threads_[it->second] &&
+        shared_data_sockets_.insert(lidar_ip + " " + key).second) {
+      LOG_WARN("The lidar {} shares the socket of {} with another lidar, its data io thread {} does not apply, "
+          "give it its own host port or enable data_reuseport_enable.", lidar_ip, key, it->second);
+    }
     return true;
   }
 
+  if (sdk_framework_cfg_ptr_->data_reuseport_enable && data_io_threads_.size() > 1 && packet_rings_.empty() && !imu_thread &&
+      !sdk_framework_cfg_ptr_->data_poll_enable) {
+    if (multicast_ip.empty()) {
+      return CreateReusePortDataSockets(key, host_ip, port, role);
+    }
+    LOG_WARN("Data reuseport is not supported by multicast, use one socket for {}", key);
+  }
+
   socket_t sock = -1;
   if (host_ip == "local") {
-    sock = util::CreateSocket(port, true, true, false, "", multicast_ip);
+    sock = CreateRoleSocket(role, port, false, "", multicast_ip);
   } else {
-    sock = util::CreateSocket(port, true, true, false, host_ip, multicast_ip);
+    sock = CreateRoleSocket(role, port, false, host_ip, multicast_ip);
   }
   if (sock < 0) {
     LOG_ERROR("Add command channel faileld, can not create socket, the ip {} port {} ", host_ip.c_str(), port);
@@ -406,17 +681,223 @@ bool DeviceManager::CreateDataSocketAndAddDelegate(const std::string& host_ip, c
   }
   socket_vec_.push_back(sock);
   channel_info_[key] = sock;  
+  SetDataSocketOptions(sock, key);
+  // The imu latency statistics are taken from the receive timestamps.
+  if (imu_thread && !sdk_framework_cfg_ptr_->rx_timestamp_enable && !util::EnableRxTimestamp(sock)) {
+    LOG_WARN("Enable the receive timestamp on {} failed.", key);
+  }
+
+  // The datagrams of this port are read from the packet rings, the socket only keeps the port
+  // bound and the multicast group joined.
+  if (packet_ring_ports_.find(port) != packet_ring_ports_.end()) {
+    if (!util::AttachDropFilter(sock)) {
+      LOG_WARN("Attach drop filter on {} failed.", key);
+    }
+    return true;
+  }
+
+  // The application receives from this socket with LivoxLidarPollData.
+  if (sdk_framework_cfg_ptr_->data_poll_enable && !imu_thread) {
+    std::lock_guard<std::mutex> lock(poll_mutex_);
+    poll_sockets_.push_back(sock);
+    return true;
+  }
 
-  data_channel_.insert(sock);
-  data_io_thread_->GetLoop().lock()->AddDelegate(sock, this, nullptr);
+  std::shared_ptr<IOThread> data_io_thread = SelectDataIOThread(lidar_ip, imu);
+  data_channel_[sock] = data_io_thread;
+  data_io_thread->GetLoop().lock()->AddRecvDelegate(sock, this, data_io_thread->GetRecvBufferPool());
   return true;
 }
 
-void DeviceManager::DetectionLidars() {
-  while (!is_stop_detection_) {
-    Detection();
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+bool DeviceManager::CreateReusePortDataSockets(const std::string& key, const std::string& host_ip, const uint16_t port,
+                                               LivoxLidarSocketRole role) {
+  bool gro = role == kLivoxLidarSocketPoint && IsDataGroEnabled();
+  // The n-th socket of the group is bound n-th and served by the n-th data io thread, so the
+  // index returned by the reuseport filter is the data io thread index.
+  std::vector<socket_t> socks;
+  for (size_t i = 0; i < data_io_threads_.size(); ++i) {
+    socket_t sock = util::CreateReusePortSocket(port, host_ip == "local" ? "" : host_ip, gro,
+                                                static_cast<int>(sdk_framework_cfg_ptr_->socket_rcvbuf[role]));
+    if (sock < 0) {
+      LOG_ERROR("Create reuseport data socket failed, the ip {} port {} ", host_ip.c_str(), port);
+      for (socket_t& created_sock : socks) {
+        util::CloseSock(created_sock);
+      }
+      return false;
+    }
+    SetDataSocketOptions(sock, key);
+    RecordSocketBuffer(sock, role);
+    socks.push_back(sock);
   }
+
+  reuseport_groups_[key] = socks;
+  channel_info_[key] = socks.front();
+  AttachReusePortFilter(key, host_ip, port);
+
+  for (size_t i = 0; i < socks.size(); ++i) {
+    socket_vec_.push_back(socks[i]);
+    data_channel_[socks[i]] = data_io_threads_[i];
+    data_io_threads_[i]->GetLoop().lock()->AddRecvDelegate(socks[i], this, data_io_threads_[i]->GetRecvBufferPool());
+  }
+  LOG_INFO("Create {} reuseport data sockets on {}", socks.size(), key);
+  return true;
+}
+
+void DeviceManager::AttachReusePortFilter(const std::string& key, const std::string& host_ip, const uint16_t port) {
+  const std::vector<socket_t>& socks = reuseport_groups_[key];
+  if (socks.empty() || !custom_lidars_cfg_ptr_) {
+    return;
+  }
+
+  const std::map<std::string, uint32_t>& lidar_data_io_thread = sdk_framework_cfg_ptr_->lidar_data_io_thread;
+  std::vector<std::pair<uint32_t, uint32_t>> ip_index;
+  uint32_t next_index = 0;
+  for (const LivoxLidarCfg& lidar_cfg : *custom_lidars_cfg_ptr_) {
+    const HostNetInfo& host_net_info = lidar_cfg.host_net_info;
+    if (host_net_info.host_ip != host_ip) {
+      continue;
+    }
+    if (port != host_net_info.point_data_port && port != host_net_info.imu_data_port && port != kHostDebugPointCloudPort) {
+      continue;
+    }
+
+    const std::string& lidar_ip = lidar_cfg.lidar_net_info.lidar_ipaddr;
+    auto it = lidar_data_io_thread.find(lidar_ip);
+    uint32_t index = (it != lidar_data_io_thread.end()) ? it->second : (next_index++ % socks.size());
+    ip_index.emplace_back(inet_addr(lidar_ip.c_str()), index);
+  }
+
+  if (!util::AttachReusePortFilter(socks.front(), ip_index, static_cast<uint32_t>(socks.size()))) {
+    LOG_WARN("Attach reuseport filter on {} failed, the kernel hashes the lidars over the sockets.", key);
+  }
+}
+
+bool DeviceManager::CreatePacketRing() {
+  if (!sdk_framework_cfg_ptr_->packet_ring_enable) {
+    return true;
+  }
+  if (sdk_framework_cfg_ptr_->data_poll_enable) {
+    LOG_WARN("The data is received with LivoxLidarPollData, ignore the packet ring config.");
+    return true;
+  }
+
+  for (const std::shared_ptr<std::vector<LivoxLidarCfg>>& cfg_ptr : {lidars_cfg_ptr_, custom_lidars_cfg_ptr_}) {
+    for (const LivoxLidarCfg& lidar_cfg : *cfg_ptr) {
+      if (lidar_cfg.host_net_info.point_data_port != 0) {
+        packet_ring_ports_.insert(lidar_cfg.host_net_info.point_data_port);
+      }
+      // The imu data stays on the sockets of the imu io thread.
+      if (lidar_cfg.host_net_info.imu_data_port != 0 && !imu_io_thread_) {
+        packet_ring_ports_.insert(lidar_cfg.host_net_info.imu_data_port);
+      }
+    }
+  }
+  std::vector<uint16_t> dst_ports(packet_ring_ports_.begin(), packet_ring_ports_.end());
+
+  PacketRingCfg cfg;
+  cfg.netif = sdk_framework_cfg_ptr_->packet_ring_netif;
+  cfg.block_size = sdk_framework_cfg_ptr_->packet_ring_block_size;
+  cfg.block_num = sdk_framework_cfg_ptr_->packet_ring_block_num;
+  cfg.block_timeout_ms = sdk_framework_cfg_ptr_->packet_ring_block_timeout_ms;
+
+  // One ring per data io thread, the rings form a fanout group when there are several threads.
+  for (size_t i = 0; i < data_io_threads_.size(); ++i) {
+    std::unique_ptr<PacketRing> packet_ring(new PacketRing());
+    if (!packet_ring->Init(cfg, dst_ports, data_io_threads_.size() > 1, [this](uint32_t handle, uint16_t port, uint8_t* buf, uint32_t size, uint64_t timestamp) {
+          OnPacket(handle, port, buf, size, timestamp);
+        })) {
+      packet_rings_.clear();
+      packet_ring_ports_.clear();
+      return false;
+    }
+    // The batches run on the loop, their packets keep its busy poll spinning.
+    std::shared_ptr<IOLoop> loop = data_io_threads_[i]->GetLoop().lock();
+    IOLoop* loop_ptr = loop.get();
+    packet_ring->SetBatchCallback([loop_ptr](uint32_t packets) {
+      DataHandler::GetInstance().FlushBatch();
+      loop_ptr->AddStats(packets);
+    });
+    loop->AddDelegate(packet_ring->GetFd(), packet_ring.get(), nullptr);
+    packet_rings_.push_back(std::move(packet_ring));
+  }
+  LOG_INFO("Create {} packet rings for {} data ports.", packet_rings_.size(), dst_ports.size());
+  return true;
+}
+
+bool DeviceManager::CreateXdpSockets() {
+  if (!sdk_framework_cfg_ptr_->xdp_enable) {
+    return true;
+  }
+  if (!packet_rings_.empty()) {
+    LOG_WARN("The packet ring is enabled, ignore the xdp config.");
+    return true;
+  }
+  if (sdk_framework_cfg_ptr_->data_poll_enable) {
+    LOG_WARN("The data is received with LivoxLidarPollData, ignore the xdp config.");
+    return true;
+  }
+
+  std::set<uint16_t> ports;
+  for (const std::shared_ptr<std::vector<LivoxLidarCfg>>& cfg_ptr : {lidars_cfg_ptr_, custom_lidars_cfg_ptr_}) {
+    for (const LivoxLidarCfg& lidar_cfg : *cfg_ptr) {
+      if (lidar_cfg.host_net_info.point_data_port != 0) {
+        ports.insert(lidar_cfg.host_net_info.point_data_port);
+      }
+      if (lidar_cfg.host_net_info.imu_data_port != 0 && !imu_io_thread_) {
+        ports.insert(lidar_cfg.host_net_info.imu_data_port);
+      }
+    }
+  }
+  std::vector<uint16_t> dst_ports(ports.begin(), ports.end());
+
+  const std::vector<uint32_t>& queues = sdk_framework_cfg_ptr_->xdp_queues;
+  uint32_t max_queue_id = 0;
+  for (uint32_t queue_id : queues) {
+    max_queue_id = std::max(max_queue_id, queue_id);
+  }
+
+  std::unique_ptr<XdpProgram> xdp_program(new XdpProgram());
+  if (!xdp_program->Init(sdk_framework_cfg_ptr_->xdp_netif, dst_ports, max_queue_id + 1)) {
+    return false;
+  }
+
+  // One socket per rx queue, the queues are spread over the data io threads. The data sockets
+  // stay registered, they receive whatever the xdp program passes to the network stack.
+  std::vector<std::unique_ptr<XdpSocket>> xdp_sockets;
+  for (uint32_t queue_id : queues) {
+    std::unique_ptr<XdpSocket> xdp_socket(new XdpSocket());
+    if (!xdp_socket->Init(xdp_program->GetIfindex(), queue_id, sdk_framework_cfg_ptr_->xdp_frame_num,
+                          [this](uint32_t handle, uint16_t port, uint8_t* buf, uint32_t size, uint64_t timestamp) {
+          OnPacket(handle, port, buf, size, timestamp);
+        }) || !xdp_program->AddSocket(queue_id, xdp_socket->GetFd())) {
+      return false;
+    }
+    xdp_sockets.push_back(std::move(xdp_socket));
+  }
+
+  xdp_program_ = std::move(xdp_program);
+  for (size_t i = 0; i < xdp_sockets.size(); ++i) {
+    std::shared_ptr<IOThread> data_io_thread = data_io_threads_[i % data_io_threads_.size()];
+    // The batches run on the loop, their packets keep its busy poll spinning.
+    std::shared_ptr<IOLoop> loop = data_io_thread->GetLoop().lock();
+    IOLoop* loop_ptr = loop.get();
+    xdp_sockets[i]->SetBatchCallback([loop_ptr](uint32_t packets) {
+      DataHandler::GetInstance().FlushBatch();
+      loop_ptr->AddStats(packets);
+    });
+    loop->AddDelegate(xdp_sockets[i]->GetFd(), xdp_sockets[i].get(), nullptr);
+    xdp_socket_threads_.push_back(data_io_thread);
+    xdp_sockets_.push_back(std::move(xdp_sockets[i]));
+  }
+  LOG_INFO("Create {} xdp sockets on {} for {} data ports.", xdp_sockets_.size(),
+      sdk_framework_cfg_ptr_->xdp_netif, dst_ports.size());
+  return true;
+}
+
+void DeviceManager::StartDetection() {
+  detection_timer_id_ = control_io_thread_->GetLoop().lock()->AddTimer(0, kDetectionInterval, [this](TimePoint) {
+    Detection();
+  });
 }
 
 void DeviceManager::Detection() {
@@ -449,36 +930,157 @@ void DeviceManager::Detection() {
 }
 
 void DeviceManager::OnData(socket_t sock, void *client_data) {
-  struct sockaddr addr;
-  int addrlen = sizeof(addr);
+  RecvBatch(sock, static_cast<RecvBufferPool*>(client_data));
+}
 
-  std::unique_ptr<char[]> buf = nullptr;
-  if (buf.get() == NULL) {
-    buf.reset(new char[kMaxBufferSize]);
+int DeviceManager::OnDrain(socket_t sock, void *client_data, int budget) {
+  RecvBufferPool* recv_buffer_pool = static_cast<RecvBufferPool*>(client_data);
+  int batch_size = 1;
+  if (recv_buffer_pool != nullptr) {
+    batch_size = std::min(static_cast<int>(recv_buffer_pool->GetSlotNum()), util::kMaxRecvMsgNum);
+  }
+  int count = 0;
+  while (count < budget) {
+    int num = RecvBatch(sock, recv_buffer_pool);
+    count += num;
+    if (num < batch_size) {
+      break;
+    }
   }
+  return count;
+}
 
-  int size = util::RecvFrom(sock, reinterpret_cast<char *>(buf.get()), kMaxBufferSize, 0, &addr, &addrlen);
-  if (size <= 0) {
-    return;
+int DeviceManager::RecvBatch(socket_t sock, RecvBufferPool* recv_buffer_pool) {
+  uint8_t buf[kMaxBufferSize];
+  util::RecvMsg msgs[util::kMaxRecvMsgNum];
+
+  int recv_num = 1;
+  if (recv_buffer_pool != nullptr) {
+    recv_buffer_pool->Recycle();
+    recv_num = std::min(static_cast<int>(recv_buffer_pool->GetSlotNum()), util::kMaxRecvMsgNum);
+    for (int i = 0; i < recv_num; ++i) {
+      msgs[i].buff = recv_buffer_pool->GetSlot(i);
+      msgs[i].buf_size = recv_buffer_pool->GetSlotSize();
+    }
+  } else {
+    msgs[0].buff = buf;
+    msgs[0].buf_size = sizeof(buf);
+  }
+
+  int num = util::RecvMultiFrom(sock, msgs, recv_num);
+  DataHandler::SetRecvBufferPool(recv_buffer_pool);
+  uint64_t packet_count = 0;
+  for (int i = 0; i < num; ++i) {
+    const struct sockaddr_in* addr = (const struct sockaddr_in*)&msgs[i].addr;
+    uint32_t handle = addr->sin_addr.s_addr;
+    uint16_t port = ntohs(addr->sin_port);
+    uint8_t* buff = (uint8_t*)(msgs[i].buff);
+    int segment_size = msgs[i].segment_size;
+    if (segment_size <= 0 || segment_size >= msgs[i].size) {
+      OnPacket(handle, port, buff, msgs[i].size, msgs[i].timestamp);
+      ++packet_count;
+      continue;
+    }
+    // A UDP_GRO datagram, every segment but the last is segment_size long.
+    for (int offset = 0; offset < msgs[i].size; offset += segment_size) {
+      OnPacket(handle, port, buff + offset, std::min(segment_size, msgs[i].size - offset), msgs[i].timestamp);
+      ++packet_count;
+    }
+  }
+  DataHandler::GetInstance().FlushBatch();
+  DataHandler::SetRecvBufferPool(nullptr);
+  if (recv_buffer_pool != nullptr) {
+    recv_buffer_pool->AddPacketCount(packet_count);
   }
+  return num;
+}
 
-  uint32_t handle = ((struct sockaddr_in *)&addr)->sin_addr.s_addr;
-  uint16_t port = ntohs(((struct sockaddr_in *)&addr)->sin_port);
+int32_t DeviceManager::PollData(LivoxLidarPollBuffer* buffers, uint32_t max_packets, uint32_t timeout_us) {
+  std::lock_guard<std::mutex> lock(poll_mutex_);
+  if (poll_sockets_.empty()) {
+    return -1;
+  }
+  uint32_t packet_num = RecvPollData(buffers, max_packets);
+  if (packet_num == 0 && timeout_us > 0 && util::WaitReadable(poll_sockets_, timeout_us)) {
+    packet_num = RecvPollData(buffers, max_packets);
+  }
+  return static_cast<int32_t>(packet_num);
+}
 
-  struct in_addr tmp_addr;
-  tmp_addr.s_addr = handle;
-  std::string lidar_ip = inet_ntoa(tmp_addr);
+uint32_t DeviceManager::RecvPollData(LivoxLidarPollBuffer* buffers, uint32_t max_packets) {
+  util::RecvMsg msgs[util::kMaxRecvMsgNum];
+  uint32_t packet_num = 0;
+  // Start at the next socket each call, so a busy lidar does not starve the others.
+  size_t socket_num = poll_sockets_.size();
+  size_t first_socket = next_poll_socket_++ % socket_num;
+  for (size_t n = 0; n < socket_num && packet_num < max_packets; ++n) {
+    socket_t sock = poll_sockets_[(first_socket + n) % socket_num];
+    while (packet_num < max_packets) {
+      int recv_num = static_cast<int>(std::min(max_packets - packet_num, static_cast<uint32_t>(util::kMaxRecvMsgNum)));
+      for (int i = 0; i < recv_num; ++i) {
+        msgs[i].buff = buffers[packet_num + i].buf;
+        msgs[i].buf_size = buffers[packet_num + i].buf_size;
+      }
+      int num = util::RecvMultiFrom(sock, msgs, recv_num);
+      uint32_t first_packet = packet_num;
+      for (int i = 0; i < num; ++i) {
+        const struct sockaddr_in* addr = (const struct sockaddr_in*)&msgs[i].addr;
+        uint32_t handle = addr->sin_addr.s_addr;
+        uint16_t port = ntohs(addr->sin_port);
+        RouteEntry route;
+        bool routed = FindRoute(handle, port, &route);
+        OnPacket(handle, port, (uint8_t*)msgs[i].buff, msgs[i].size, msgs[i].timestamp);
+        if (!routed || route.dest != kRouteData || msgs[i].size <= 0) {
+          continue;
+        }
+        // Move the slot over the ones of the skipped datagrams.
+        if (packet_num != first_packet + i) {
+          std::swap(buffers[packet_num], buffers[first_packet + i]);
+        }
+        LivoxLidarPollBuffer& buffer = buffers[packet_num++];
+        buffer.size = static_cast<uint32_t>(msgs[i].size);
+        buffer.handle = handle;
+        buffer.dev_type = route.dev_type;
+        buffer.timestamp = msgs[i].timestamp;
+      }
+      if (num < recv_num) {
+        break;
+      }
+    }
+  }
+  DataHandler::GetInstance().FlushBatch();
+  return packet_num;
+}
+
+void DeviceManager::OnDatagram(socket_t sock, uint8_t* buf, int size, const struct sockaddr* addr, uint64_t timestamp, void* client_data) {
+  RecvBufferPool* recv_buffer_pool = static_cast<RecvBufferPool*>(client_data);
+  if (recv_buffer_pool != nullptr) {
+    recv_buffer_pool->AddPacketCount(1);
+  }
+  const struct sockaddr_in* addr_in = (const struct sockaddr_in*)addr;
+  OnPacket(addr_in->sin_addr.s_addr, ntohs(addr_in->sin_port), buf, size, timestamp);
+}
+
+void DeviceManager::OnDatagramBatch(socket_t sock, void* client_data) {
+  DataHandler::GetInstance().FlushBatch();
+}
+
+void DeviceManager::OnPacket(uint32_t handle, uint16_t port, uint8_t* buf, int size, uint64_t timestamp) {
+  if (size <= 0) {
+    return;
+  }
+  DataHandler::SetRxTimestamp(timestamp);
 
-  if (lidar_ip == detection_host_ip_) {
+  if (handle == detection_host_addr_) {
     return;
   }
 
   if (port == kMid360LidarDebugPointCloudPort || port == kHAPDebugPointCloudPort) {
-    DebugPointCloudManager::GetInstance().Handler(handle, port, (uint8_t*)(buf.get()), size);
+    DebugPointCloudManager::GetInstance().Handler(handle, port, buf, size);
   }
 
   if (port == kHAPLogPort || port == kPaLidarLogPort || port == kMid360LidarLogPort) {
-    LoggerManager::GetInstance().Handler(handle, port, (uint8_t*)(buf.get()), size);
+    LoggerManager::GetInstance().Handler(handle, port, buf, size);
   }
 
   if (is_view_) {
@@ -492,38 +1094,35 @@ void DeviceManager::OnData(socket_t sock, void *client_data) {
 
     if (view_lidar_info_ptr != nullptr) {
       if (port == view_lidar_info_ptr->lidar_point_port || port == view_lidar_info_ptr->lidar_imu_data_port) {
-        DataHandler::GetInstance().Handle(view_lidar_info_ptr->dev_type, handle, (uint8_t*)(buf.get()), size);
+        DataHandler::GetInstance().Handle(view_lidar_info_ptr->dev_type, handle, buf, size);
       } else {
-        GeneralCommandHandler::GetInstance().Handler(view_lidar_info_ptr->dev_type, handle, port, (uint8_t*)(buf.get()), size);
+        GeneralCommandHandler::GetInstance().Handler(view_lidar_info_ptr->dev_type, handle, port, buf, size);
       }
     } else {
-      GeneralCommandHandler::GetInstance().Handler(handle, port, (uint8_t*)(buf.get()), size);
+      GeneralCommandHandler::GetInstance().Handler(handle, port, buf, size);
     }
     return;
   }
 
-  if (custom_lidars_cfg_map_.find(handle) != custom_lidars_cfg_map_.end()) {
-    const LivoxLidarCfg& lidar_cfg = custom_lidars_cfg_map_[handle];
-    if (port == lidar_cfg.lidar_net_info.imu_data_port || port == lidar_cfg.lidar_net_info.point_data_port) {
-      DataHandler::GetInstance().Handle(lidar_cfg.device_type, handle, (uint8_t*)(buf.get()), size);
-      return;
-    }
-    if (port == kDetectionPort || port == lidar_cfg.lidar_net_info.cmd_data_port || port == lidar_cfg.lidar_net_info.push_msg_port ||
-        port == lidar_cfg.lidar_net_info.log_data_port || port == kPaLidarFaultPort) {
-      GeneralCommandHandler::GetInstance().Handler(lidar_cfg.device_type, handle, port, (uint8_t*)(buf.get()), size);
-      return;
+  RouteEntry route;
+  if (FindRoute(handle, port, &route)) {
+    if (route.dest == kRouteData) {
+      DataHandler::GetInstance().Handle(route.dev_type, handle, buf, size);
+    } else {
+      GeneralCommandHandler::GetInstance().Handler(route.dev_type, handle, port, buf, size);
     }
     return;
   }
 
-  // parse the device type info from config_ptr and add to custom_lidars_cfg_map_
+  // Every known lidar has a route of the detection port, so only the detection data of a
+  // new lidar gets here. Parse its device type and add it to custom_lidars_cfg_map_.
   if (port != kDetectionPort) {
     return;
   }
 
   CommPacket packet;
   memset(&packet, 0, sizeof(packet));
-  if (!(comm_port_->ParseCommStream((uint8_t*)(buf.get()), size, &packet))) {
+  if (!(comm_port_->ParseCommStream(buf, size, &packet))) {
     LOG_INFO("Parse Command Stream failed.");
     return;
   }
@@ -548,12 +1147,13 @@ void DeviceManager::OnData(socket_t sock, void *client_data) {
   lidar_cfg.lidar_net_info.lidar_ipaddr = inet_ntoa(binary_ip);
   custom_lidars_cfg_map_[handle] = lidar_cfg;
   custom_lidars_cfg_ptr_->push_back(lidar_cfg);
+  UpdateRouteTable();
   GeneralCommandHandler::GetInstance().Init(custom_lidars_cfg_ptr_, this);
   GeneralCommandHandler::GetInstance().CreateCommandHandler(detection_data->dev_type);
 
   for (auto it = custom_lidars_cfg_ptr_->begin(); it != custom_lidars_cfg_ptr_->end(); ++it) {
     const HostNetInfo& host_net_info = it->host_net_info;
-    if (!CreateDataChannel(host_net_info)) {
+    if (!CreateDataChannel(host_net_info, it->lidar_net_info.lidar_ipaddr)) {
       LOG_ERROR("Create data channel failed.");
       return;
     }
@@ -705,10 +1305,14 @@ void DeviceManager::AddViewLidar(const uint32_t handle, LivoxLidarDiagInternalIn
 }
 
 void DeviceManager::CreateViewDataChannel(const ViewLidarIpInfo& view_lidar_info) {
+  struct in_addr lidar_addr;
+  lidar_addr.s_addr = view_lidar_info.handle;
+  std::string lidar_ip = inet_ntoa(lidar_addr);
+
   std::string point_key = view_lidar_info.host_ip + ":" + std::to_string(view_lidar_info.host_point_port);
   if (channel_info_.find(point_key) == channel_info_.end()) {
     socket_t sock = -1;
-    sock = util::CreateSocket(view_lidar_info.host_point_port, true, true, true, view_lidar_info.host_ip, "");
+    sock = CreateRoleSocket(kLivoxLidarSocketPoint, view_lidar_info.host_point_port, true, view_lidar_info.host_ip);
     if (sock < 0) {
       LOG_ERROR("Create View point data channel faileld, can not create socket, the ip {} port {} ",
           view_lidar_info.host_ip.c_str(), view_lidar_info.host_point_port);
@@ -716,13 +1320,15 @@ void DeviceManager::CreateViewDataChannel(const ViewLidarIpInfo& view_lidar_info
     }
     socket_vec_.push_back(sock);
     channel_info_[point_key] = sock;
-    data_io_thread_->GetLoop().lock()->AddDelegate(sock, this, nullptr);
+    std::shared_ptr<IOThread> data_io_thread = SelectDataIOThread(lidar_ip);
+    data_channel_[sock] = data_io_thread;
+    data_io_thread->GetLoop().lock()->AddRecvDelegate(sock, this, data_io_thread->GetRecvBufferPool());
   }
 
   std::string imu_key = view_lidar_info.host_ip + ":" + std::to_string(view_lidar_info.host_imu_data_port);
   if (channel_info_.find(imu_key) == channel_info_.end()) {
     socket_t sock = -1;
-    sock = util::CreateSocket(view_lidar_info.host_imu_data_port, true, true, true, view_lidar_info.host_ip, "");
+    sock = CreateRoleSocket(kLivoxLidarSocketImu, view_lidar_info.host_imu_data_port, true, view_lidar_info.host_ip);
     if (sock < 0) {
       LOG_ERROR("Create View point data channel faileld, can not create socket, the ip {} port {} ",
           view_lidar_info.host_ip.c_str(), view_lidar_info.host_imu_data_port);
@@ -730,7 +1336,12 @@ void DeviceManager::CreateViewDataChannel(const ViewLidarIpInfo& view_lidar_info
     }
     socket_vec_.push_back(sock);
     channel_info_[imu_key] = sock;
-    data_io_thread_->GetLoop().lock()->AddDelegate(sock, this, nullptr);
+    if (imu_io_thread_ && !util::EnableRxTimestamp(sock)) {
+      LOG_WARN("Enable the receive timestamp on {} failed.", imu_key);
+    }
+    std::shared_ptr<IOThread> data_io_thread = SelectDataIOThread(lidar_ip, true);
+    data_channel_[sock] = data_io_thread;
+    data_io_thread->GetLoop().lock()->AddRecvDelegate(sock, this, data_io_thread->GetRecvBufferPool());
   }
 }
 
@@ -754,10 +1365,6 @@ uint8_t DeviceManager::GetDeviceType(const uint32_t handle) {
   return dev_type;
 }
 
-void DeviceManager::OnTimer(TimePoint now) {
-  GeneralCommandHandler::GetInstance().CommandsHandle(now);
-}
-
 int DeviceManager::SendCommand(const uint8_t dev_type, const uint32_t handle, const std::vector<uint8_t>& buf, 
     const int16_t size, const struct sockaddr *addr, socklen_t addrlen) {
   socket_t sock = -1;
@@ -806,42 +1413,86 @@ bool DeviceManager::GetLoggerCmdChannel(const uint8_t dev_type, const uint32_t h
 }
 
 void DeviceManager::Destory() {
+  if (!detection_host_ip_.empty()) {
+    LogRecvBufferPoolStats("control", control_io_thread_);
+    LogRecvBufferPoolStats("imu", imu_io_thread_);
+    for (size_t i = 0; i < data_io_threads_.size(); ++i) {
+      LogRecvBufferPoolStats("data " + std::to_string(i), data_io_threads_[i]);
+    }
+    for (size_t i = 0; i < packet_rings_.size(); ++i) {
+      LOG_INFO("The packet ring {} captured {} packets, the kernel dropped {} packets.", i,
+          packet_rings_[i]->GetPacketCount(), packet_rings_[i]->GetDropCount());
+    }
+    for (size_t i = 0; i < xdp_sockets_.size(); ++i) {
+      LOG_INFO("The xdp socket {} received {} packets, the kernel dropped {} packets.", i,
+          xdp_sockets_[i]->GetPacketCount(), xdp_sockets_[i]->GetDropCount());
+    }
+  }
   detection_host_ip_ = "";
 
+  // Stop the detection broadcast before its socket is closed.
+  if (detection_timer_id_ != 0) {
+    control_io_thread_->GetLoop().lock()->RemoveTimer(detection_timer_id_);
+    detection_timer_id_ = 0;
+  }
+
   if (detection_socket_ > 0) {
-    detection_io_thread_->GetLoop().lock()->RemoveDelegate(detection_socket_, this);
+    control_io_thread_->GetLoop().lock()->RemoveDelegate(detection_socket_, this);
   }
 
   if (detection_broadcast_socket_ > 0) {
-    detection_io_thread_->GetLoop().lock()->RemoveDelegate(detection_broadcast_socket_, this);
+    control_io_thread_->GetLoop().lock()->RemoveDelegate(detection_broadcast_socket_, this);
   }
 
   for (auto it = command_channel_.begin(); it != command_channel_.end(); ++it) {
     socket_t sock = *it;
     if (sock > 0) {
-      cmd_io_thread_->GetLoop().lock()->RemoveDelegate(sock, this);
+      control_io_thread_->GetLoop().lock()->RemoveDelegate(sock, this);
     }
   }
 
   for (auto it = vec_broadcast_socket_.begin(); it != vec_broadcast_socket_.end(); ++it) {
     socket_t sock = *it;
     if (sock > 0) {
-      cmd_io_thread_->GetLoop().lock()->RemoveDelegate(sock, this);
+      control_io_thread_->GetLoop().lock()->RemoveDelegate(sock, this);
     }
   }
   
   for (auto it = data_channel_.begin(); it != data_channel_.end(); ++it) {
-    socket_t sock = *it;
-    if (sock > 0) {
-      data_io_thread_->GetLoop().lock()->RemoveDelegate(sock, this);
+    socket_t sock = it->first;
+    if (sock > 0 && it->second) {
+      it->second->GetLoop().lock()->RemoveDelegate(sock, this);
     }
   }
 
+  // The rings are unmapped when the data io threads are recreated or destroyed.
+  for (size_t i = 0; i < packet_rings_.size() && i < data_io_threads_.size(); ++i) {
+    data_io_threads_[i]->GetLoop().lock()->RemoveDelegate(packet_rings_[i]->GetFd(), packet_rings_[i].get());
+  }
+
+  for (size_t i = 0; i < xdp_sockets_.size() && i < xdp_socket_threads_.size(); ++i) {
+    xdp_socket_threads_[i]->GetLoop().lock()->RemoveDelegate(xdp_sockets_[i]->GetFd(), xdp_sockets_[i].get());
+  }
+  xdp_socket_threads_.clear();
+  // Detach the program so the frames go back to the network stack.
+  xdp_program_.reset();
+
+  {
+    // Wait for a running LivoxLidarPollData, its sockets are closed below.
+    std::lock_guard<std::mutex> lock(poll_mutex_);
+    poll_sockets_.clear();
+    next_poll_socket_ = 0;
+  }
+
   for (socket_t& sock : socket_vec_) {
     util::CloseSock(sock);
     sock = -1;
   }
   socket_vec_.clear();
+  {
+    std::lock_guard<std::mutex> lock(socket_buffer_info_mutex_);
+    memset(socket_buffer_info_, 0, sizeof(socket_buffer_info_));
+  }
 
   for (socket_t & sock : vec_broadcast_socket_) {
     util::CloseSock(sock);
@@ -849,20 +1500,14 @@ void DeviceManager::Destory() {
   }
   vec_broadcast_socket_.clear();
 
-  if (detection_thread_) {
-    is_stop_detection_.store(true);
-    detection_thread_->join();
-    detection_thread_ = nullptr;
-
-    if (detection_socket_ > 0) {
-      util::CloseSock(detection_socket_);
-      detection_socket_ = -1;
-    }
+  if (detection_socket_ > 0) {
+    util::CloseSock(detection_socket_);
+    detection_socket_ = -1;
+  }
 
-    if (detection_broadcast_socket_ > 0) {
-      util::CloseSock(detection_broadcast_socket_);
-      detection_broadcast_socket_ = -1;
-    }
+  if (detection_broadcast_socket_ > 0) {
+    util::CloseSock(detection_broadcast_socket_);
+    detection_broadcast_socket_ = -1;
   }
 
   lidars_cfg_ptr_ = nullptr;
@@ -871,16 +1516,20 @@ void DeviceManager::Destory() {
   type_lidars_cfg_map_.clear();
   custom_lidars_cfg_map_.clear();
 
+  route_table_.store(nullptr, std::memory_order_release);
+  route_epoch_.Synchronize();
+  route_table_owner_.reset();
+
   channel_info_.clear();
   custom_command_channel_.clear();
 
   command_channel_.clear();
   data_channel_.clear();
+  reuseport_groups_.clear();
+  shared_data_sockets_.clear();
 
   comm_port_.reset(nullptr);
 
-  is_stop_detection_.store(true);
-
   {
     std::lock_guard<std::mutex> lock(lidars_dev_type_mutex_);
     lidars_dev_type_.clear();
@@ -888,6 +1537,7 @@ void DeviceManager::Destory() {
 
   is_view_ = false;
   detection_host_ip_ = "";
+  detection_host_addr_ = 0;
   
   {
     std::lock_guard<std::mutex> lock(view_device_mutex_);
@@ -900,6 +1550,28 @@ void DeviceManager::Destory() {
   }
 }
 
+void DeviceManager::LogRecvBufferPoolStats(const std::string& name, const std::shared_ptr<IOThread>& io_thread) {
+  if (io_thread == nullptr || io_thread->GetRecvBufferPool() == nullptr) {
+    return;
+  }
+  RecvBufferPool* recv_buffer_pool = io_thread->GetRecvBufferPool();
+  LOG_INFO("The {} io thread received {} packets with {} recv buffer heap allocations.", name,
+      recv_buffer_pool->GetPacketCount(), recv_buffer_pool->GetHeapAllocCount());
+  size_t lent_num = recv_buffer_pool->GetLentNum();
+  if (lent_num != 0 || recv_buffer_pool->GetRetainFailCount() != 0) {
+    LOG_INFO("The {} io thread still lends {} packet buffers, {} packets were copied for want of a spare buffer.",
+        name, lent_num, recv_buffer_pool->GetRetainFailCount());
+  }
+
+  std::shared_ptr<IOLoop> loop = io_thread->GetLoop().lock();
+  PollStats stats = loop ? loop->GetStats() : PollStats();
+  if (stats.wakeup_count != 0) {
+    LOG_INFO("The {} io loop handled {} packets in {} wakeups, {:.1f} packets per wakeup, at most {}.", name,
+        stats.packet_count, stats.wakeup_count,
+        static_cast<double>(stats.packet_count) / stats.wakeup_count, stats.max_wakeup_packets);
+  }
+}
+
 DeviceManager::~DeviceManager() {
   Destory();
 }
@@ -29,7 +29,11 @@
 
 #include "comm/define.h"
 #include "comm/comm_port.h"
+#include "route_table.h"
+#include "base/reader_epoch.h"
 #include "base/io_thread.h"
+#include "base/capture/packet_ring.h"
+#include "base/capture/xdp_socket.h"
 #include "base/network/network_util.h"
 
 #include <string>
@@ -56,6 +60,9 @@ namespace livox {
 namespace lidar {
 
 static const size_t kMaxBufferSize = 8192;
+static const size_t kMaxGroBufferSize = 65536;
+static const uint32_t kCommandTimeoutCheckInterval = 50;  // ms
+static const uint32_t kDetectionInterval = 1000;  // ms
 const uint8_t kSdkVer = 3;
 
 class Protector {};
@@ -119,7 +126,15 @@ class DeviceManager : public IOLoop::IOLoopDelegate {
   void UpdateViewLidarCfgCallback(const uint32_t handle);
 
   void OnData(socket_t sock, void *);
-  void OnTimer(TimePoint now);
+  int OnDrain(socket_t sock, void *client_data, int budget);
+  void OnDatagram(socket_t sock, uint8_t* buf, int size, const struct sockaddr* addr, uint64_t timestamp, void* client_data);
+  void OnDatagramBatch(socket_t sock, void* client_data);
+  void OnPacket(uint32_t handle, uint16_t port, uint8_t* buf, int size, uint64_t timestamp = 0);
+  livox_status PostDataTask(uint32_t data_io_thread_index, const IOLoop::IOLoopTask& task);
+  /** Loop of the control io thread, which runs the detection, the commands and the log files. */
+  std::shared_ptr<IOLoop> GetControlLoop();
+  bool GetSocketBufferInfo(LivoxLidarSocketRole role, LivoxLidarSocketBufferInfo* info);
+  int32_t PollData(LivoxLidarPollBuffer* buffers, uint32_t max_packets, uint32_t timeout_us);
   
   std::shared_ptr<LivoxLidarSdkFrameworkCfg> sdk_framework_cfg_ptr_;
 
@@ -129,21 +144,40 @@ class DeviceManager : public IOLoop::IOLoopDelegate {
   void CreateViewDataChannel(const ViewLidarIpInfo& view_lidar_info);
 
   void GetLidarConfigMap();
+  void UpdateRouteTable();
+  /** Copies the route of (handle, port) out of the current table, false if there is none. */
+  bool FindRoute(uint32_t handle, uint16_t port, RouteEntry* route);
   void InitDevTypeTable(const LivoxLidarCfg& lidar_cfg);
 
   bool CreateIOThread();
-  bool CreateDetectionIOThread();
-  bool CreateCommandIOThread();
+  bool CreateControlIOThread();
   bool CreateDataIOThread();
+  bool CreateImuIOThread();
+  std::shared_ptr<IOThread> SelectDataIOThread(const std::string& lidar_ip, bool imu = false);
+  int RecvBatch(socket_t sock, RecvBufferPool* recv_buffer_pool);
+  uint32_t RecvPollData(LivoxLidarPollBuffer* buffers, uint32_t max_packets);
+  void LogRecvBufferPoolStats(const std::string& name, const std::shared_ptr<IOThread>& io_thread);
 
   bool CreateChannel();
   bool CreateDetectionChannel();
-  bool CreateDataChannel(const HostNetInfo& host_net_info);
+  bool CreateDataChannel(const HostNetInfo& host_net_info, const std::string& lidar_ip);
   bool CreateCommandChannel(const uint8_t dev_type, const HostNetInfo& host_net_info);
   bool CreateCmdSocketAndAddDelegate(const uint8_t dev_type, const std::string& host_ip, const uint16_t port, const HostSocketType type);
-  bool CreateDataSocketAndAddDelegate(const std::string& host_ip, const uint16_t port, const std::string& multicast_ip);
-
-  void DetectionLidars();
+  bool CreateDataSocketAndAddDelegate(const std::string& host_ip, const uint16_t port,
+                                      const std::string& multicast_ip, const std::string& lidar_ip,
+                                      LivoxLidarSocketRole role);
+  bool CreateReusePortDataSockets(const std::string& key, const std::string& host_ip, const uint16_t port,
+                                  LivoxLidarSocketRole role);
+  bool IsDataGroEnabled() const;
+  socket_t CreateRoleSocket(LivoxLidarSocketRole role, uint16_t port, bool is_broadcast, const std::string& netif,
+                            const std::string& multicast_ip = "");
+  void RecordSocketBuffer(socket_t sock, LivoxLidarSocketRole role);
+  void SetDataSocketOptions(socket_t sock, const std::string& key);
+  void AttachReusePortFilter(const std::string& key, const std::string& host_ip, const uint16_t port);
+  bool CreatePacketRing();
+  bool CreateXdpSockets();
+
+  void StartDetection();
   void Detection();
 
   uint8_t GetDeviceType(const uint32_t handle);
@@ -173,23 +207,39 @@ class DeviceManager : public IOLoop::IOLoopDelegate {
   std::map<std::string, socket_t> custom_command_channel_;
 
   std::set<socket_t> command_channel_;
-  std::set<socket_t> data_channel_;
+  std::map<socket_t, std::shared_ptr<IOThread>> data_channel_;
+  std::map<std::string, std::vector<socket_t>> reuseport_groups_;
+  std::set<std::string> shared_data_sockets_;  /* lidar ip and socket key pairs warned about. */
   std::vector<socket_t> vec_broadcast_socket_;
 
-  std::shared_ptr<IOThread> cmd_io_thread_;
-  std::shared_ptr<IOThread> data_io_thread_;
-  std::shared_ptr<IOThread> detection_io_thread_;
+  std::shared_ptr<IOThread> control_io_thread_;
+  // Declared before the io threads so the threads are joined before the rings are unmapped.
+  std::vector<std::unique_ptr<PacketRing>> packet_rings_;
+  std::set<uint16_t> packet_ring_ports_;
+  std::unique_ptr<XdpProgram> xdp_program_;
+  std::vector<std::unique_ptr<XdpSocket>> xdp_sockets_;
+  std::vector<std::shared_ptr<IOThread>> xdp_socket_threads_;
+
+  std::vector<std::shared_ptr<IOThread>> data_io_threads_;
+  uint32_t next_data_io_thread_;
+  // Receives the imu data apart from the point cloud, null unless "imu_io_thread" is set.
+  std::shared_ptr<IOThread> imu_io_thread_;
 
   std::unique_ptr<CommPort> comm_port_;
 
-  std::atomic<bool> is_stop_detection_{false};
-  std::shared_ptr<std::thread> detection_thread_;
+  uint64_t detection_timer_id_;
 
   std::mutex lidars_dev_type_mutex_;
   std::map<uint32_t, uint16_t> lidars_dev_type_;
 
   bool is_view_;
   std::string detection_host_ip_;
+  uint32_t detection_host_addr_;
+
+  // Looked up inside a read section, a replaced table is freed after a grace period.
+  std::atomic<const RouteTable*> route_table_;
+  std::unique_ptr<const RouteTable> route_table_owner_;
+  ReaderEpoch route_epoch_;
   
   std::mutex view_device_mutex_;
   std::map<uint32_t, ViewDevice> view_devices_;
@@ -198,6 +248,16 @@ class DeviceManager : public IOLoop::IOLoopDelegate {
   std::map<uint32_t, std::shared_ptr<ViewLidarIpInfo>> view_lidars_info_;
 
   bool enable_save_log_;
+  uint32_t recv_batch_size_;
+
+  std::mutex socket_buffer_info_mutex_;
+  LivoxLidarSocketBufferInfo socket_buffer_info_[kLivoxLidarSocketRoleNum];
+
+  // The data sockets read by LivoxLidarPollData when "data_poll_enable" is set, the mutex is
+  // held for a whole poll call.
+  std::mutex poll_mutex_;
+  std::vector<socket_t> poll_sockets_;
+  size_t next_poll_socket_;
 };
 
 } // namespace lidar
@@ -143,10 +143,28 @@ uint16_t LivoxLidarAddPointCloudObserver(LivoxLidarPointCloudObserver cb, void *
   return DataHandler::GetInstance().AddPointCloudObserver(cb, client_data);
 }
 
+uint16_t LivoxLidarAddPointCloudTypeObserver(uint8_t data_type, LivoxLidarPointCloudObserver cb, void* client_data) {
+  if (cb == nullptr) {
+    return 0;
+  }
+  return DataHandler::GetInstance().AddPointCloudObserver(cb, client_data, data_type);
+}
+
 void LivoxLidarRemovePointCloudObserver(uint16_t id) {
   DataHandler::GetInstance().RemovePointCloudObserver(id);
 }
 
+uint16_t LivoxLidarAddPointCloudBatchObserver(LivoxLidarPointCloudBatchObserver cb, void* client_data) {
+  if (cb == nullptr) {
+    return 0;
+  }
+  return DataHandler::GetInstance().AddPointCloudBatchObserver(cb, client_data);
+}
+
+void LivoxLidarRemovePointCloudBatchObserver(uint16_t id) {
+  DataHandler::GetInstance().RemovePointCloudBatchObserver(id);
+}
+
 void SetLivoxLidarPointCloudCallBack(LivoxLidarPointCloudCallBack cb, void *client_data) {
   DataHandler::GetInstance().SetPointDataCallback(cb, client_data);
 }
@@ -159,6 +177,85 @@ void LivoxLidarRemoveCmdObserver() {
   GeneralCommandHandler::GetInstance().LivoxLidarRemoveCmdObserver();
 }
 
+uint64_t LivoxLidarGetRxTimestamp() {
+  return DataHandler::GetRxTimestamp();
+}
+
+livox_status GetLivoxLidarImuLatencyStats(uint32_t handle, LivoxLidarImuLatencyStats* stats) {
+  if (!is_initialized || stats == nullptr) {
+    return kLivoxLidarStatusFailure;
+  }
+  return DataHandler::GetInstance().GetImuLatencyStats(handle, stats) ?
+      kLivoxLidarStatusSuccess : kLivoxLidarStatusFailure;
+}
+
+livox_status GetLivoxLidarSocketBufferInfo(LivoxLidarSocketRole role, LivoxLidarSocketBufferInfo* info) {
+  if (!is_initialized || info == nullptr) {
+    return kLivoxLidarStatusFailure;
+  }
+  return DeviceManager::GetInstance().GetSocketBufferInfo(role, info) ?
+      kLivoxLidarStatusSuccess : kLivoxLidarStatusFailure;
+}
+
+LivoxLidarPacketHandle LivoxLidarAcquirePacket(LivoxLidarEthernetPacket** packet) {
+  if (!is_initialized || packet == nullptr || *packet == nullptr) {
+    return nullptr;
+  }
+  return DataHandler::AcquirePacket(packet);
+}
+
+void LivoxLidarRetainPacket(LivoxLidarPacketHandle packet_handle) {
+  if (packet_handle != nullptr) {
+    AddPacketRef(static_cast<PacketRef*>(packet_handle));
+  }
+}
+
+void LivoxLidarReleasePacket(LivoxLidarPacketHandle packet_handle) {
+  if (packet_handle != nullptr) {
+    ReleasePacketRef(static_cast<PacketRef*>(packet_handle));
+  }
+}
+
+uint16_t LivoxLidarAddPointCloudConsumer(LivoxLidarPointCloudObserver cb, void* client_data, uint32_t capacity,
+                                         LivoxLidarOverflowPolicy policy) {
+  if (!is_initialized || cb == nullptr || capacity == 0 || capacity > kMaxConsumerCapacity) {
+    return 0;
+  }
+  if (policy != kLivoxLidarOverflowDropOldest && policy != kLivoxLidarOverflowDropNewest &&
+      policy != kLivoxLidarOverflowBlock) {
+    return 0;
+  }
+  return DataHandler::GetInstance().AddPointCloudConsumer(cb, client_data, capacity, policy);
+}
+
+void LivoxLidarRemovePointCloudConsumer(uint16_t id) {
+  DataHandler::GetInstance().RemovePointCloudConsumer(id);
+}
+
+livox_status GetLivoxLidarConsumerStats(uint16_t id, LivoxLidarConsumerStats* stats) {
+  if (!is_initialized || stats == nullptr) {
+    return kLivoxLidarStatusFailure;
+  }
+  return DataHandler::GetInstance().GetConsumerStats(id, stats) ?
+      kLivoxLidarStatusSuccess : kLivoxLidarStatusFailure;
+}
+
+int32_t LivoxLidarPollData(LivoxLidarPollBuffer* buffers, uint32_t max_packets, uint32_t timeout_us) {
+  if (!is_initialized || buffers == nullptr || max_packets == 0) {
+    return -1;
+  }
+  return DeviceManager::GetInstance().PollData(buffers, max_packets, timeout_us);
+}
+
+livox_status LivoxLidarPostDataTask(uint32_t data_io_thread_index, LivoxLidarDataTaskCallback cb, void* client_data) {
+  if (!is_initialized || cb == nullptr) {
+    return kLivoxLidarStatusFailure;
+  }
+  return DeviceManager::GetInstance().PostDataTask(data_io_thread_index, [cb, client_data]() {
+    cb(client_data);
+  });
+}
+
 void SetLivoxLidarImuDataCallback(LivoxLidarImuDataCallback cb, void* client_data) {
   DataHandler::GetInstance().SetImuDataCallback(cb, client_data);
 }
@@ -324,7 +421,7 @@ void SetLivoxLidarUpgradeProgressCallback(OnLivoxLidarUpgradeProgressCallback cb
   UpgradeManager::GetInstance().SetLivoxLidarUpgradeProgressCallback(cb, client_data);
 }
 
-void UpgradeLivoxLidars(const uint32_t* handle, const uint8_t lidar_num) {
+void UpgradeLivoxLidars(const uint32_t* handle, const uint16_t lidar_num) {
   UpgradeManager::GetInstance().UpgradeLivoxLidars(handle, lidar_num);
 }
 
@@ -37,6 +37,8 @@
 namespace livox {
 namespace lidar {
 
+static const uint32_t kLogWriteInterval = 100;  // ms
+
 std::string GetCurFormatTime() {
   std::time_t t = std::time(nullptr);
   std::stringstream format_time;
@@ -44,16 +46,25 @@ std::string GetCurFormatTime() {
   return format_time.str();
 }
 
-void LoggerHandler::Init() {
-  is_stop_write_.store(false);
-  thread_ptr_ = std::make_shared<std::thread>(&LoggerHandler::SaveToFile, this);
+void LoggerHandler::Init(const std::weak_ptr<IOLoop>& loop) {
+  loop_ = loop;
+  std::shared_ptr<IOLoop> io_loop = loop_.lock();
+  if (!io_loop) {
+    LOG_ERROR("Init logger handler failed, the loop is released.");
+    return;
+  }
+  write_timer_id_ = io_loop->AddTimer(kLogWriteInterval, kLogWriteInterval, [this](TimePoint) {
+    Write();
+  });
 }
 
 void LoggerHandler::Destory() {
-  if (thread_ptr_) {
-    is_stop_write_.store(true);
-    thread_ptr_->join();
-    thread_ptr_ = nullptr;
+  if (write_timer_id_ != 0) {
+    std::shared_ptr<IOLoop> io_loop = loop_.lock();
+    if (io_loop) {
+      io_loop->RemoveTimer(write_timer_id_);
+    }
+    write_timer_id_ = 0;
   }
 
   for (auto &file: current_files_) {
@@ -65,13 +76,6 @@ void LoggerHandler::Destory() {
   } 
 }
 
-void LoggerHandler::SaveToFile() {
-  while (!is_stop_write_.load()) {
-    Write();
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-  }
-}
-
 void LoggerHandler::StoreLogBag(DeviceLoggerFilePushRequest* req, uint8_t flag) {
   LOG_INFO("Transform Data Length : {}", req->data_length);
   WriteBuffer write_buff {};
@@ -186,6 +190,7 @@ void LoggerHandler::Write() {
 
     if (write_buff.trans_index < current_files_[write_buff.log_type].trans_index &&
         write_buff.flag != static_cast<uint8_t>(Flag::kCreateFile)) {
+      queue.pop();
       continue;
     }
 
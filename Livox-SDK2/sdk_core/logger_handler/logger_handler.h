@@ -30,7 +30,6 @@
 #include <map>
 #include <queue>
 #include <mutex>
-#include <thread>
 #include <stdio.h>
 
 #include "base/io_thread.h"
@@ -66,15 +65,16 @@ public:
   explicit LoggerHandler(std::string log_root_path, std::string serial_num) : 
     log_root_path_(log_root_path),
     serial_num_(serial_num),
-    is_stop_write_(false),
-    thread_ptr_(nullptr) {
+    loop_(),
+    write_timer_id_(0) {
   };
 
   ~LoggerHandler() {
     Destory();
   }
 
-  void Init();
+  /** The queued log data is written to the files on loop every 100 ms. */
+  void Init(const std::weak_ptr<IOLoop>& loop);
   void Destory();
 
   void StoreLogBag(DeviceLoggerFilePushRequest* req, uint8_t flag);
@@ -83,7 +83,6 @@ public:
   void StopFile(const WriteBuffer& write_buff);
 
   void Write();
-  void SaveToFile();
 private:
   std::string log_root_path_;
   std::map <uint8_t, std::string> log_branch_path_;
@@ -92,8 +91,8 @@ private:
   
   std::mutex queue_mutex_;
   std::queue<WriteBuffer> queue_;
-  std::atomic<bool> is_stop_write_;
-  std::shared_ptr<std::thread> thread_ptr_;
+  std::weak_ptr<IOLoop> loop_;
+  uint64_t write_timer_id_;
 };
 
 } // namespace lidar
@@ -26,6 +26,7 @@
 #include "file_manager.h"
 
 #include "command_handler/general_command_handler.h"
+#include "device_manager.h"
 
 #include "base/logging.h"
 #include "comm/protocol.h"
@@ -35,7 +36,6 @@
 #include <iomanip>
 #include <chrono>
 #include <iostream>
-#include <condition_variable>
 #ifdef WIN32
 #include<winsock2.h>
 #else
@@ -48,6 +48,7 @@ namespace lidar {
 constexpr uint16_t kMaxExceptionLogCachSizeMb = 200;
 constexpr uint16_t kExceptionLogCacheRatio = 1;
 constexpr uint16_t kRealtimeLogCacheRatio = 3;
+constexpr uint32_t kCycleDeleteInterval = 600 * 1000;  // ms
 
 LoggerManager::LoggerManager()
     : log_enable_(false),
@@ -56,8 +57,8 @@ LoggerManager::LoggerManager()
       max_realtimelog_cache_size_(150 * 1024 * 1024),
       max_exceptionlog_cache_size_(50 * 1024 * 1024),
       comm_port_(nullptr),
-      cycle_delete_thread_(nullptr),
-      cond_(false),
+      loop_(),
+      cycle_delete_timer_id_(0),
       is_destroy_(false) {
 }
 
@@ -103,8 +104,16 @@ bool LoggerManager::Init(std::shared_ptr<LivoxLidarLoggerCfg> lidar_logger_cfg_p
     LOG_ERROR("Change hidden files to normal files failed");
   }
 
+  std::shared_ptr<IOLoop> loop = DeviceManager::GetInstance().GetControlLoop();
+  if (!loop) {
+    LOG_ERROR("Init logger manager failed, the control loop is not created.");
+    return false;
+  }
+  loop_ = loop;
   log_cycle_delete_enable_.store(true);
-  cycle_delete_thread_ = std::make_shared<std::thread>(&LoggerManager::CycleDelete, this);
+  cycle_delete_timer_id_ = loop->AddTimer(kCycleDeleteInterval, kCycleDeleteInterval, [this](TimePoint) {
+    CycleDelete();
+  });
 
   return true;
 }
@@ -216,7 +225,7 @@ void LoggerManager::OnLoggerCreate(const uint32_t handle, DeviceLoggerFilePushRe
     if (devices_info_.find(handle) != devices_info_.end()) {
       auto serial_num = devices_info_[handle].sn;
       handlers_[handle] = std::make_shared<LoggerHandler>(log_root_path_, serial_num);
-      handlers_[handle]->Init();
+      handlers_[handle]->Init(loop_);
     }
   }
 
@@ -234,10 +243,14 @@ void LoggerManager::OnLoggerStopped(const uint32_t handle, DeviceLoggerFilePushR
 
   handler->StoreLogBag(data, static_cast<uint8_t>(Flag::kEndFile));
 
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    cond_ = true;
-    cv_.notify_one();
+  // A finished file may push the cache over its limit.
+  std::shared_ptr<IOLoop> loop = loop_.lock();
+  if (loop) {
+    loop->PostTask([this]() {
+      if (log_cycle_delete_enable_.load()) {
+        CycleDelete();
+      }
+    });
   }
 }
 
@@ -255,32 +268,26 @@ void LoggerManager::CycleDelete() {
   std::string realtime_log_save_path_ = log_root_path_ + (log_root_path_.back() == '/' ? "" : "/") + "type_0";
   std::string exception_log_save_path_ = log_root_path_ + (log_root_path_.back() == '/' ? "" : "/") + "type_1";
 
-  while (log_cycle_delete_enable_.load()) {
-    std::unique_lock<std::mutex> lock(mutex_);
-    cv_.wait_for(lock, std::chrono::seconds(600), [&]{ return cond_; });
-
-    if (IsDirectoryExits(realtime_log_save_path_) && (GetDirTotalSize(realtime_log_save_path_) > max_realtimelog_cache_size_)) {
-      if (!GetFileNames(realtime_log_save_path_, realtime_files_)) {
-        LOG_ERROR("Can not get filenames in this directory: {}", realtime_log_save_path_);
-      }
-      while (GetDirTotalSize(realtime_log_save_path_) > max_realtimelog_cache_size_ && realtime_files_.begin() != realtime_files_.end()) {
-        remove((realtime_log_save_path_ + "/" + realtime_files_.begin()->second).c_str());
-        realtime_files_.erase(realtime_files_.begin());
-      }
-      realtime_files_.clear();
+  if (IsDirectoryExits(realtime_log_save_path_) && (GetDirTotalSize(realtime_log_save_path_) > max_realtimelog_cache_size_)) {
+    if (!GetFileNames(realtime_log_save_path_, realtime_files_)) {
+      LOG_ERROR("Can not get filenames in this directory: {}", realtime_log_save_path_);
+    }
+    while (GetDirTotalSize(realtime_log_save_path_) > max_realtimelog_cache_size_ && realtime_files_.begin() != realtime_files_.end()) {
+      remove((realtime_log_save_path_ + "/" + realtime_files_.begin()->second).c_str());
+      realtime_files_.erase(realtime_files_.begin());
     }
+    realtime_files_.clear();
+  }
 
-    if (IsDirectoryExits(exception_log_save_path_) && GetDirTotalSize(exception_log_save_path_) > max_exceptionlog_cache_size_) {
-      if (!GetFileNames(exception_log_save_path_, exception_files_)) {
-        LOG_ERROR("Can not get filenames in this directory: {}", exception_log_save_path_);
-      }
-      while (GetDirTotalSize(exception_log_save_path_) > max_exceptionlog_cache_size_ && exception_files_.begin() != exception_files_.end()) {
-        remove((exception_log_save_path_ + "/" + exception_files_.begin()->second).c_str());
-        exception_files_.erase(exception_files_.begin());
-      }
-      exception_files_.clear();
+  if (IsDirectoryExits(exception_log_save_path_) && GetDirTotalSize(exception_log_save_path_) > max_exceptionlog_cache_size_) {
+    if (!GetFileNames(exception_log_save_path_, exception_files_)) {
+      LOG_ERROR("Can not get filenames in this directory: {}", exception_log_save_path_);
     }
-    cond_ = false;
+    while (GetDirTotalSize(exception_log_save_path_) > max_exceptionlog_cache_size_ && exception_files_.begin() != exception_files_.end()) {
+      remove((exception_log_save_path_ + "/" + exception_files_.begin()->second).c_str());
+      exception_files_.erase(exception_files_.begin());
+    }
+    exception_files_.clear();
   }
 }
 
@@ -342,16 +349,11 @@ void LoggerManager::Destory() {
     return;
   }
   log_cycle_delete_enable_.store(false);
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    cond_ = true;
-    cv_.notify_one();
-  }
-
-  if (cycle_delete_thread_) {
-    cycle_delete_thread_->join();
-    cycle_delete_thread_ = nullptr;
+  std::shared_ptr<IOLoop> loop = loop_.lock();
+  if (loop && cycle_delete_timer_id_ != 0) {
+    loop->RemoveTimer(cycle_delete_timer_id_);
   }
+  cycle_delete_timer_id_ = 0;
 
   for (auto it = handlers_.begin(); it != handlers_.end(); ++it) {
     it->second->Destory();
@@ -28,7 +28,6 @@
 #include <functional>
 #include <memory>
 #include <mutex>
-#include <condition_variable>
 
 #include "livox_lidar_def.h"
 #include "livox_lidar_api.h"
@@ -102,10 +101,8 @@ private:
 
   std::unique_ptr<CommPort> comm_port_;
 
-  std::shared_ptr<std::thread> cycle_delete_thread_;
-  bool cond_;
-  std::mutex mutex_;
-  std::condition_variable cv_;
+  std::weak_ptr<IOLoop> loop_;
+  uint64_t cycle_delete_timer_id_;
 
   std::map<uint32_t, LidarDeviceInfo> devices_info_;
   std::map<uint32_t, std::shared_ptr<LoggerHandler>> handlers_;
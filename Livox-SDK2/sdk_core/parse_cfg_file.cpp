@@ -23,7 +23,9 @@
 //
 #include "parse_cfg_file.h"
 #include "base/logging.h"
+#include "base/network/network_util.h"
 
+#include <algorithm>
 #include <map>
 #include <string>
 
@@ -35,6 +37,29 @@ const std::map<std::string, LivoxLidarDeviceType> dev_type_map = {
   {"MID360",  kLivoxLidarTypeMid360}
 };
 
+const std::map<std::string, LivoxLidarSocketRole> socket_role_map = {
+  {"point",   kLivoxLidarSocketPoint},
+  {"imu",     kLivoxLidarSocketImu},
+  {"cmd",     kLivoxLidarSocketCmd},
+  {"push",    kLivoxLidarSocketPush},
+  {"log",     kLivoxLidarSocketLog},
+  {"debug",   kLivoxLidarSocketDebug}
+};
+
+// SO_RCVBUF of each socket role in bytes with the embedded profile.
+static const uint32_t kEmbeddedSocketRecvBufferSize[kLivoxLidarSocketRoleNum] = {
+  4 * 1024 * 1024,    // point
+  128 * 1024,         // imu
+  64 * 1024,          // cmd
+  64 * 1024,          // push
+  256 * 1024,         // log
+  1024 * 1024         // debug
+};
+static const uint32_t kEmbeddedMaxRecvBatchSize = 8;
+static const uint32_t kEmbeddedMaxPacketRingSize = 4 * 1024 * 1024;
+static const uint32_t kEmbeddedMaxXdpFrameNum = 1024;
+static const uint32_t kEmbeddedMaxPacketHandleNum = 16;
+
 
 ParseCfgFile::ParseCfgFile(const std::string& path) : path_(path) {}
 
@@ -83,6 +108,13 @@ bool ParseCfgFile::Parse(std::shared_ptr<std::vector<LivoxLidarCfg>>& lidars_cfg
     sdk_framework_cfg_ptr->master_sdk = true;
   }
 
+  if (!ParseSdkFrameworkCfg(doc, *sdk_framework_cfg_ptr)) {
+    if (raw_file) {
+      std::fclose(raw_file);
+    }
+    return false;
+  }
+
   if (doc.HasMember("lidar_log_enable")) {
     if (doc["lidar_log_enable"].IsBool()) {
       lidar_logger_cfg_ptr->lidar_log_enable = doc["lidar_log_enable"].GetBool();
@@ -361,5 +393,381 @@ bool ParseCfgFile::ParseGeneralCfgInfo(const rapidjson::Value &object, GeneralCf
   return true;
 }
 
+bool ParseCfgFile::ParseSdkFrameworkCfg(const rapidjson::Value &object, LivoxLidarSdkFrameworkCfg& sdk_framework_cfg) {
+  sdk_framework_cfg.embedded_profile = false;
+  if (object.HasMember("sdk_profile")) {
+    if (!object["sdk_profile"].IsString()) {
+      LOG_ERROR("sdk_profile data type is error, it should be a string");
+      return false;
+    }
+    std::string sdk_profile = object["sdk_profile"].GetString();
+    if (sdk_profile == "embedded") {
+      sdk_framework_cfg.embedded_profile = true;
+    } else if (sdk_profile != "default") {
+      LOG_ERROR("sdk_profile {} is unknown, it should be default or embedded", sdk_profile);
+      return false;
+    }
+    LOG_INFO("sdk_profile:{}", sdk_profile);
+  }
+
+  sdk_framework_cfg.recv_batch_size = 1;
+  if (object.HasMember("recv_batch_size")) {
+    if (!object["recv_batch_size"].IsUint() || object["recv_batch_size"].GetUint() == 0) {
+      LOG_ERROR("recv_batch_size data type is error, it should be a positive uint");
+      return false;
+    }
+    uint32_t recv_batch_size = object["recv_batch_size"].GetUint();
+    if (recv_batch_size > static_cast<uint32_t>(util::kMaxRecvMsgNum)) {
+      LOG_WARN("recv_batch_size {} is too large, limit it to {}", recv_batch_size, util::kMaxRecvMsgNum);
+      recv_batch_size = util::kMaxRecvMsgNum;
+    }
+    sdk_framework_cfg.recv_batch_size = recv_batch_size;
+    LOG_INFO("set recv batch size to {}", recv_batch_size);
+  }
+
+  sdk_framework_cfg.data_io_thread_num = 1;
+  if (object.HasMember("data_io_thread_num")) {
+    if (!object["data_io_thread_num"].IsUint() || object["data_io_thread_num"].GetUint() == 0) {
+      LOG_ERROR("data_io_thread_num data type is error, it should be a positive uint");
+      return false;
+    }
+    uint32_t data_io_thread_num = object["data_io_thread_num"].GetUint();
+    if (data_io_thread_num > kMaxDataIOThreadNum) {
+      LOG_WARN("data_io_thread_num {} is too large, limit it to {}", data_io_thread_num, kMaxDataIOThreadNum);
+      data_io_thread_num = kMaxDataIOThreadNum;
+    }
+    sdk_framework_cfg.data_io_thread_num = data_io_thread_num;
+    LOG_INFO("set data io thread num to {}", data_io_thread_num);
+  }
+
+  sdk_framework_cfg.data_io_thread_cpus.clear();
+  if (object.HasMember("data_io_thread_cpus")) {
+    if (!object["data_io_thread_cpus"].IsArray()) {
+      LOG_ERROR("data_io_thread_cpus data type is error, it should be an array of int");
+      return false;
+    }
+    const rapidjson::Value &cpus = object["data_io_thread_cpus"];
+    for (rapidjson::SizeType i = 0; i < cpus.Size(); ++i) {
+      if (!cpus[i].IsInt()) {
+        LOG_ERROR("data_io_thread_cpus data type is error, it should be an array of int");
+        return false;
+      }
+      sdk_framework_cfg.data_io_thread_cpus.push_back(cpus[i].GetInt());
+    }
+  }
+
+  sdk_framework_cfg.lidar_data_io_thread.clear();
+  if (object.HasMember("lidar_data_io_thread")) {
+    if (!object["lidar_data_io_thread"].IsObject()) {
+      LOG_ERROR("lidar_data_io_thread data type is error, it should be an object of lidar ip and thread index");
+      return false;
+    }
+    const rapidjson::Value &lidar_thread = object["lidar_data_io_thread"];
+    for (auto it = lidar_thread.MemberBegin(); it != lidar_thread.MemberEnd(); ++it) {
+      if (!it->value.IsUint() || it->value.GetUint() >= sdk_framework_cfg.data_io_thread_num) {
+        LOG_ERROR("lidar_data_io_thread of lidar {} is error, it should be less than data_io_thread_num",
+            it->name.GetString());
+        return false;
+      }
+      sdk_framework_cfg.lidar_data_io_thread[it->name.GetString()] = it->value.GetUint();
+    }
+  }
+
+  sdk_framework_cfg.data_reuseport_enable = false;
+  if (object.HasMember("data_reuseport_enable")) {
+    if (!object["data_reuseport_enable"].IsBool()) {
+      LOG_ERROR("data_reuseport_enable data type is error, it should be a bool");
+      return false;
+    }
+    sdk_framework_cfg.data_reuseport_enable = object["data_reuseport_enable"].GetBool();
+    LOG_INFO("set data reuseport enable to {}", sdk_framework_cfg.data_reuseport_enable);
+  }
+
+  sdk_framework_cfg.packet_ring_enable = false;
+  sdk_framework_cfg.packet_ring_netif = "";
+  sdk_framework_cfg.packet_ring_block_size = 1024 * 1024;
+  sdk_framework_cfg.packet_ring_block_num = 16;
+  sdk_framework_cfg.packet_ring_block_timeout_ms = 2;
+  if (object.HasMember("packet_ring")) {
+    const rapidjson::Value &packet_ring = object["packet_ring"];
+    if (!packet_ring.IsObject()) {
+      LOG_ERROR("packet_ring data type is error, it should be an object");
+      return false;
+    }
+    if (packet_ring.HasMember("netif")) {
+      if (!packet_ring["netif"].IsString()) {
+        LOG_ERROR("packet_ring netif data type is error, it should be a string");
+        return false;
+      }
+      sdk_framework_cfg.packet_ring_netif = packet_ring["netif"].GetString();
+    }
+    if (packet_ring.HasMember("block_size_KB")) {
+      if (!packet_ring["block_size_KB"].IsUint() || packet_ring["block_size_KB"].GetUint() == 0 ||
+          packet_ring["block_size_KB"].GetUint() % 4 != 0) {
+        LOG_ERROR("packet_ring block_size_KB is error, it should be a positive multiple of 4");
+        return false;
+      }
+      sdk_framework_cfg.packet_ring_block_size = packet_ring["block_size_KB"].GetUint() * 1024;
+    }
+    if (packet_ring.HasMember("block_num")) {
+      if (!packet_ring["block_num"].IsUint() || packet_ring["block_num"].GetUint() == 0) {
+        LOG_ERROR("packet_ring block_num is error, it should be a positive uint");
+        return false;
+      }
+      sdk_framework_cfg.packet_ring_block_num = packet_ring["block_num"].GetUint();
+    }
+    if (packet_ring.HasMember("block_timeout_ms")) {
+      if (!packet_ring["block_timeout_ms"].IsUint() || packet_ring["block_timeout_ms"].GetUint() == 0) {
+        LOG_ERROR("packet_ring block_timeout_ms is error, it should be a positive uint");
+        return false;
+      }
+      sdk_framework_cfg.packet_ring_block_timeout_ms = packet_ring["block_timeout_ms"].GetUint();
+    }
+    sdk_framework_cfg.packet_ring_enable = true;
+    LOG_INFO("enable packet ring, netif:{}, block_size:{}, block_num:{}, block_timeout_ms:{}",
+        sdk_framework_cfg.packet_ring_netif, sdk_framework_cfg.packet_ring_block_size,
+        sdk_framework_cfg.packet_ring_block_num, sdk_framework_cfg.packet_ring_block_timeout_ms);
+  }
+
+  sdk_framework_cfg.xdp_enable = false;
+  sdk_framework_cfg.xdp_netif = "";
+  sdk_framework_cfg.xdp_queues.clear();
+  sdk_framework_cfg.xdp_frame_num = 4096;
+  if (object.HasMember("xdp")) {
+    const rapidjson::Value &xdp = object["xdp"];
+    if (!xdp.IsObject()) {
+      LOG_ERROR("xdp data type is error, it should be an object");
+      return false;
+    }
+    if (!xdp.HasMember("netif") || !xdp["netif"].IsString()) {
+      LOG_ERROR("xdp netif is missing or its data type is error, it should be a string");
+      return false;
+    }
+    sdk_framework_cfg.xdp_netif = xdp["netif"].GetString();
+    if (xdp.HasMember("queues")) {
+      const rapidjson::Value &queues = xdp["queues"];
+      if (!queues.IsArray() || queues.Size() == 0) {
+        LOG_ERROR("xdp queues data type is error, it should be a non-empty array");
+        return false;
+      }
+      for (rapidjson::SizeType i = 0; i < queues.Size(); ++i) {
+        if (!queues[i].IsUint()) {
+          LOG_ERROR("xdp queues data type is error, the element should be a uint");
+          return false;
+        }
+        sdk_framework_cfg.xdp_queues.push_back(queues[i].GetUint());
+      }
+    } else {
+      sdk_framework_cfg.xdp_queues.push_back(0);
+    }
+    if (xdp.HasMember("frame_num")) {
+      if (!xdp["frame_num"].IsUint() || xdp["frame_num"].GetUint() == 0) {
+        LOG_ERROR("xdp frame_num is error, it should be a positive uint");
+        return false;
+      }
+      sdk_framework_cfg.xdp_frame_num = xdp["frame_num"].GetUint();
+    }
+    sdk_framework_cfg.xdp_enable = true;
+    LOG_INFO("enable xdp, netif:{}, queue num:{}, frame_num:{}", sdk_framework_cfg.xdp_netif,
+        sdk_framework_cfg.xdp_queues.size(), sdk_framework_cfg.xdp_frame_num);
+  }
+
+  sdk_framework_cfg.io_uring_enable = false;
+  if (object.HasMember("io_backend")) {
+    if (!object["io_backend"].IsString()) {
+      LOG_ERROR("io_backend data type is error, it should be a string");
+      return false;
+    }
+    std::string io_backend = object["io_backend"].GetString();
+    if (io_backend == "io_uring") {
+      sdk_framework_cfg.io_uring_enable = true;
+    } else if (io_backend != "default") {
+      LOG_ERROR("io_backend {} is unknown, it should be default or io_uring", io_backend);
+      return false;
+    }
+    LOG_INFO("io_backend:{}", io_backend);
+  }
+
+  sdk_framework_cfg.data_edge_triggered_enable = false;
+  if (object.HasMember("data_edge_triggered_enable")) {
+    if (!object["data_edge_triggered_enable"].IsBool()) {
+      LOG_ERROR("data_edge_triggered_enable data type is error, it should be a bool");
+      return false;
+    }
+    sdk_framework_cfg.data_edge_triggered_enable = object["data_edge_triggered_enable"].GetBool();
+    LOG_INFO("data_edge_triggered_enable:{}", sdk_framework_cfg.data_edge_triggered_enable);
+  }
+
+  sdk_framework_cfg.data_drain_budget = 256;
+  if (object.HasMember("data_drain_budget")) {
+    if (!object["data_drain_budget"].IsUint() || object["data_drain_budget"].GetUint() == 0 ||
+        object["data_drain_budget"].GetUint() > 65536) {
+      LOG_ERROR("data_drain_budget is error, it should be in [1, 65536]");
+      return false;
+    }
+    sdk_framework_cfg.data_drain_budget = object["data_drain_budget"].GetUint();
+    LOG_INFO("set data drain budget to {}", sdk_framework_cfg.data_drain_budget);
+  }
+
+  sdk_framework_cfg.udp_gro_enable = false;
+  if (object.HasMember("udp_gro_enable")) {
+    if (!object["udp_gro_enable"].IsBool()) {
+      LOG_ERROR("udp_gro_enable data type is error, it should be a bool");
+      return false;
+    }
+    sdk_framework_cfg.udp_gro_enable = object["udp_gro_enable"].GetBool();
+    LOG_INFO("udp_gro_enable:{}", sdk_framework_cfg.udp_gro_enable);
+  }
+
+  sdk_framework_cfg.rx_timestamp_enable = false;
+  if (object.HasMember("rx_timestamp_enable")) {
+    if (!object["rx_timestamp_enable"].IsBool()) {
+      LOG_ERROR("rx_timestamp_enable data type is error, it should be a bool");
+      return false;
+    }
+    sdk_framework_cfg.rx_timestamp_enable = object["rx_timestamp_enable"].GetBool();
+    LOG_INFO("rx_timestamp_enable:{}", sdk_framework_cfg.rx_timestamp_enable);
+  }
+
+  sdk_framework_cfg.busy_poll_enable = false;
+  sdk_framework_cfg.busy_poll_idle_us = 1000;
+  sdk_framework_cfg.socket_busy_poll_us = 0;
+  if (object.HasMember("busy_poll")) {
+    const rapidjson::Value &busy_poll = object["busy_poll"];
+    if (!busy_poll.IsObject()) {
+      LOG_ERROR("busy_poll data type is error, it should be an object");
+      return false;
+    }
+    if (busy_poll.HasMember("idle_us")) {
+      if (!busy_poll["idle_us"].IsUint()) {
+        LOG_ERROR("busy_poll idle_us data type is error, it should be a uint");
+        return false;
+      }
+      sdk_framework_cfg.busy_poll_idle_us = busy_poll["idle_us"].GetUint();
+    }
+    if (busy_poll.HasMember("socket_busy_poll_us")) {
+      if (!busy_poll["socket_busy_poll_us"].IsUint()) {
+        LOG_ERROR("busy_poll socket_busy_poll_us data type is error, it should be a uint");
+        return false;
+      }
+      sdk_framework_cfg.socket_busy_poll_us = busy_poll["socket_busy_poll_us"].GetUint();
+    }
+    sdk_framework_cfg.busy_poll_enable = true;
+    LOG_INFO("enable busy poll, idle_us:{}, socket_busy_poll_us:{}", sdk_framework_cfg.busy_poll_idle_us,
+        sdk_framework_cfg.socket_busy_poll_us);
+  }
+
+  sdk_framework_cfg.imu_io_thread_enable = false;
+  sdk_framework_cfg.imu_io_thread_cpu = -1;
+  sdk_framework_cfg.imu_io_thread_priority = 0;
+  if (object.HasMember("imu_io_thread")) {
+    const rapidjson::Value &imu_io_thread = object["imu_io_thread"];
+    if (!imu_io_thread.IsObject()) {
+      LOG_ERROR("imu_io_thread data type is error, it should be an object");
+      return false;
+    }
+    if (imu_io_thread.HasMember("cpu")) {
+      if (!imu_io_thread["cpu"].IsInt()) {
+        LOG_ERROR("imu_io_thread cpu data type is error, it should be an int");
+        return false;
+      }
+      sdk_framework_cfg.imu_io_thread_cpu = imu_io_thread["cpu"].GetInt();
+    }
+    if (imu_io_thread.HasMember("priority")) {
+      if (!imu_io_thread["priority"].IsUint() || imu_io_thread["priority"].GetUint() > 99) {
+        LOG_ERROR("imu_io_thread priority is error, it should be a uint in [0, 99]");
+        return false;
+      }
+      sdk_framework_cfg.imu_io_thread_priority = imu_io_thread["priority"].GetUint();
+    }
+    sdk_framework_cfg.imu_io_thread_enable = true;
+    LOG_INFO("enable imu io thread, cpu:{}, priority:{}", sdk_framework_cfg.imu_io_thread_cpu,
+        sdk_framework_cfg.imu_io_thread_priority);
+  }
+
+  sdk_framework_cfg.packet_handle_num = kDefaultPacketHandleNum;
+  if (object.HasMember("packet_handle_num")) {
+    if (!object["packet_handle_num"].IsUint()) {
+      LOG_ERROR("packet_handle_num data type is error, it should be a uint");
+      return false;
+    }
+    sdk_framework_cfg.packet_handle_num = object["packet_handle_num"].GetUint();
+    LOG_INFO("set packet handle num to {}", sdk_framework_cfg.packet_handle_num);
+  }
+
+  sdk_framework_cfg.data_poll_enable = false;
+  if (object.HasMember("data_poll_enable")) {
+    if (!object["data_poll_enable"].IsBool()) {
+      LOG_ERROR("data_poll_enable data type is error, it should be a bool");
+      return false;
+    }
+    sdk_framework_cfg.data_poll_enable = object["data_poll_enable"].GetBool();
+    LOG_INFO("data_poll_enable:{}", sdk_framework_cfg.data_poll_enable);
+  }
+
+  if (!ParseSocketRecvBufferCfg(object, sdk_framework_cfg)) {
+    return false;
+  }
+
+  if (sdk_framework_cfg.embedded_profile) {
+    ApplyEmbeddedProfile(sdk_framework_cfg);
+  }
+  return true;
+}
+
+bool ParseCfgFile::ParseSocketRecvBufferCfg(const rapidjson::Value &object, LivoxLidarSdkFrameworkCfg& sdk_framework_cfg) {
+  const uint32_t* recv_buffer_size = sdk_framework_cfg.embedded_profile ?
+      kEmbeddedSocketRecvBufferSize : kDefaultSocketRecvBufferSize;
+  for (int i = 0; i < kLivoxLidarSocketRoleNum; ++i) {
+    sdk_framework_cfg.socket_rcvbuf[i] = recv_buffer_size[i];
+  }
+  if (!object.HasMember("socket_rcvbuf_KB")) {
+    return true;
+  }
+
+  const rapidjson::Value &socket_rcvbuf = object["socket_rcvbuf_KB"];
+  if (!socket_rcvbuf.IsObject()) {
+    LOG_ERROR("socket_rcvbuf_KB data type is error, it should be an object");
+    return false;
+  }
+  for (auto it = socket_rcvbuf.MemberBegin(); it != socket_rcvbuf.MemberEnd(); ++it) {
+    std::string role_name = it->name.GetString();
+    auto role = socket_role_map.find(role_name);
+    if (role == socket_role_map.end()) {
+      LOG_ERROR("socket_rcvbuf_KB role {} is unknown, it should be point, imu, cmd, push, log or debug", role_name);
+      return false;
+    }
+    // 0 keeps the kernel default, the sizes are sent to the kernel as an int.
+    if (!it->value.IsUint() || it->value.GetUint() > INT32_MAX / 1024) {
+      LOG_ERROR("socket_rcvbuf_KB {} is error, it should be a uint below 2 GB", role_name);
+      return false;
+    }
+    sdk_framework_cfg.socket_rcvbuf[role->second] = it->value.GetUint() * 1024;
+    LOG_INFO("set {} socket rcvbuf to {} KB", role_name, it->value.GetUint());
+  }
+  return true;
+}
+
+void ParseCfgFile::ApplyEmbeddedProfile(LivoxLidarSdkFrameworkCfg& sdk_framework_cfg) {
+  // One data io thread, which also takes the imu data, with a small receive pool, no 64 KB gro
+  // slots and no spinning core.
+  sdk_framework_cfg.data_io_thread_num = 1;
+  sdk_framework_cfg.imu_io_thread_enable = false;
+  sdk_framework_cfg.recv_batch_size = std::min(sdk_framework_cfg.recv_batch_size, kEmbeddedMaxRecvBatchSize);
+  sdk_framework_cfg.udp_gro_enable = false;
+  sdk_framework_cfg.busy_poll_enable = false;
+  sdk_framework_cfg.socket_busy_poll_us = 0;
+  if (static_cast<uint64_t>(sdk_framework_cfg.packet_ring_block_size) * sdk_framework_cfg.packet_ring_block_num >
+      kEmbeddedMaxPacketRingSize) {
+    sdk_framework_cfg.packet_ring_block_num = std::max<uint32_t>(1,
+        kEmbeddedMaxPacketRingSize / sdk_framework_cfg.packet_ring_block_size);
+  }
+  sdk_framework_cfg.xdp_frame_num = std::min(sdk_framework_cfg.xdp_frame_num, kEmbeddedMaxXdpFrameNum);
+  sdk_framework_cfg.packet_handle_num = std::min(sdk_framework_cfg.packet_handle_num, kEmbeddedMaxPacketHandleNum);
+  LOG_INFO("embedded profile, recv_batch_size:{}, packet ring blocks:{}, xdp frames:{}, packet handles:{}",
+      sdk_framework_cfg.recv_batch_size, sdk_framework_cfg.packet_ring_block_num, sdk_framework_cfg.xdp_frame_num,
+      sdk_framework_cfg.packet_handle_num);
+}
+
 } // namespace lidar
 } // namespace livox
@@ -65,6 +65,9 @@ class ParseCfgFile {
   bool ParseLidarNetInfo(const rapidjson::Value &object, LivoxLidarNetInfo& lidar_net_info);
   bool ParseHostNetInfo(const rapidjson::Value &host_net_info_object, HostNetInfo& host_net_info);
   bool ParseGeneralCfgInfo(const rapidjson::Value &object, GeneralCfgInfo& general_cfg_info);
+  bool ParseSdkFrameworkCfg(const rapidjson::Value &object, LivoxLidarSdkFrameworkCfg& sdk_framework_cfg);
+  bool ParseSocketRecvBufferCfg(const rapidjson::Value &object, LivoxLidarSdkFrameworkCfg& sdk_framework_cfg);
+  void ApplyEmbeddedProfile(LivoxLidarSdkFrameworkCfg& sdk_framework_cfg);
  private:
   const std::string path_;
 };
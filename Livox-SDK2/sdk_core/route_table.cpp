@@ -0,0 +1,60 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "route_table.h"
+
+namespace livox {
+namespace lidar {
+
+RouteTable::RouteTable(size_t entry_num) : mask_(0), entries_() {
+  // Keep the load factor at most 1/2 so a miss ends after a few probes.
+  size_t capacity = 16;
+  while (capacity < entry_num * 2) {
+    capacity <<= 1;
+  }
+  mask_ = capacity - 1;
+  entries_.resize(capacity, RouteEntry{0, kRouteNone, 0});
+}
+
+void RouteTable::Insert(uint32_t handle, uint16_t port, RouteDest dest, uint8_t dev_type) {
+  if (handle == 0 || port == 0) {
+    return;
+  }
+  uint64_t key = MakeKey(handle, port);
+  for (size_t i = Hash(key); ; i = (i + 1) & mask_) {
+    RouteEntry& entry = entries_[i];
+    if (entry.key == key) {
+      return;
+    }
+    if (entry.key == 0) {
+      entry.key = key;
+      entry.dest = dest;
+      entry.dev_type = dev_type;
+      return;
+    }
+  }
+}
+
+} // namespace lidar
+} // namespace livox
@@ -0,0 +1,85 @@
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Livox. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef LIVOX_ROUTE_TABLE_H_
+#define LIVOX_ROUTE_TABLE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace livox {
+namespace lidar {
+
+typedef enum {
+  kRouteNone = 0,
+  kRouteData,
+  kRouteCommand
+} RouteDest;
+
+typedef struct {
+  uint64_t key;
+  uint8_t dest;
+  uint8_t dev_type;
+} RouteEntry;
+
+/**
+ * Open addressing table which maps the source (ip, port) of a datagram to its handler.
+ * A table is immutable once published, a new one is built when a lidar is added.
+ */
+class RouteTable {
+ public:
+  explicit RouteTable(size_t entry_num);
+  /** Keeps the first route of a (handle, port). Port 0 is ignored. */
+  void Insert(uint32_t handle, uint16_t port, RouteDest dest, uint8_t dev_type);
+
+  const RouteEntry* Find(uint32_t handle, uint16_t port) const {
+    uint64_t key = MakeKey(handle, port);
+    for (size_t i = Hash(key); ; i = (i + 1) & mask_) {
+      const RouteEntry& entry = entries_[i];
+      if (entry.key == key) {
+        return &entry;
+      }
+      if (entry.key == 0) {
+        return nullptr;
+      }
+    }
+  }
+
+ private:
+  static uint64_t MakeKey(uint32_t handle, uint16_t port) {
+    return (static_cast<uint64_t>(handle) << 16) | port;
+  }
+  size_t Hash(uint64_t key) const {
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask_;
+  }
+
+  size_t mask_;
+  std::vector<RouteEntry> entries_;
+};
+
+} // namespace lidar
+} // namespace livox
+
+#endif // LIVOX_ROUTE_TABLE_H_
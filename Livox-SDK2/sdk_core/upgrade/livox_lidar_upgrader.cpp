@@ -24,12 +24,16 @@
 
 #include "livox_lidar_upgrader.h"
 #include "../command_handler/command_impl.h"
+#include "../device_manager.h"
 
 #include <string.h>
 
 namespace livox {
 namespace lidar {
 
+static const uint32_t kXferFirmwareInterval = 5;  // ms
+static const uint32_t kEraseFirmwareWaitTime = 1000;  // ms
+
 typedef int32_t (LivoxLidarUpgrader::*FnFsmEvent)();
 
 typedef struct {
@@ -59,23 +63,34 @@ LivoxLidarUpgrader::LivoxLidarUpgrader(const Firmware& firmware, const uint32_t
       upgrade_error_(0), progress_(0), try_count_(0) {}
 
 LivoxLidarUpgrader::~LivoxLidarUpgrader() {
-  while (true) {
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  std::set<uint64_t> timer_ids;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    state_cv_.wait(lock, [this]() { return IsUpgradeError() || IsUpgradeComplete(); });
     if (IsUpgradeError()) {
       printf("LivoxLidar lidar[%u] upgrade error, try again please!\r\n", handle_);
-      break;
+    } else {
+      printf("LivoxLidar lidar[%u] upgrade successfully.\r\n", handle_);
     }
+    timer_ids.swap(timer_ids_);
+  }
 
-    if (IsUpgradeComplete()) {
-      printf("LivoxLidar lidar[%u] upgrade successfully.\r\n", handle_);
-      break;
+  // A timer still pending would run the fsm of a freed upgrader. RemoveTimer waits for a
+  // running one, which takes mutex_, so it is called without the lock.
+  std::shared_ptr<IOLoop> loop = DeviceManager::GetInstance().GetControlLoop();
+  if (loop) {
+    for (uint64_t timer_id : timer_ids) {
+      loop->RemoveTimer(timer_id);
     }
   }
+}
 
-  if (upgrade_thread_ && upgrade_thread_->joinable()) {
-    upgrade_thread_->join();
-    upgrade_thread_ = nullptr;
+void LivoxLidarUpgrader::SetFsmState(uint32_t state) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fsm_state_ = state;
   }
+  state_cv_.notify_all();
 }
 
 
@@ -85,12 +100,37 @@ void LivoxLidarUpgrader::AddUpgradeProgressObserver(UpgradeProgressCallback obse
 }
 
 bool LivoxLidarUpgrader::StartUpgradeLivoxLidar() {
-  upgrade_thread_ = std::make_shared<std::thread>([this](){
-      this->FsmEventHandler(kLivoxLidarEventRequestUpgrade, 10);
+  std::shared_ptr<IOLoop> loop = DeviceManager::GetInstance().GetControlLoop();
+  if (!loop) {
+    printf("Start upgrade failed, the livox_lidar[%u] sdk is not initialized.\r\n", handle_);
+    SetFsmState(kLivoxLidarUpgradeErr);
+    return false;
+  }
+  loop->PostTask([this]() {
+    this->FsmEventHandler(kLivoxLidarEventRequestUpgrade, 10);
   });
   return true;
 }
 
+void LivoxLidarUpgrader::RunLater(uint32_t delay_ms, const std::function<void()>& task) {
+  std::shared_ptr<IOLoop> loop = DeviceManager::GetInstance().GetControlLoop();
+  if (!loop) {
+    printf("The livox_lidar[%u] upgrade is aborted, the sdk is uninitialized.\r\n", handle_);
+    SetFsmState(kLivoxLidarUpgradeErr);
+    return;
+  }
+  std::shared_ptr<uint64_t> timer_id = std::make_shared<uint64_t>(0);
+  std::lock_guard<std::mutex> lock(mutex_);
+  *timer_id = loop->AddTimer(delay_ms, 0, [this, task, timer_id](TimePoint) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      timer_ids_.erase(*timer_id);
+    }
+    task();
+  });
+  timer_ids_.insert(*timer_id);
+}
+
 void LivoxLidarUpgrader::FsmEventHandler(LivoxLidarFsmEvent event, uint8_t progress) {
   FnFsmEvent event_handler = nullptr;
   if ((event == kLivoxLidarEventTimeout) || (event == kLivoxLidarEventErr)) {
@@ -100,7 +140,7 @@ void LivoxLidarUpgrader::FsmEventHandler(LivoxLidarFsmEvent event, uint8_t progr
   for (uint32_t i = 0; i < sizeof(upgrade_event_table) / sizeof(upgrade_event_table[0]); i++) {
     if ((fsm_state_ == upgrade_event_table[i].state) && (event == upgrade_event_table[i].event)) {
       event_handler = upgrade_event_table[i].event_handler;
-      fsm_state_ = upgrade_event_table[i].next_state;
+      SetFsmState(upgrade_event_table[i].next_state);
       printf("Fsm event handler, the livox_lidar[%u] New State[%d] | Event[%d]\r\n", handle_, fsm_state_, event);
       break;
     }
@@ -142,27 +182,33 @@ livox_status LivoxLidarUpgrader::StartUpgrade() {
 }
 
 livox_status LivoxLidarUpgrader::XferFirmware() {
-  uint8_t send_bufer[2048];
-  LivoxLidarXferFirmwareResquest* request = (LivoxLidarXferFirmwareResquest*)send_bufer;
   uint32_t firmware_length = firmware_.header_.firmware_length;
-  uint32_t read_length = read_length_;
-
-  if (read_offset_ < firmware_length) {
-    if (read_length > (firmware_length - read_offset_)) {
-      read_length = firmware_length - read_offset_;
-    }
-  } else {
+  if (read_offset_ >= firmware_length) {
     printf("The livox_lidar[%u] xfer firmware failed, Read_offset is err, firmware_length[%d], read_offset[%d].\r\n",
         handle_, firmware_length, read_offset_);
     return -1;
   }
+  // Pace the chunks, the next one is sent from a timer of the control loop.
+  RunLater(kXferFirmwareInterval, [this]() {
+    SendFirmwareChunk();
+  });
+  return kLivoxLidarStatusSuccess;
+}
+
+livox_status LivoxLidarUpgrader::SendFirmwareChunk() {
+  uint8_t send_bufer[2048];
+  LivoxLidarXferFirmwareResquest* request = (LivoxLidarXferFirmwareResquest*)send_bufer;
+  uint32_t firmware_length = firmware_.header_.firmware_length;
+  uint32_t read_length = read_length_;
+  if (read_length > (firmware_length - read_offset_)) {
+    read_length = firmware_length - read_offset_;
+  }
 
   memcpy(request->data, &firmware_.data_[read_offset_], read_length);
   request->offset = read_offset_;
   request->length = read_length;
   request->encrypt_type = firmware_.header_.encrypt_type;
   // read_offset_ += read_length;
-  std::this_thread::sleep_for(std::chrono::milliseconds(5));
 
   printf("The livox_lidar[%u] xfer firmware read offset %d\r\n", handle_, request->offset);
 
@@ -195,7 +241,7 @@ livox_status LivoxLidarUpgrader::UpgradeComplete() {
 
 int32_t LivoxLidarUpgrader::LivoxLidarFsmStateChange(LivoxLidarFsmEvent event) {
   if (event < kLivoxLidarEventUndef) {
-    fsm_state_ = event;
+    SetFsmState(event);
   }
   return 0;
 }
@@ -215,9 +261,10 @@ void LivoxLidarUpgrader::StartUpgradeResponseHandler(livox_status status, uint32
         printf("Start upgrade failed, the livox_lidar[%u] is busy, try again!\r\n", handle);
         upgrade->FsmEventHandler(kLivoxLidarEventRequestUpgrade, 10);
       } else if (response->ret_code == EraseFirmware) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        printf("Start upgrade, erase livox_lidar[%u] firmware!\r\n", handle);
-        upgrade->FsmEventHandler(kLivoxLidarEventRequestUpgrade, 10);
+        upgrade->RunLater(kEraseFirmwareWaitTime, [upgrade, handle]() {
+          printf("Start upgrade, erase livox_lidar[%u] firmware!\r\n", handle);
+          upgrade->FsmEventHandler(kLivoxLidarEventRequestUpgrade, 10);
+        });
       } else {
         printf("Start upgrade failed, the livox_lidar[%u] ret_code[%d], try again!\r\n", handle, response->ret_code);
         upgrade->FsmEventHandler(kLivoxLidarEventErr, 100);
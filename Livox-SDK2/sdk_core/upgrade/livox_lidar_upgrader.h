@@ -25,11 +25,13 @@
 #ifndef LIVOX_LIDAR_UPGRADER_H_
 #define LIVOX_LIDAR_UPGRADER_H_
 
+#include <condition_variable>
 #include <fstream>
 #include <ios>
 #include <memory>
-#include <thread>
+#include <mutex>
 #include <functional>
+#include <set>
 
 #include "firmware.h"
 #include "../comm/define.h"
@@ -45,13 +47,17 @@ class LivoxLidarUpgrader {
   using UpgradeProgressCallback = std::function<void(uint32_t handle, LivoxLidarUpgradeState state)>;
 
   LivoxLidarUpgrader(const Firmware& firmware, const uint32_t handle);
+  /** Waits until the upgrade completes or fails, then removes the timers still pending. */
   ~LivoxLidarUpgrader();
+  LivoxLidarUpgrader(const LivoxLidarUpgrader&) = delete;
+  LivoxLidarUpgrader& operator=(const LivoxLidarUpgrader&) = delete;
 
   void AddUpgradeProgressObserver(UpgradeProgressCallback observer);
   bool StartUpgradeLivoxLidar();
 
   livox_status StartUpgrade();
   livox_status XferFirmware();
+  livox_status SendFirmwareChunk();
   livox_status CompleteXferFirmware();
   livox_status GetUpgradeProgress();
   livox_status UpgradeComplete();
@@ -74,6 +80,10 @@ class LivoxLidarUpgrader {
   bool IsUpgradeError() { return (fsm_state_ == kLivoxLidarUpgradeTimeout) || (fsm_state_ == kLivoxLidarUpgradeErr); }
 
  private:
+  /** Run the fsm on the control loop after delay_ms, the loop is never blocked by a sleep. */
+  void RunLater(uint32_t delay_ms, const std::function<void()>& task);
+  void SetFsmState(uint32_t state);
+
   const Firmware& firmware_;
   uint32_t read_offset_;
   uint32_t read_length_;
@@ -84,9 +94,13 @@ class LivoxLidarUpgrader {
   uint8_t progress_;
 
   uint32_t try_count_;
-  std::shared_ptr<std::thread> upgrade_thread_;
   UpgradeProgressCallback observer_;
 
+  // Guards the writes of fsm_state_ read by the destructor and the ids of the pending timers.
+  std::mutex mutex_;
+  std::condition_variable state_cv_;
+  std::set<uint64_t> timer_ids_;
+
 };
 
 } // namespace comm
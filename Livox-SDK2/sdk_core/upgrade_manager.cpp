@@ -51,15 +51,15 @@ void UpgradeManager::SetLivoxLidarUpgradeProgressCallback(OnLivoxLidarUpgradePro
   livox_lidar_client_data_ = client_data;
 }
 
-void UpgradeManager::UpgradeLivoxLidars(const uint32_t* handle, const uint8_t lidar_num) {
-  std::vector<LivoxLidarUpgrader> upgrader_vec;
+void UpgradeManager::UpgradeLivoxLidars(const uint32_t* handle, const uint16_t lidar_num) {
+  std::vector<std::unique_ptr<LivoxLidarUpgrader>> upgrader_vec;
   upgrader_vec.reserve(lidar_num);
   for (size_t i = 0; i < lidar_num; ++i) {   
-    LivoxLidarUpgrader upgrader(livox_lidar_firmware_, handle[i]);
+    std::unique_ptr<LivoxLidarUpgrader> upgrader(new LivoxLidarUpgrader(livox_lidar_firmware_, handle[i]));
 
     OnLivoxLidarUpgradeProgressCallback cb = livox_lidar_info_cb_;
     void* client_data = livox_lidar_client_data_;
-    upgrader.AddUpgradeProgressObserver([cb, client_data](uint32_t handle, LivoxLidarUpgradeState state) {
+    upgrader->AddUpgradeProgressObserver([cb, client_data](uint32_t handle, LivoxLidarUpgradeState state) {
       if (cb) {
         cb(handle, state, client_data);
       }
@@ -69,8 +69,7 @@ void UpgradeManager::UpgradeLivoxLidars(const uint32_t* handle, const uint8_t li
   }
 
   for (size_t i = 0; i < upgrader_vec.size(); ++i) {
-    LivoxLidarUpgrader& upgrader = upgrader_vec[i];
-    upgrader.StartUpgradeLivoxLidar();
+    upgrader_vec[i]->StartUpgradeLivoxLidar();
   }
 
   CloseLivoxLidarFirmwareFile();
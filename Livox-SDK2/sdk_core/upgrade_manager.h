@@ -25,6 +25,7 @@
 #ifndef LIVOX_UPGRADE_MANAGER_H_
 #define LIVOX_UPGRADE_MANAGER_H_
 
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <fstream>
@@ -55,7 +56,7 @@ public:
   // Livox lidar upgrade
   bool SetLivoxLidarUpgradeFirmwarePath(const char* firmware_path);
   void SetLivoxLidarUpgradeProgressCallback(OnLivoxLidarUpgradeProgressCallback cb, void* client_data);
-  void UpgradeLivoxLidars(const uint32_t* handle, const uint8_t lidar_num);
+  void UpgradeLivoxLidars(const uint32_t* handle, const uint16_t lidar_num);
   void CloseLivoxLidarFirmwareFile();
 private:
   Firmware livox_lidar_firmware_;